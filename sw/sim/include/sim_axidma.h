@@ -0,0 +1,49 @@
+/**
+ * @brief  Hooks into the simulated AXI DMA + loopback FIFO that have no
+ *         hardware equivalent. Used by host test code to provoke the error
+ *         paths of the controller.
+ */
+
+#ifndef SIM_AXIDMA_H
+#define SIM_AXIDMA_H
+
+#include "xil_types.h"
+
+/**
+ * Length of one delay timer tick in the simulated engine. The core counts
+ * in multiples of 125 SG clocks, at 100MHz that is 1.25us.
+ */
+#define SIM_AXIDMA_DELAY_TICK_NS 1250U
+
+/**
+ * @brief      Makes the next BD processed on a channel complete with the
+ *             given error bits set, halting the channel like the core does.
+ *
+ * @param[in]  deviceId   AXI DMA device id from xparameters
+ * @param[in]  direction  XAXIDMA_DMA_TO_DEVICE or XAXIDMA_DEVICE_TO_DMA
+ * @param[in]  stsErrMask one of XAXIDMA_BD_STS_*_ERR_MASK
+ */
+void simAxiDma_injectBdError(u32 deviceId, int direction, u32 stsErrMask);
+
+/**
+ * @brief      Like simAxiDma_injectBdError on the MM2S channel, but the error
+ *             lands on the next BD that ends a packet (TXEOF set). A
+ *             completion interrupt is taken before the error interrupt, so
+ *             the driver reaps the failed packet ahead of its recovery.
+ *
+ * @param[in]  deviceId   AXI DMA device id from xparameters
+ * @param[in]  stsErrMask one of XAXIDMA_BD_STS_*_ERR_MASK
+ */
+void simAxiDma_injectTxEofError(u32 deviceId, u32 stsErrMask);
+
+/**
+ * @brief      Loses the next interrupts of a channel the way a missed edge
+ *             would, the status bits are still set. A core reset ends it.
+ *
+ * @param[in]  deviceId   AXI DMA device id from xparameters
+ * @param[in]  direction  XAXIDMA_DMA_TO_DEVICE or XAXIDMA_DEVICE_TO_DMA
+ * @param[in]  count      number of interrupts to swallow
+ */
+void simAxiDma_dropIrqs(u32 deviceId, int direction, u32 count);
+
+#endif // SIM_AXIDMA_H
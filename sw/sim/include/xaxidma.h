@@ -0,0 +1,71 @@
+/**
+ * @brief  Host simulation stand-in for the Xilinx AXI DMA driver (xaxidma.h).
+ *         Only the scatter gather API is provided; simple mode transfers
+ *         are not modelled.
+ */
+
+#ifndef XAXIDMA_H
+#define XAXIDMA_H
+
+#include "xaxidma_hw.h"
+#include "xaxidma_bd.h"
+#include "xaxidma_bdring.h"
+#include "xstatus.h"
+#include "xparameters.h"
+
+#define XAXIDMA_DMA_TO_DEVICE 0x00
+#define XAXIDMA_DEVICE_TO_DMA 0x01
+
+typedef struct XAxiDma {
+	UINTPTR RegBase;          /**< Virtual base address of DMA engine */
+	int HasMm2S;              /**< Has transmit channel */
+	int HasS2Mm;              /**< Has receive channel */
+	int Initialized;          /**< Driver has been initialized */
+	int HasSg;
+	XAxiDma_BdRing TxBdRing;  /**< BD container management for TX channel */
+	XAxiDma_BdRing RxBdRing[1]; /**< BD container management for RX channel */
+	int TxNumChannels;
+	int RxNumChannels;
+	int MicroDmaMode;
+	int AddrWidth;            /**< Address Width */
+} XAxiDma;
+
+typedef struct {
+	u32 DeviceId;
+	UINTPTR BaseAddr;
+	int HasStsCntrlStrm;
+	int HasMm2S;
+	int HasMm2SDRE;
+	int Mm2SDataWidth;
+	int HasS2Mm;
+	int HasS2MmDRE;
+	int S2MmDataWidth;
+	int HasSg;
+	int Mm2sNumChannels;
+	int S2MmNumChannels;
+	int Mm2SBurstSize;
+	int S2MmBurstSize;
+	int MicroDmaMode;
+	int AddrWidth;
+	int SgLengthWidth;
+} XAxiDma_Config;
+
+#define XAxiDma_GetTxRing(InstancePtr) (&((InstancePtr)->TxBdRing))
+
+#define XAxiDma_GetRxRing(InstancePtr) (&((InstancePtr)->RxBdRing[0]))
+
+#define XAxiDma_GetRxIndexRing(InstancePtr, RingIndex) \
+	(&((InstancePtr)->RxBdRing[RingIndex]))
+
+#define XAxiDma_HasSg(InstancePtr) ((InstancePtr)->HasSg) ? TRUE : FALSE
+
+XAxiDma_Config *XAxiDma_LookupConfig(u32 DeviceId);
+int XAxiDma_CfgInitialize(XAxiDma *InstancePtr, XAxiDma_Config *Config);
+void XAxiDma_Reset(XAxiDma *InstancePtr);
+int XAxiDma_ResetIsDone(XAxiDma *InstancePtr);
+int XAxiDma_Pause(XAxiDma *InstancePtr);
+int XAxiDma_Resume(XAxiDma *InstancePtr);
+u32 XAxiDma_Busy(XAxiDma *InstancePtr, int Direction);
+int XAxiDma_SelectCyclicMode(XAxiDma *InstancePtr, int Direction, int Select);
+
+#endif // XAXIDMA_H
@@ -0,0 +1,68 @@
+/**
+ * @brief  Host simulation stand-in for the Xilinx AXI DMA xaxidma_bd.h.
+ *         Descriptor words are shared with the simulated engine thread so
+ *         they are accessed with acquire/release semantics.
+ */
+
+#ifndef XAXIDMA_BD_H
+#define XAXIDMA_BD_H
+
+#include <string.h>
+#include "xil_cache.h"
+#include "xaxidma_hw.h"
+#include "xstatus.h"
+
+#define XAXIDMA_BD_NUM_WORDS 16U
+
+/**
+ * The XAxiDma_Bd is the type for a buffer descriptor (BD).
+ */
+typedef u32 XAxiDma_Bd[XAXIDMA_BD_NUM_WORDS];
+
+#define XAxiDma_BdRead(BaseAddress, Offset) \
+	__atomic_load_n((u32 *)((UINTPTR)(BaseAddress) + (u32)(Offset)), \
+		__ATOMIC_ACQUIRE)
+
+#define XAxiDma_BdWrite(BaseAddress, Offset, Data) \
+	__atomic_store_n((u32 *)((UINTPTR)(BaseAddress) + (u32)(Offset)), \
+		(u32)(Data), __ATOMIC_RELEASE)
+
+#define XAxiDma_BdClear(BdPtr) \
+	memset((void *)(((UINTPTR)(BdPtr)) + XAXIDMA_BD_START_CLEAR), 0, \
+		XAXIDMA_BD_BYTES_TO_CLEAR)
+
+#define XAxiDma_BdGetCtrl(BdPtr) \
+	(XAxiDma_BdRead((BdPtr), XAXIDMA_BD_CTRL_LEN_OFFSET) & \
+		XAXIDMA_BD_CTRL_ALL_MASK)
+
+#define XAxiDma_BdGetSts(BdPtr) \
+	(XAxiDma_BdRead((BdPtr), XAXIDMA_BD_STS_OFFSET) & \
+		XAXIDMA_BD_STS_ALL_MASK)
+
+#define XAxiDma_BdGetLength(BdPtr, LengthMask) \
+	(XAxiDma_BdRead((BdPtr), XAXIDMA_BD_CTRL_LEN_OFFSET) & (LengthMask))
+
+#define XAxiDma_BdSetId(BdPtr, Id) \
+	(XAxiDma_BdWrite((BdPtr), XAXIDMA_BD_ID_OFFSET, (u32)(UINTPTR)(Id)))
+
+#define XAxiDma_BdGetId(BdPtr) (XAxiDma_BdRead((BdPtr), XAXIDMA_BD_ID_OFFSET))
+
+#define XAxiDma_BdGetBufAddr(BdPtr) \
+	(XAxiDma_BdRead((BdPtr), XAXIDMA_BD_BUFA_OFFSET))
+
+#define XAxiDma_BdHwCompleted(BdPtr) \
+	(XAxiDma_BdRead((BdPtr), XAXIDMA_BD_STS_OFFSET) & \
+		XAXIDMA_BD_STS_COMPLETE_MASK)
+
+#define XAxiDma_BdGetActualLength(BdPtr, LengthMask) \
+	(XAxiDma_BdRead((BdPtr), XAXIDMA_BD_STS_OFFSET) & (LengthMask))
+
+#define XAxiDma_BdHasDRE(BdPtr) \
+	((XAxiDma_BdRead((BdPtr), XAXIDMA_BD_HAS_DRE_OFFSET) & \
+		XAXIDMA_BD_HAS_DRE_MASK) >> XAXIDMA_BD_HAS_DRE_SHIFT)
+
+int XAxiDma_BdSetLength(XAxiDma_Bd *BdPtr, u32 LenBytes, u32 LengthMask);
+u32 XAxiDma_BdSetBufAddr(XAxiDma_Bd *BdPtr, UINTPTR Addr);
+void XAxiDma_BdSetCtrl(XAxiDma_Bd *BdPtr, u32 Data);
+
+#endif // XAXIDMA_BD_H
@@ -0,0 +1,140 @@
+/**
+ * @brief  Host simulation stand-in for the Xilinx AXI DMA xaxidma_bdring.h.
+ *         The ring bookkeeping (free -> pre -> hw -> post -> free) matches
+ *         the Xilinx driver so controller code behaves identically.
+ */
+
+#ifndef XAXIDMA_BDRING_H
+#define XAXIDMA_BDRING_H
+
+#include "xaxidma_bd.h"
+
+/* Channel run state */
+#define AXIDMA_CHANNEL_NOT_HALTED 1
+#define AXIDMA_CHANNEL_HALTED     2
+
+/* Argument constant to simplify argument setting */
+#define XAXIDMA_NO_CHANGE 0xFFFFFFFFU
+#define XAXIDMA_ALL_BDS   0x0FFFFFFF
+
+typedef struct {
+	UINTPTR ChanBase;        /**< physical base address */
+	int IsRxChannel;         /**< Is this a receive channel */
+	volatile int RunState;   /**< Whether channel is running */
+	int HasStsCntrlStrm;     /**< Whether has stscntrl stream */
+	int HasDRE;
+	int DataWidth;
+	int Addr_ext;
+	u32 MaxTransferLen;
+	UINTPTR FirstBdPhysAddr; /**< Physical address of 1st BD in list */
+	UINTPTR FirstBdAddr;     /**< Virtual address of 1st BD in list */
+	UINTPTR LastBdAddr;      /**< Virtual address of last BD in the list */
+	u32 Length;              /**< Total size of ring in bytes */
+	UINTPTR Separation;      /**< Number of bytes between the starting
+	                              address of adjacent BDs */
+	XAxiDma_Bd *FreeHead;    /**< First BD in the free group */
+	XAxiDma_Bd *PreHead;     /**< First BD in the pre-work group */
+	XAxiDma_Bd *HwHead;      /**< First BD in the work group */
+	XAxiDma_Bd *HwTail;      /**< Last BD in the work group */
+	XAxiDma_Bd *PostHead;    /**< First BD in the post-work group */
+	XAxiDma_Bd *BdaRestart;  /**< BD to load when channel is started */
+	XAxiDma_Bd *CyclicBd;    /**< Useful for Cyclic DMA operations */
+	int FreeCnt;             /**< Number of allocatable BDs */
+	int PreCnt;              /**< Number of BDs in pre-work group */
+	int HwCnt;               /**< Number of BDs in work group */
+	int PostCnt;             /**< Number of BDs in post-work group */
+	int AllCnt;              /**< Total Number of BDs for channel */
+	int RingIndex;           /**< Ring Index */
+	int Cyclic;              /**< Check for cyclic DMA Mode */
+} XAxiDma_BdRing;
+
+#define XAxiDma_BdRingCntCalc(Alignment, Bytes) \
+	(u32)((Bytes)/((sizeof(XAxiDma_Bd)+((Alignment)-1)) & \
+		~((Alignment)-1)))
+
+#define XAxiDma_BdRingMemCalc(Alignment, NumBd) \
+	(int)((sizeof(XAxiDma_Bd)+((Alignment)-1)) & ~((Alignment)-1))*(NumBd)
+
+#define XAxiDma_BdRingGetCnt(RingPtr) ((RingPtr)->AllCnt)
+
+#define XAxiDma_BdRingGetFreeCnt(RingPtr) ((RingPtr)->FreeCnt)
+
+#define XAxiDma_BdRingNext(RingPtr, BdPtr) \
+	(((UINTPTR)(BdPtr) >= (RingPtr)->LastBdAddr) ? \
+		(UINTPTR)(RingPtr)->FirstBdAddr : \
+		(UINTPTR)((UINTPTR)(BdPtr) + (RingPtr)->Separation))
+
+#define XAxiDma_BdRingPrev(RingPtr, BdPtr) \
+	(((UINTPTR)(BdPtr) <= (RingPtr)->FirstBdAddr) ? \
+		(XAxiDma_Bd *)(RingPtr)->LastBdAddr : \
+		(XAxiDma_Bd *)((UINTPTR)(BdPtr) - (RingPtr)->Separation))
+
+#define XAxiDma_BdRingGetSr(RingPtr) \
+	XAxiDma_ReadReg((RingPtr)->ChanBase, XAXIDMA_SR_OFFSET)
+
+#define XAxiDma_BdRingGetError(RingPtr) \
+	(XAxiDma_ReadReg((RingPtr)->ChanBase, XAXIDMA_SR_OFFSET) \
+		& XAXIDMA_ERR_ALL_MASK)
+
+#define XAxiDma_BdRingHwIsStarted(RingPtr) \
+	((XAxiDma_ReadReg((RingPtr)->ChanBase, XAXIDMA_SR_OFFSET) \
+		& XAXIDMA_HALTED_MASK) ? FALSE : TRUE)
+
+#define XAxiDma_BdRingBusy(RingPtr) \
+	(XAxiDma_BdRingHwIsStarted(RingPtr) && \
+		((XAxiDma_ReadReg((RingPtr)->ChanBase, XAXIDMA_SR_OFFSET) \
+			& XAXIDMA_IDLE_MASK) ? FALSE : TRUE))
+
+#define XAxiDma_BdRingIntEnable(RingPtr, Mask) \
+	(XAxiDma_WriteReg((RingPtr)->ChanBase, XAXIDMA_CR_OFFSET, \
+		XAxiDma_ReadReg((RingPtr)->ChanBase, XAXIDMA_CR_OFFSET) \
+			| ((Mask) & XAXIDMA_IRQ_ALL_MASK)))
+
+#define XAxiDma_BdRingIntGetEnabled(RingPtr) \
+	(XAxiDma_ReadReg((RingPtr)->ChanBase, XAXIDMA_CR_OFFSET) \
+		& XAXIDMA_IRQ_ALL_MASK)
+
+#define XAxiDma_BdRingIntDisable(RingPtr, Mask) \
+	(XAxiDma_WriteReg((RingPtr)->ChanBase, XAXIDMA_CR_OFFSET, \
+		XAxiDma_ReadReg((RingPtr)->ChanBase, XAXIDMA_CR_OFFSET) & \
+			~((Mask) & XAXIDMA_IRQ_ALL_MASK)))
+
+#define XAxiDma_BdRingGetIrq(RingPtr) \
+	(XAxiDma_ReadReg((RingPtr)->ChanBase, XAXIDMA_SR_OFFSET) \
+		& XAXIDMA_IRQ_ALL_MASK)
+
+#define XAxiDma_BdRingAckIrq(RingPtr, Mask) \
+	XAxiDma_WriteReg((RingPtr)->ChanBase, XAXIDMA_SR_OFFSET, \
+		(Mask) & XAXIDMA_IRQ_ALL_MASK)
+
+#define XAxiDma_BdRingGetCurrBd(RingPtr) \
+	(XAxiDma_Bd *)XAxiDma_ReadReg((RingPtr)->ChanBase, XAXIDMA_CDESC_OFFSET)
+
+#define XAxiDma_BdRingEnableCyclicDMA(RingPtr) ((RingPtr)->Cyclic = 1)
+
+#define XAxiDma_BdRingDisableCyclicDMA(RingPtr) ((RingPtr)->Cyclic = 0)
+
+int XAxiDma_BdRingCreate(XAxiDma_BdRing *RingPtr, UINTPTR PhysAddr,
+	UINTPTR VirtAddr, u32 Alignment, int BdCount);
+int XAxiDma_BdRingClone(XAxiDma_BdRing *RingPtr, XAxiDma_Bd *SrcBdPtr);
+int XAxiDma_BdRingAlloc(XAxiDma_BdRing *RingPtr, int NumBd,
+	XAxiDma_Bd **BdSetPtr);
+int XAxiDma_BdRingUnAlloc(XAxiDma_BdRing *RingPtr, int NumBd,
+	XAxiDma_Bd *BdSetPtr);
+int XAxiDma_BdRingToHw(XAxiDma_BdRing *RingPtr, int NumBd,
+	XAxiDma_Bd *BdSetPtr);
+int XAxiDma_BdRingFromHw(XAxiDma_BdRing *RingPtr, int BdLimit,
+	XAxiDma_Bd **BdSetPtr);
+int XAxiDma_BdRingFree(XAxiDma_BdRing *RingPtr, int NumBd,
+	XAxiDma_Bd *BdSetPtr);
+int XAxiDma_BdRingStart(XAxiDma_BdRing *RingPtr);
+int XAxiDma_StartBdRingHw(XAxiDma_BdRing *RingPtr);
+int XAxiDma_UpdateBdRingCDesc(XAxiDma_BdRing *RingPtr);
+int XAxiDma_BdRingSetCoalesce(XAxiDma_BdRing *RingPtr, u32 Counter,
+	u32 Timer);
+void XAxiDma_BdRingGetCoalesce(XAxiDma_BdRing *RingPtr, u32 *CounterPtr,
+	u32 *TimerPtr);
+int XAxiDma_BdRingCheck(XAxiDma_BdRing *RingPtr);
+void XAxiDma_BdRingDumpRegs(XAxiDma_BdRing *RingPtr);
+
+#endif // XAXIDMA_BDRING_H
@@ -0,0 +1,103 @@
+/**
+ * @brief  Host simulation stand-in for the Xilinx AXI DMA xaxidma_hw.h.
+ *         Register and buffer descriptor layout follow PG021. Register
+ *         accesses go through the simulated register file so write side
+ *         effects (W1C status, reset, tail pointer doorbell) behave like
+ *         the core.
+ */
+
+#ifndef XAXIDMA_HW_H
+#define XAXIDMA_HW_H
+
+#include "xil_types.h"
+
+/* Per channel register offsets */
+#define XAXIDMA_TX_OFFSET        0x00000000U /**< TX channel registers base */
+#define XAXIDMA_RX_OFFSET        0x00000030U /**< RX channel registers base */
+#define XAXIDMA_CR_OFFSET        0x00000000U /**< Channel control */
+#define XAXIDMA_SR_OFFSET        0x00000004U /**< Status */
+#define XAXIDMA_CDESC_OFFSET     0x00000008U /**< Current descriptor pointer */
+#define XAXIDMA_CDESC_MSB_OFFSET 0x0000000CU /**< Current descriptor pointer MSB */
+#define XAXIDMA_TDESC_OFFSET     0x00000010U /**< Tail descriptor pointer */
+#define XAXIDMA_TDESC_MSB_OFFSET 0x00000014U /**< Tail descriptor pointer MSB */
+#define XAXIDMA_REG_SPACE_SIZE   0x00000060U /**< Size of the register file */
+
+#define XAXIDMA_DESC_LSB_MASK    0xFFFFFFC0U /**< LSB Address mask */
+
+/* Control register bits */
+#define XAXIDMA_CR_RUNSTOP_MASK  0x00000001U /**< Start/stop DMA channel */
+#define XAXIDMA_CR_RESET_MASK    0x00000004U /**< Reset DMA engine */
+#define XAXIDMA_CR_KEYHOLE_MASK  0x00000008U /**< Keyhole feature */
+#define XAXIDMA_CR_CYCLIC_MASK   0x00000010U /**< Cyclic Mode */
+
+/* Status register bits */
+#define XAXIDMA_HALTED_MASK      0x00000001U /**< DMA channel halted */
+#define XAXIDMA_IDLE_MASK        0x00000002U /**< DMA channel idle */
+#define XAXIDMA_ERR_INTERNAL_MASK 0x00000010U /**< Datamover internal err */
+#define XAXIDMA_ERR_SLAVE_MASK   0x00000020U /**< Datamover slave err */
+#define XAXIDMA_ERR_DECODE_MASK  0x00000040U /**< Datamover decode err */
+#define XAXIDMA_ERR_SG_INT_MASK  0x00000100U /**< SG internal err */
+#define XAXIDMA_ERR_SG_SLV_MASK  0x00000200U /**< SG slave err */
+#define XAXIDMA_ERR_SG_DEC_MASK  0x00000400U /**< SG decode err */
+#define XAXIDMA_ERR_ALL_MASK     0x00000770U /**< All errors */
+
+/* Bits shared by the control (enable) and status (pending) registers */
+#define XAXIDMA_IRQ_IOC_MASK     0x00001000U /**< Completion intr */
+#define XAXIDMA_IRQ_DELAY_MASK   0x00002000U /**< Delay interrupt */
+#define XAXIDMA_IRQ_ERROR_MASK   0x00004000U /**< Error interrupt */
+#define XAXIDMA_IRQ_ALL_MASK     0x00007000U /**< All interrupts */
+
+#define XAXIDMA_DELAY_MASK       0xFF000000U /**< Delay timeout counter */
+#define XAXIDMA_COALESCE_MASK    0x00FF0000U /**< Coalesce counter */
+#define XAXIDMA_DELAY_SHIFT      24U
+#define XAXIDMA_COALESCE_SHIFT   16U
+
+/* Buffer descriptor offsets */
+#define XAXIDMA_BD_NDESC_OFFSET     0x00U /**< Next descriptor pointer */
+#define XAXIDMA_BD_NDESC_MSB_OFFSET 0x04U /**< Next descriptor pointer MSB */
+#define XAXIDMA_BD_BUFA_OFFSET      0x08U /**< Buffer address */
+#define XAXIDMA_BD_BUFA_MSB_OFFSET  0x0CU /**< Buffer address MSB */
+#define XAXIDMA_BD_MCCTL_OFFSET     0x10U /**< Multichannel Control Fields */
+#define XAXIDMA_BD_STRIDE_VSIZE_OFFSET 0x14U /**< 2D Transfer Sizes */
+#define XAXIDMA_BD_CTRL_LEN_OFFSET  0x18U /**< Control/buffer length */
+#define XAXIDMA_BD_STS_OFFSET       0x1CU /**< Status */
+#define XAXIDMA_BD_USR0_OFFSET      0x20U /**< User IP specific word0 */
+#define XAXIDMA_BD_ID_OFFSET        0x34U /**< Sw ID */
+#define XAXIDMA_BD_HAS_STSCNTRL_OFFSET 0x38U /**< Whether has stscntrl strm */
+#define XAXIDMA_BD_HAS_DRE_OFFSET   0x3CU /**< Whether has DRE */
+
+#define XAXIDMA_BD_HAS_DRE_MASK     0xF00U /**< Whether has DRE mask */
+#define XAXIDMA_BD_WORDLEN_MASK     0xFFU  /**< Whether has DRE mask */
+#define XAXIDMA_BD_HAS_DRE_SHIFT    8U
+
+#define XAXIDMA_BD_START_CLEAR      8U  /**< Offset to start clear */
+#define XAXIDMA_BD_BYTES_TO_CLEAR   48U /**< BD specific bytes to be cleared */
+
+#define XAXIDMA_BD_CTRL_LENGTH_MASK 0x03FFFFFFU /**< Requested len */
+#define XAXIDMA_BD_CTRL_TXSOF_MASK  0x08000000U /**< First tx packet */
+#define XAXIDMA_BD_CTRL_TXEOF_MASK  0x04000000U /**< Last tx packet */
+#define XAXIDMA_BD_CTRL_ALL_MASK    0x0C000000U /**< All control bits */
+
+#define XAXIDMA_BD_STS_ACTUAL_LEN_MASK 0x03FFFFFFU /**< Actual len */
+#define XAXIDMA_BD_STS_COMPLETE_MASK   0x80000000U /**< Completed */
+#define XAXIDMA_BD_STS_DEC_ERR_MASK    0x40000000U /**< Decode error */
+#define XAXIDMA_BD_STS_SLV_ERR_MASK    0x20000000U /**< Slave error */
+#define XAXIDMA_BD_STS_INT_ERR_MASK    0x10000000U /**< Internal err */
+#define XAXIDMA_BD_STS_ALL_ERR_MASK    0x70000000U /**< All errors */
+#define XAXIDMA_BD_STS_RXSOF_MASK      0x08000000U /**< First rx pkt */
+#define XAXIDMA_BD_STS_RXEOF_MASK      0x04000000U /**< Last rx pkt */
+#define XAXIDMA_BD_STS_ALL_MASK        0xFC000000U /**< All status bits */
+
+#define XAXIDMA_BD_MINIMUM_ALIGNMENT   0x40U /**< Minimum byte alignment */
+
+/* Register access into the simulated register file */
+u32 simAxiDma_regRead(UINTPTR addr);
+void simAxiDma_regWrite(UINTPTR addr, u32 data);
+
+#define XAxiDma_ReadReg(BaseAddress, RegOffset) \
+	simAxiDma_regRead((BaseAddress) + (RegOffset))
+
+#define XAxiDma_WriteReg(BaseAddress, RegOffset, Data) \
+	simAxiDma_regWrite((BaseAddress) + (RegOffset), (u32)(Data))
+
+#endif // XAXIDMA_HW_H
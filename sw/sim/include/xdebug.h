@@ -0,0 +1,13 @@
+/**
+ * @brief  Host simulation stand-in for the Xilinx standalone BSP xdebug.h
+ */
+
+#ifndef XDEBUG_H
+#define XDEBUG_H
+
+#define XDBG_DEBUG_ERROR   0x00000001U
+#define XDBG_DEBUG_GENERAL 0x00000002U
+
+#define xdbg_printf(...)
+
+#endif // XDEBUG_H
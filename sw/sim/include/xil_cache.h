@@ -0,0 +1,21 @@
+/**
+ * @brief  Host simulation stand-in for the Xilinx standalone BSP xil_cache.h.
+ *         The host is cache coherent with the simulated DMA so maintenance
+ *         operations only count the work they would have done.
+ */
+
+#ifndef XIL_CACHE_H
+#define XIL_CACHE_H
+
+#include "xil_types.h"
+
+void Xil_DCacheEnable(void);
+void Xil_DCacheDisable(void);
+void Xil_DCacheFlush(void);
+void Xil_DCacheInvalidate(void);
+void Xil_DCacheFlushRange(INTPTR adr, u32 len);
+void Xil_DCacheInvalidateRange(INTPTR adr, u32 len);
+void Xil_ICacheEnable(void);
+void Xil_ICacheDisable(void);
+
+#endif // XIL_CACHE_H
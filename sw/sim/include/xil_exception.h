@@ -0,0 +1,34 @@
+/**
+ * @brief  Host simulation stand-in for the Xilinx standalone BSP xil_exception.h.
+ *         The IRQ exception is modelled with a POSIX signal delivered to the
+ *         thread that enables exceptions, so handlers preempt it the same
+ *         way an interrupt preempts the Cortex-A9.
+ */
+
+#ifndef XIL_EXCEPTION_H
+#define XIL_EXCEPTION_H
+
+#include "xil_types.h"
+
+#define XIL_EXCEPTION_ID_FIRST     0U
+#define XIL_EXCEPTION_ID_RESET     0U
+#define XIL_EXCEPTION_ID_UNDEFINED_INT 1U
+#define XIL_EXCEPTION_ID_SWI_INT   2U
+#define XIL_EXCEPTION_ID_PREFETCH_ABORT_INT 3U
+#define XIL_EXCEPTION_ID_DATA_ABORT_INT 4U
+#define XIL_EXCEPTION_ID_IRQ_INT   5U
+#define XIL_EXCEPTION_ID_FIQ_INT   6U
+#define XIL_EXCEPTION_ID_LAST      6U
+#define XIL_EXCEPTION_ID_INT       XIL_EXCEPTION_ID_IRQ_INT
+
+typedef void (*Xil_ExceptionHandler)(void *data);
+typedef void (*Xil_InterruptHandler)(void *data);
+
+void Xil_ExceptionInit(void);
+void Xil_ExceptionRegisterHandler(u32 Exception_id,
+	Xil_ExceptionHandler Handler, void *Data);
+void Xil_ExceptionRemoveHandler(u32 Exception_id);
+void Xil_ExceptionEnable(void);
+void Xil_ExceptionDisable(void);
+
+#endif // XIL_EXCEPTION_H
@@ -0,0 +1,18 @@
+/**
+ * @brief  Host simulation stand-in for the Xilinx standalone BSP xil_mmu.h.
+ *         The host has no section table, attributes are only recorded.
+ */
+
+#ifndef XIL_MMU_H
+#define XIL_MMU_H
+
+#include "xil_types.h"
+
+#define NORM_NONCACHE  0x11DE2U /**< Normal Non-cacheable */
+#define STRONG_ORDERED 0xC02U   /**< Strongly ordered */
+#define DEVICE_MEMORY  0xC06U   /**< Device memory */
+#define NORM_WB_CACHE  0x15DE6U /**< Normal write-back cacheable */
+
+void Xil_SetTlbAttributes(UINTPTR Addr, u32 attrib);
+
+#endif // XIL_MMU_H
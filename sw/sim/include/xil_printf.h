@@ -0,0 +1,12 @@
+/**
+ * @brief  Host simulation stand-in for the Xilinx standalone BSP xil_printf.h
+ */
+
+#ifndef XIL_PRINTF_H
+#define XIL_PRINTF_H
+
+#include <stdio.h>
+
+#define xil_printf printf
+
+#endif // XIL_PRINTF_H
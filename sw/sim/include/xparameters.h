@@ -0,0 +1,44 @@
+/**
+ * @brief  Host simulation xparameters.h describing the zybo.bd reference
+ *         design: one AXI DMA in SG mode with DRE looped back through an
+ *         8192 deep, 32 bit wide AXI4-Stream data FIFO.
+ *
+ *         DDR is a window mapped at a fixed address below 4GB so the 32 bit
+ *         buffer addresses used by the API stay valid on a 64 bit host.
+ */
+
+#ifndef XPARAMETERS_H
+#define XPARAMETERS_H
+
+/* Simulated DDR window */
+#define XPAR_PS7_DDR_0_S_AXI_BASEADDR 0x20000000U
+#define XPAR_PS7_DDR_0_S_AXI_HIGHADDR 0x23FFFFFFU
+
+/* Definitions for driver AXIDMA */
+#define XPAR_XAXIDMA_NUM_INSTANCES 1U
+
+#define XPAR_AXI_DMA_0_DEVICE_ID 0U
+#define XPAR_AXI_DMA_0_INCLUDE_MM2S 1U
+#define XPAR_AXI_DMA_0_INCLUDE_MM2S_DRE 1U
+#define XPAR_AXI_DMA_0_M_AXI_MM2S_DATA_WIDTH 32U
+#define XPAR_AXI_DMA_0_INCLUDE_S2MM 1U
+#define XPAR_AXI_DMA_0_INCLUDE_S2MM_DRE 1U
+#define XPAR_AXI_DMA_0_M_AXI_S2MM_DATA_WIDTH 32U
+#define XPAR_AXI_DMA_0_INCLUDE_SG 1U
+#define XPAR_AXI_DMA_0_SG_LENGTH_WIDTH 14U
+#define XPAR_AXIDMA_0_DEVICE_ID XPAR_AXI_DMA_0_DEVICE_ID
+
+/* Loopback FIFO between MM2S and S2MM (axis_data_fifo_0) */
+#define XPAR_AXIS_DATA_FIFO_0_DEPTH 8192U
+#define XPAR_AXIS_DATA_FIFO_0_TDATA_NUM_BYTES 4U
+
+/* Definitions for Fabric interrupts connected to ps7_scugic_0 */
+#define XPAR_FABRIC_AXI_DMA_0_MM2S_INTROUT_INTR 61U
+#define XPAR_FABRIC_AXI_DMA_0_S2MM_INTROUT_INTR 62U
+
+/* Definitions for driver SCUGIC */
+#define XPAR_SCUGIC_NUM_INSTANCES 1U
+#define XPAR_SCUGIC_SINGLE_DEVICE_ID 0U
+#define XPAR_SCUGIC_0_DEVICE_ID 0U
+
+#endif // XPARAMETERS_H
@@ -0,0 +1,46 @@
+/**
+ * @brief  Host simulation stand-in for the Xilinx XScuGic driver. Only the
+ *         subset used by the DMA controller and test code is provided.
+ */
+
+#ifndef XSCUGIC_H
+#define XSCUGIC_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xil_exception.h"
+#include "xparameters.h"
+
+#define XSCUGIC_MAX_NUM_INTR_INPUTS 95U
+
+typedef struct {
+	Xil_InterruptHandler Handler;
+	void *CallBackRef;
+} XScuGic_VectorTableEntry;
+
+typedef struct {
+	u16 DeviceId;
+	u32 CpuBaseAddress;
+	u32 DistBaseAddress;
+	XScuGic_VectorTableEntry HandlerTable[XSCUGIC_MAX_NUM_INTR_INPUTS];
+} XScuGic_Config;
+
+typedef struct {
+	XScuGic_Config *Config;
+	u32 IsReady;
+	u32 UnhandledInterrupts;
+} XScuGic;
+
+XScuGic_Config *XScuGic_LookupConfig(u16 DeviceId);
+s32 XScuGic_CfgInitialize(XScuGic *InstancePtr, XScuGic_Config *ConfigPtr,
+	u32 EffectiveAddr);
+s32 XScuGic_Connect(XScuGic *InstancePtr, u32 Int_Id,
+	Xil_InterruptHandler Handler, void *CallBackRef);
+void XScuGic_Disconnect(XScuGic *InstancePtr, u32 Int_Id);
+void XScuGic_Enable(XScuGic *InstancePtr, u32 Int_Id);
+void XScuGic_Disable(XScuGic *InstancePtr, u32 Int_Id);
+void XScuGic_SetPriorityTriggerType(XScuGic *InstancePtr, u32 Int_Id,
+	u8 Priority, u8 Trigger);
+void XScuGic_InterruptHandler(XScuGic *InstancePtr);
+
+#endif // XSCUGIC_H
@@ -0,0 +1,22 @@
+/**
+ * @brief  Host simulation stand-in for the Xilinx standalone BSP xstatus.h
+ */
+
+#ifndef XSTATUS_H
+#define XSTATUS_H
+
+#include "xil_types.h"
+
+#define XST_SUCCESS                   0L
+#define XST_FAILURE                   1L
+#define XST_DEVICE_NOT_FOUND          2L
+#define XST_DEVICE_IS_STARTED         5L
+#define XST_DEVICE_IS_STOPPED         6L
+#define XST_INVALID_PARAM             15L
+#define XST_NOT_SGDMA                 28L
+#define XST_DMA_ERROR                 511L
+#define XST_DMA_SG_LIST_EMPTY         514L
+#define XST_DMA_SG_NO_LIST            523L
+#define XST_DMA_SG_LIST_ERROR         526L
+
+#endif // XSTATUS_H
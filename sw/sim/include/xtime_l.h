@@ -0,0 +1,18 @@
+/**
+ * @brief  Host simulation stand-in for the Cortex-A9 global timer API
+ *         (xtime_l.h). Counts are nanoseconds of CLOCK_MONOTONIC.
+ */
+
+#ifndef XTIME_H
+#define XTIME_H
+
+#include "xil_types.h"
+
+typedef u64 XTime;
+
+#define COUNTS_PER_SECOND 1000000000ULL
+
+void XTime_SetTime(XTime Xtime_Global);
+void XTime_GetTime(XTime *Xtime_Global);
+
+#endif // XTIME_H
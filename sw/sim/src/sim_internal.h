@@ -0,0 +1,29 @@
+/**
+ * @brief  Interfaces shared between the pieces of the host simulation that
+ *         are not visible to code built against the BSP headers.
+ */
+
+#ifndef SIM_INTERNAL_H
+#define SIM_INTERNAL_H
+
+#include "xil_types.h"
+
+/**
+ * @brief      Asserts an interrupt line on the simulated GIC and kicks the
+ *             CPU thread so pending and enabled lines get dispatched.
+ *
+ * @param[in]  intId  GIC interrupt id
+ */
+void simGic_raise(u32 intId);
+
+/**
+ * @brief      Returns the register file base of a simulated AXI DMA core,
+ *             starting its engine thread on first use.
+ *
+ * @param[in]  deviceId  AXI DMA device id from xparameters
+ *
+ * @return     register file base address, 0 on unknown device
+ */
+UINTPTR simAxiDma_hwBase(u32 deviceId);
+
+#endif // SIM_INTERNAL_H
@@ -0,0 +1,805 @@
+/**
+ * @brief  Host simulation of the Xilinx AXI DMA driver (xaxidma.c,
+ *         xaxidma_bd.c, xaxidma_bdring.c). Follows the behaviour of the
+ *         2018.2 standalone driver closely enough that the controller runs
+ *         against it unmodified; the hardware side lives in xaxidma_sim_hw.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "xaxidma.h"
+#include "sim_internal.h"
+
+/* Loop count used while waiting for a reset, real driver uses 500 */
+#define XAXIDMA_RESET_TIMEOUT 500
+
+static XAxiDma_Config axiDmaConfigTable[XPAR_XAXIDMA_NUM_INSTANCES] = {
+    {
+        XPAR_AXI_DMA_0_DEVICE_ID,
+        0,
+        0,
+        XPAR_AXI_DMA_0_INCLUDE_MM2S,
+        XPAR_AXI_DMA_0_INCLUDE_MM2S_DRE,
+        XPAR_AXI_DMA_0_M_AXI_MM2S_DATA_WIDTH,
+        XPAR_AXI_DMA_0_INCLUDE_S2MM,
+        XPAR_AXI_DMA_0_INCLUDE_S2MM_DRE,
+        XPAR_AXI_DMA_0_M_AXI_S2MM_DATA_WIDTH,
+        XPAR_AXI_DMA_0_INCLUDE_SG,
+        1,
+        1,
+        16,
+        16,
+        0,
+        32,
+        XPAR_AXI_DMA_0_SG_LENGTH_WIDTH
+    }
+};
+
+/* Move a BD pointer forward/backward in the ring, wrapping as needed */
+#define XAXIDMA_RING_SEEKAHEAD(RingPtr, BdPtr, NumBd)                     \
+    {                                                                     \
+        UINTPTR Addr = (UINTPTR)(void *)(BdPtr);                          \
+        Addr += ((RingPtr)->Separation * (NumBd));                        \
+        if ((Addr > (RingPtr)->LastBdAddr) || ((UINTPTR)(BdPtr) > Addr)) \
+            Addr -= (RingPtr)->Length;                                    \
+        (BdPtr) = (XAxiDma_Bd *)(void *)Addr;                             \
+    }
+
+#define XAXIDMA_RING_SEEKBACK(RingPtr, BdPtr, NumBd)                      \
+    {                                                                     \
+        UINTPTR Addr = (UINTPTR)(void *)(BdPtr);                          \
+        Addr -= ((RingPtr)->Separation * (NumBd));                        \
+        if ((Addr < (RingPtr)->FirstBdAddr) || ((UINTPTR)(BdPtr) < Addr)) \
+            Addr += (RingPtr)->Length;                                    \
+        (BdPtr) = (XAxiDma_Bd *)(void *)Addr;                             \
+    }
+
+/******************************* Buffer descriptors **************************/
+
+int XAxiDma_BdSetLength(XAxiDma_Bd *BdPtr, u32 LenBytes, u32 LengthMask)
+{
+    if (LenBytes <= 0 || LenBytes > LengthMask)
+        return XST_INVALID_PARAM;
+
+    XAxiDma_BdWrite(BdPtr, XAXIDMA_BD_CTRL_LEN_OFFSET,
+        ((XAxiDma_BdRead(BdPtr, XAXIDMA_BD_CTRL_LEN_OFFSET) & ~LengthMask))
+        | LenBytes);
+
+    return XST_SUCCESS;
+}
+
+u32 XAxiDma_BdSetBufAddr(XAxiDma_Bd *BdPtr, UINTPTR Addr)
+{
+    u32 HasDRE;
+    u8 WordLen;
+
+    HasDRE = XAxiDma_BdHasDRE(BdPtr);
+    WordLen = XAxiDma_BdRead(BdPtr, XAXIDMA_BD_HAS_DRE_OFFSET) &
+        XAXIDMA_BD_WORDLEN_MASK;
+
+    if (WordLen && (Addr & (WordLen - 1)) && !HasDRE)
+        return XST_INVALID_PARAM;
+
+    XAxiDma_BdWrite(BdPtr, XAXIDMA_BD_BUFA_OFFSET, (u32)Addr);
+    XAxiDma_BdWrite(BdPtr, XAXIDMA_BD_BUFA_MSB_OFFSET, (u32)((u64)Addr >> 32));
+
+    return XST_SUCCESS;
+}
+
+void XAxiDma_BdSetCtrl(XAxiDma_Bd *BdPtr, u32 Data)
+{
+    u32 RegValue = XAxiDma_BdRead(BdPtr, XAXIDMA_BD_CTRL_LEN_OFFSET);
+
+    RegValue &= ~XAXIDMA_BD_CTRL_ALL_MASK;
+    RegValue |= (Data & XAXIDMA_BD_CTRL_ALL_MASK);
+
+    XAxiDma_BdWrite(BdPtr, XAXIDMA_BD_CTRL_LEN_OFFSET, RegValue);
+}
+
+/******************************* BD rings ************************************/
+
+int XAxiDma_BdRingCreate(XAxiDma_BdRing *RingPtr, UINTPTR PhysAddr,
+    UINTPTR VirtAddr, u32 Alignment, int BdCount)
+{
+    u32 i;
+    UINTPTR BdVirtAddr;
+    UINTPTR BdPhysAddr;
+
+    if (BdCount <= 0)
+        return XST_INVALID_PARAM;
+
+    /* In case there is a failure prior to creating list, make sure the
+     * following attributes are 0 to prevent calls to other functions
+     * from doing anything. */
+    RingPtr->AllCnt = 0;
+    RingPtr->FreeCnt = 0;
+    RingPtr->HwCnt = 0;
+    RingPtr->PreCnt = 0;
+    RingPtr->PostCnt = 0;
+    RingPtr->Cyclic = 0;
+
+    if ((Alignment & (XAXIDMA_BD_MINIMUM_ALIGNMENT - 1)) ||
+        (Alignment & (Alignment - 1)))
+        return XST_INVALID_PARAM;
+
+    if (VirtAddr & (Alignment - 1))
+        return XST_INVALID_PARAM;
+
+    RingPtr->Separation = (sizeof(XAxiDma_Bd) + (Alignment - 1)) &
+        ~(Alignment - 1);
+
+    memset((void *)VirtAddr, 0, (size_t)(RingPtr->Separation * BdCount));
+
+    BdVirtAddr = VirtAddr;
+    BdPhysAddr = PhysAddr + RingPtr->Separation;
+    for (i = 1; i < (u32)BdCount; i++) {
+        XAxiDma_BdWrite(BdVirtAddr, XAXIDMA_BD_NDESC_OFFSET,
+            (u32)(BdPhysAddr & XAXIDMA_DESC_LSB_MASK));
+        XAxiDma_BdWrite(BdVirtAddr, XAXIDMA_BD_NDESC_MSB_OFFSET,
+            (u32)((u64)BdPhysAddr >> 32));
+        XAxiDma_BdWrite(BdVirtAddr, XAXIDMA_BD_HAS_STSCNTRL_OFFSET,
+            (u32)RingPtr->HasStsCntrlStrm);
+        XAxiDma_BdWrite(BdVirtAddr, XAXIDMA_BD_HAS_DRE_OFFSET,
+            (((u32)(RingPtr->HasDRE)) << XAXIDMA_BD_HAS_DRE_SHIFT) |
+            (u32)RingPtr->DataWidth);
+
+        BdVirtAddr += RingPtr->Separation;
+        BdPhysAddr += RingPtr->Separation;
+    }
+
+    /* At the end of the ring, link the last BD back to the top */
+    XAxiDma_BdWrite(BdVirtAddr, XAXIDMA_BD_NDESC_OFFSET,
+        (u32)(PhysAddr & XAXIDMA_DESC_LSB_MASK));
+    XAxiDma_BdWrite(BdVirtAddr, XAXIDMA_BD_NDESC_MSB_OFFSET,
+        (u32)((u64)PhysAddr >> 32));
+    XAxiDma_BdWrite(BdVirtAddr, XAXIDMA_BD_HAS_STSCNTRL_OFFSET,
+        (u32)RingPtr->HasStsCntrlStrm);
+    XAxiDma_BdWrite(BdVirtAddr, XAXIDMA_BD_HAS_DRE_OFFSET,
+        (((u32)(RingPtr->HasDRE)) << XAXIDMA_BD_HAS_DRE_SHIFT) |
+        (u32)RingPtr->DataWidth);
+
+    /* Setup and initialize pointers and counters */
+    RingPtr->RunState = AXIDMA_CHANNEL_HALTED;
+    RingPtr->FirstBdAddr = VirtAddr;
+    RingPtr->FirstBdPhysAddr = PhysAddr;
+    RingPtr->LastBdAddr = BdVirtAddr;
+    RingPtr->Length = (u32)(RingPtr->LastBdAddr - RingPtr->FirstBdAddr +
+        RingPtr->Separation);
+    RingPtr->AllCnt = BdCount;
+    RingPtr->FreeCnt = BdCount;
+    RingPtr->FreeHead = (XAxiDma_Bd *)VirtAddr;
+    RingPtr->PreHead = (XAxiDma_Bd *)VirtAddr;
+    RingPtr->HwHead = (XAxiDma_Bd *)VirtAddr;
+    RingPtr->HwTail = (XAxiDma_Bd *)VirtAddr;
+    RingPtr->PostHead = (XAxiDma_Bd *)VirtAddr;
+    RingPtr->BdaRestart = (XAxiDma_Bd *)VirtAddr;
+    RingPtr->CyclicBd = (XAxiDma_Bd *)VirtAddr;
+
+    return XST_SUCCESS;
+}
+
+int XAxiDma_BdRingClone(XAxiDma_BdRing *RingPtr, XAxiDma_Bd *SrcBdPtr)
+{
+    int i;
+    UINTPTR CurBd;
+    u32 Save;
+    u32 SaveMsb;
+    XAxiDma_Bd TmpBd;
+
+    if (RingPtr->AllCnt == 0)
+        return XST_DMA_SG_NO_LIST;
+
+    if (RingPtr->RunState != AXIDMA_CHANNEL_HALTED)
+        return XST_DEVICE_IS_STARTED;
+
+    if (RingPtr->FreeCnt != RingPtr->AllCnt)
+        return XST_DMA_SG_LIST_ERROR;
+
+    /* Make a copy of the template then modify it by clearing the complete
+     * bit in status/control field */
+    memcpy(&TmpBd, SrcBdPtr, sizeof(XAxiDma_Bd));
+    TmpBd[XAXIDMA_BD_STS_OFFSET / sizeof(u32)] &=
+        ~XAXIDMA_BD_STS_COMPLETE_MASK;
+
+    for (i = 0, CurBd = RingPtr->FirstBdAddr; i < RingPtr->AllCnt;
+            i++, CurBd += RingPtr->Separation) {
+        u32 HasStsCntrl = XAxiDma_BdRead(CurBd, XAXIDMA_BD_HAS_STSCNTRL_OFFSET);
+        u32 HasDre = XAxiDma_BdRead(CurBd, XAXIDMA_BD_HAS_DRE_OFFSET);
+
+        Save = XAxiDma_BdRead(CurBd, XAXIDMA_BD_NDESC_OFFSET);
+        SaveMsb = XAxiDma_BdRead(CurBd, XAXIDMA_BD_NDESC_MSB_OFFSET);
+        memcpy((void *)CurBd, &TmpBd, sizeof(XAxiDma_Bd));
+        XAxiDma_BdWrite(CurBd, XAXIDMA_BD_NDESC_OFFSET, Save);
+        XAxiDma_BdWrite(CurBd, XAXIDMA_BD_NDESC_MSB_OFFSET, SaveMsb);
+        XAxiDma_BdWrite(CurBd, XAXIDMA_BD_HAS_STSCNTRL_OFFSET, HasStsCntrl);
+        XAxiDma_BdWrite(CurBd, XAXIDMA_BD_HAS_DRE_OFFSET, HasDre);
+    }
+
+    return XST_SUCCESS;
+}
+
+int XAxiDma_BdRingAlloc(XAxiDma_BdRing *RingPtr, int NumBd,
+    XAxiDma_Bd **BdSetPtr)
+{
+    if (NumBd <= 0)
+        return XST_INVALID_PARAM;
+
+    /* Enough free BDs available for the request? */
+    if (RingPtr->FreeCnt < NumBd)
+        return XST_FAILURE;
+
+    /* Set the return argument and move FreeHead forward */
+    *BdSetPtr = RingPtr->FreeHead;
+    XAXIDMA_RING_SEEKAHEAD(RingPtr, RingPtr->FreeHead, NumBd);
+    RingPtr->FreeCnt -= NumBd;
+    RingPtr->PreCnt += NumBd;
+
+    return XST_SUCCESS;
+}
+
+int XAxiDma_BdRingUnAlloc(XAxiDma_BdRing *RingPtr, int NumBd,
+    XAxiDma_Bd *BdSetPtr)
+{
+    (void)BdSetPtr;
+
+    if (NumBd <= 0)
+        return XST_INVALID_PARAM;
+
+    /* Enough BDs in the pre-work group for the request? */
+    if (RingPtr->PreCnt < NumBd)
+        return XST_FAILURE;
+
+    /* Move FreeHead backward */
+    XAXIDMA_RING_SEEKBACK(RingPtr, RingPtr->FreeHead, NumBd);
+    RingPtr->FreeCnt += NumBd;
+    RingPtr->PreCnt -= NumBd;
+
+    return XST_SUCCESS;
+}
+
+int XAxiDma_BdRingToHw(XAxiDma_BdRing *RingPtr, int NumBd,
+    XAxiDma_Bd *BdSetPtr)
+{
+    XAxiDma_Bd *CurBdPtr;
+    int i;
+    u32 BdCr;
+    u32 BdSts;
+
+    if (NumBd < 0)
+        return XST_INVALID_PARAM;
+
+    if (NumBd == 0)
+        return XST_SUCCESS;
+
+    /* Make sure we are in sync with XAxiDma_BdRingAlloc() */
+    if ((RingPtr->PreCnt < NumBd) || (RingPtr->PreHead != BdSetPtr))
+        return XST_DMA_SG_LIST_ERROR;
+
+    CurBdPtr = BdSetPtr;
+    BdCr = XAxiDma_BdGetCtrl(CurBdPtr);
+
+    /* In case of Tx channel, the first BD should have been marked
+     * as start-of-frame */
+    if (!(RingPtr->IsRxChannel) && !(BdCr & XAXIDMA_BD_CTRL_TXSOF_MASK))
+        return XST_FAILURE;
+
+    /* Clear the completed status bit */
+    for (i = 0; i < NumBd - 1; i++) {
+        BdSts = XAxiDma_BdRead(CurBdPtr, XAXIDMA_BD_STS_OFFSET);
+        XAxiDma_BdWrite(CurBdPtr, XAXIDMA_BD_STS_OFFSET,
+            BdSts & ~XAXIDMA_BD_STS_COMPLETE_MASK);
+        CurBdPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(RingPtr, CurBdPtr);
+    }
+
+    /* In case of Tx channel, the last BD should have EOF bit set */
+    BdCr = XAxiDma_BdGetCtrl(CurBdPtr);
+    if (!(RingPtr->IsRxChannel) && !(BdCr & XAXIDMA_BD_CTRL_TXEOF_MASK))
+        return XST_FAILURE;
+
+    BdSts = XAxiDma_BdRead(CurBdPtr, XAXIDMA_BD_STS_OFFSET);
+    XAxiDma_BdWrite(CurBdPtr, XAXIDMA_BD_STS_OFFSET,
+        BdSts & ~XAXIDMA_BD_STS_COMPLETE_MASK);
+
+    /* This set has completed pre-processing, adjust ring pointers and
+     * counts */
+    XAXIDMA_RING_SEEKAHEAD(RingPtr, RingPtr->PreHead, NumBd);
+    RingPtr->PreCnt -= NumBd;
+    RingPtr->HwTail = CurBdPtr;
+    RingPtr->HwCnt += NumBd;
+
+    /* If it is running, signal the engine to begin processing */
+    if (RingPtr->RunState == AXIDMA_CHANNEL_NOT_HALTED) {
+        UINTPTR Tail = RingPtr->Cyclic ? (UINTPTR)RingPtr->CyclicBd :
+            (UINTPTR)RingPtr->HwTail;
+
+        XAxiDma_WriteReg(RingPtr->ChanBase, XAXIDMA_TDESC_MSB_OFFSET,
+            (u32)((u64)Tail >> 32));
+        XAxiDma_WriteReg(RingPtr->ChanBase, XAXIDMA_TDESC_OFFSET,
+            (u32)(Tail & XAXIDMA_DESC_LSB_MASK));
+    }
+
+    return XST_SUCCESS;
+}
+
+int XAxiDma_BdRingFromHw(XAxiDma_BdRing *RingPtr, int BdLimit,
+    XAxiDma_Bd **BdSetPtr)
+{
+    XAxiDma_Bd *CurBdPtr;
+    int BdCount;
+    int BdPartialCount;
+    u32 BdSts;
+    u32 BdCr;
+
+    CurBdPtr = RingPtr->HwHead;
+    BdCount = 0;
+    BdPartialCount = 0;
+
+    /* If no BDs in work group, then there's nothing to search */
+    if (RingPtr->HwCnt == 0) {
+        *BdSetPtr = NULL;
+        return 0;
+    }
+
+    if (BdLimit > RingPtr->HwCnt)
+        BdLimit = RingPtr->HwCnt;
+
+    /* Starting at HwHead, keep moving forward in the list until:
+     *  - A BD is encountered with its completed bit clear in the status
+     *    word which means hardware has not completed processing of that
+     *    BD.
+     *  - RingPtr->HwTail is reached
+     *  - The number of requested BDs has been processed
+     */
+    while (BdCount < BdLimit) {
+        BdSts = XAxiDma_BdRead(CurBdPtr, XAXIDMA_BD_STS_OFFSET);
+        BdCr = XAxiDma_BdRead(CurBdPtr, XAXIDMA_BD_CTRL_LEN_OFFSET);
+
+        if (!(BdSts & XAXIDMA_BD_STS_COMPLETE_MASK))
+            break;
+
+        BdCount++;
+
+        /* Hardware has processed this BD so check the "last" bit. If it
+         * is clear, then there are more BDs for the current packet. Keep a
+         * count of these partial packet BDs. */
+        if (RingPtr->IsRxChannel) {
+            if (BdSts & XAXIDMA_BD_STS_RXEOF_MASK)
+                BdPartialCount = 0;
+            else
+                BdPartialCount++;
+        } else {
+            if (BdCr & XAXIDMA_BD_CTRL_TXEOF_MASK)
+                BdPartialCount = 0;
+            else
+                BdPartialCount++;
+        }
+
+        /* Move on to next BD in work group */
+        CurBdPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(RingPtr, CurBdPtr);
+    }
+
+    /* Subtract off any partial packet BDs found */
+    BdCount -= BdPartialCount;
+
+    /* If BdCount is non-zero then BDs were found to return. Set return
+     * parameters, update pointers and counters, return success */
+    if (BdCount > 0) {
+        *BdSetPtr = RingPtr->HwHead;
+        RingPtr->HwCnt -= BdCount;
+        RingPtr->PostCnt += BdCount;
+        XAXIDMA_RING_SEEKAHEAD(RingPtr, RingPtr->HwHead, BdCount);
+        return BdCount;
+    }
+
+    *BdSetPtr = NULL;
+    return 0;
+}
+
+int XAxiDma_BdRingFree(XAxiDma_BdRing *RingPtr, int NumBd,
+    XAxiDma_Bd *BdSetPtr)
+{
+    if (NumBd < 0)
+        return XST_INVALID_PARAM;
+
+    if (NumBd == 0)
+        return XST_SUCCESS;
+
+    /* Make sure we are in sync with XAxiDma_BdRingFromHw() */
+    if ((RingPtr->PostCnt < NumBd) || (RingPtr->PostHead != BdSetPtr))
+        return XST_DMA_SG_LIST_ERROR;
+
+    /* Update pointers and counters */
+    RingPtr->FreeCnt += NumBd;
+    RingPtr->PostCnt -= NumBd;
+    XAXIDMA_RING_SEEKAHEAD(RingPtr, RingPtr->PostHead, NumBd);
+
+    return XST_SUCCESS;
+}
+
+int XAxiDma_UpdateBdRingCDesc(XAxiDma_BdRing *RingPtr)
+{
+    UINTPTR RegBase;
+    UINTPTR BdPtr;
+
+    /* Can't do this function if there isn't a ring */
+    if (RingPtr->AllCnt == 0)
+        return XST_DMA_SG_NO_LIST;
+
+    /* Can't do this function if the channel is running */
+    if (RingPtr->RunState == AXIDMA_CHANNEL_NOT_HALTED)
+        return XST_DEVICE_IS_STARTED;
+
+    if (XAxiDma_BdRingHwIsStarted(RingPtr))
+        return XST_SUCCESS;
+
+    RegBase = RingPtr->ChanBase;
+    if (RingPtr->HwCnt > 0 && !XAxiDma_BdHwCompleted(RingPtr->HwHead))
+        BdPtr = (UINTPTR)RingPtr->HwHead;
+    else
+        BdPtr = (UINTPTR)RingPtr->BdaRestart;
+
+    XAxiDma_WriteReg(RegBase, XAXIDMA_CDESC_OFFSET,
+        (u32)(BdPtr & XAXIDMA_DESC_LSB_MASK));
+    XAxiDma_WriteReg(RegBase, XAXIDMA_CDESC_MSB_OFFSET,
+        (u32)((u64)BdPtr >> 32));
+
+    return XST_SUCCESS;
+}
+
+int XAxiDma_StartBdRingHw(XAxiDma_BdRing *RingPtr)
+{
+    UINTPTR RegBase = RingPtr->ChanBase;
+
+    if (!XAxiDma_BdRingHwIsStarted(RingPtr)) {
+        /* Start the hardware */
+        XAxiDma_WriteReg(RegBase, XAXIDMA_CR_OFFSET,
+            XAxiDma_ReadReg(RegBase, XAXIDMA_CR_OFFSET) |
+            XAXIDMA_CR_RUNSTOP_MASK);
+    }
+
+    if (XAxiDma_BdRingHwIsStarted(RingPtr)) {
+        /* Note as active */
+        RingPtr->RunState = AXIDMA_CHANNEL_NOT_HALTED;
+
+        /* If there are unprocessed BDs then put them to hardware */
+        if (RingPtr->HwCnt > 0) {
+            UINTPTR Tail = RingPtr->Cyclic ? (UINTPTR)RingPtr->CyclicBd :
+                (UINTPTR)RingPtr->HwTail;
+
+            XAxiDma_WriteReg(RegBase, XAXIDMA_TDESC_MSB_OFFSET,
+                (u32)((u64)Tail >> 32));
+            XAxiDma_WriteReg(RegBase, XAXIDMA_TDESC_OFFSET,
+                (u32)(Tail & XAXIDMA_DESC_LSB_MASK));
+        }
+
+        return XST_SUCCESS;
+    }
+
+    return XST_DMA_ERROR;
+}
+
+int XAxiDma_BdRingStart(XAxiDma_BdRing *RingPtr)
+{
+    int Status;
+
+    Status = XAxiDma_UpdateBdRingCDesc(RingPtr);
+    if (Status != XST_SUCCESS)
+        return Status;
+
+    return XAxiDma_StartBdRingHw(RingPtr);
+}
+
+int XAxiDma_BdRingSetCoalesce(XAxiDma_BdRing *RingPtr, u32 Counter,
+    u32 Timer)
+{
+    u32 Cr = XAxiDma_ReadReg(RingPtr->ChanBase, XAXIDMA_CR_OFFSET);
+
+    if (Counter == 0 || (Counter != XAXIDMA_NO_CHANGE && Counter > 0xFF))
+        return XST_FAILURE;
+
+    if (Timer != XAXIDMA_NO_CHANGE && Timer > 0xFF)
+        return XST_FAILURE;
+
+    if (Counter != XAXIDMA_NO_CHANGE) {
+        Cr = (Cr & ~XAXIDMA_COALESCE_MASK) |
+            (Counter << XAXIDMA_COALESCE_SHIFT);
+    }
+
+    if (Timer != XAXIDMA_NO_CHANGE) {
+        Cr = (Cr & ~XAXIDMA_DELAY_MASK) | (Timer << XAXIDMA_DELAY_SHIFT);
+    }
+
+    XAxiDma_WriteReg(RingPtr->ChanBase, XAXIDMA_CR_OFFSET, Cr);
+
+    return XST_SUCCESS;
+}
+
+void XAxiDma_BdRingGetCoalesce(XAxiDma_BdRing *RingPtr, u32 *CounterPtr,
+    u32 *TimerPtr)
+{
+    u32 Cr = XAxiDma_ReadReg(RingPtr->ChanBase, XAXIDMA_CR_OFFSET);
+
+    *CounterPtr = (Cr & XAXIDMA_COALESCE_MASK) >> XAXIDMA_COALESCE_SHIFT;
+    *TimerPtr = (Cr & XAXIDMA_DELAY_MASK) >> XAXIDMA_DELAY_SHIFT;
+}
+
+int XAxiDma_BdRingCheck(XAxiDma_BdRing *RingPtr)
+{
+    UINTPTR AddrV;
+    UINTPTR AddrP;
+    int i;
+
+    /* Is the list created */
+    if (RingPtr->AllCnt == 0)
+        return XST_DMA_SG_NO_LIST;
+
+    /* Can't check if channel is running */
+    if (RingPtr->RunState == AXIDMA_CHANNEL_NOT_HALTED)
+        return XST_DEVICE_IS_STARTED;
+
+    /* RunState doesn't make sense */
+    if (RingPtr->RunState != AXIDMA_CHANNEL_HALTED)
+        return XST_FAILURE;
+
+    /* Verify internal pointers point to correct memory space */
+    AddrV = (UINTPTR)RingPtr->FreeHead;
+    if ((AddrV < RingPtr->FirstBdAddr) || (AddrV > RingPtr->LastBdAddr))
+        return XST_DMA_SG_LIST_ERROR;
+    AddrV = (UINTPTR)RingPtr->PreHead;
+    if ((AddrV < RingPtr->FirstBdAddr) || (AddrV > RingPtr->LastBdAddr))
+        return XST_DMA_SG_LIST_ERROR;
+    AddrV = (UINTPTR)RingPtr->HwHead;
+    if ((AddrV < RingPtr->FirstBdAddr) || (AddrV > RingPtr->LastBdAddr))
+        return XST_DMA_SG_LIST_ERROR;
+    AddrV = (UINTPTR)RingPtr->HwTail;
+    if ((AddrV < RingPtr->FirstBdAddr) || (AddrV > RingPtr->LastBdAddr))
+        return XST_DMA_SG_LIST_ERROR;
+    AddrV = (UINTPTR)RingPtr->PostHead;
+    if ((AddrV < RingPtr->FirstBdAddr) || (AddrV > RingPtr->LastBdAddr))
+        return XST_DMA_SG_LIST_ERROR;
+
+    /* Verify internal counters add up */
+    if ((RingPtr->HwCnt + RingPtr->PreCnt + RingPtr->FreeCnt +
+            RingPtr->PostCnt) != RingPtr->AllCnt)
+        return XST_DMA_SG_LIST_ERROR;
+
+    /* Verify BDs are linked correctly */
+    AddrV = RingPtr->FirstBdAddr;
+    AddrP = RingPtr->FirstBdPhysAddr + RingPtr->Separation;
+    for (i = 1; i < RingPtr->AllCnt; i++) {
+        if ((XAxiDma_BdRead(AddrV, XAXIDMA_BD_NDESC_OFFSET)) !=
+                (u32)(AddrP & XAXIDMA_DESC_LSB_MASK))
+            return XST_DMA_SG_LIST_ERROR;
+
+        AddrV += RingPtr->Separation;
+        AddrP += RingPtr->Separation;
+    }
+
+    /* Last BD should point back to the beginning of ring */
+    if (XAxiDma_BdRead(AddrV, XAXIDMA_BD_NDESC_OFFSET) !=
+            (u32)(RingPtr->FirstBdPhysAddr & XAXIDMA_DESC_LSB_MASK))
+        return XST_DMA_SG_LIST_ERROR;
+
+    return XST_SUCCESS;
+}
+
+void XAxiDma_BdRingDumpRegs(XAxiDma_BdRing *RingPtr)
+{
+    UINTPTR RegBase = RingPtr->ChanBase;
+
+    printf("Dump registers %p:\r\n", (void *)RegBase);
+    printf("Control REG: %08x\r\n",
+        (unsigned int)XAxiDma_ReadReg(RegBase, XAXIDMA_CR_OFFSET));
+    printf("Status REG: %08x\r\n",
+        (unsigned int)XAxiDma_ReadReg(RegBase, XAXIDMA_SR_OFFSET));
+    printf("Cur BD REG: %08x\r\n",
+        (unsigned int)XAxiDma_ReadReg(RegBase, XAXIDMA_CDESC_OFFSET));
+    printf("Tail BD REG: %08x\r\n",
+        (unsigned int)XAxiDma_ReadReg(RegBase, XAXIDMA_TDESC_OFFSET));
+    printf("\r\n");
+}
+
+/******************************* DMA instance ********************************/
+
+static void XAxiDma_InitRing(XAxiDma_BdRing *RingPtr, UINTPTR ChanBase,
+    int IsRx, int HasDRE, int DataWidth, u32 MaxTransferLen)
+{
+    memset(RingPtr, 0, sizeof(*RingPtr));
+    RingPtr->RunState = AXIDMA_CHANNEL_HALTED;
+    RingPtr->IsRxChannel = IsRx;
+    RingPtr->ChanBase = ChanBase;
+    RingPtr->HasDRE = HasDRE;
+    RingPtr->DataWidth = DataWidth >> 3;
+    RingPtr->MaxTransferLen = MaxTransferLen;
+}
+
+XAxiDma_Config *XAxiDma_LookupConfig(u32 DeviceId)
+{
+    u32 i;
+
+    for (i = 0; i < XPAR_XAXIDMA_NUM_INSTANCES; i++) {
+        if (axiDmaConfigTable[i].DeviceId == DeviceId) {
+            axiDmaConfigTable[i].BaseAddr = simAxiDma_hwBase(DeviceId);
+            return &axiDmaConfigTable[i];
+        }
+    }
+
+    return NULL;
+}
+
+int XAxiDma_CfgInitialize(XAxiDma *InstancePtr, XAxiDma_Config *Config)
+{
+    u32 MaxTransferLen;
+    int TimeOut;
+
+    if (InstancePtr == NULL || Config == NULL)
+        return XST_INVALID_PARAM;
+
+    InstancePtr->Initialized = 0;
+    InstancePtr->RegBase = Config->BaseAddr;
+    if (InstancePtr->RegBase == 0)
+        return XST_DEVICE_NOT_FOUND;
+
+    InstancePtr->HasMm2S = Config->HasMm2S;
+    InstancePtr->HasS2Mm = Config->HasS2Mm;
+    InstancePtr->HasSg = Config->HasSg;
+    InstancePtr->MicroDmaMode = Config->MicroDmaMode;
+    InstancePtr->AddrWidth = Config->AddrWidth;
+    InstancePtr->TxNumChannels = Config->Mm2sNumChannels;
+    InstancePtr->RxNumChannels = Config->S2MmNumChannels;
+
+    MaxTransferLen = (1U << Config->SgLengthWidth) - 1;
+
+    XAxiDma_InitRing(&InstancePtr->TxBdRing,
+        InstancePtr->RegBase + XAXIDMA_TX_OFFSET, 0,
+        Config->HasMm2SDRE, Config->Mm2SDataWidth, MaxTransferLen);
+    XAxiDma_InitRing(&InstancePtr->RxBdRing[0],
+        InstancePtr->RegBase + XAXIDMA_RX_OFFSET, 1,
+        Config->HasS2MmDRE, Config->S2MmDataWidth, MaxTransferLen);
+
+    /* Reset the engine so the hardware starts from a known state */
+    XAxiDma_Reset(InstancePtr);
+
+    TimeOut = XAXIDMA_RESET_TIMEOUT;
+    while (TimeOut) {
+        if (XAxiDma_ResetIsDone(InstancePtr))
+            break;
+        TimeOut -= 1;
+    }
+
+    if (!TimeOut)
+        return XST_DMA_ERROR;
+
+    InstancePtr->Initialized = 1;
+
+    return XST_SUCCESS;
+}
+
+void XAxiDma_Reset(XAxiDma *InstancePtr)
+{
+    UINTPTR RegBase;
+
+    /* Save the locations of current BDs both rings are working on before
+     * the reset so later we can resume the rings smoothly. */
+    if (InstancePtr->HasMm2S) {
+        XAxiDma_BdRing *TxRingPtr = XAxiDma_GetTxRing(InstancePtr);
+
+        if (TxRingPtr->AllCnt)
+            TxRingPtr->BdaRestart = TxRingPtr->HwHead;
+        TxRingPtr->RunState = AXIDMA_CHANNEL_HALTED;
+    }
+
+    if (InstancePtr->HasS2Mm) {
+        XAxiDma_BdRing *RxRingPtr = XAxiDma_GetRxRing(InstancePtr);
+
+        if (RxRingPtr->AllCnt)
+            RxRingPtr->BdaRestart = RxRingPtr->HwHead;
+        RxRingPtr->RunState = AXIDMA_CHANNEL_HALTED;
+    }
+
+    /* Reset the whole core through whichever channel exists */
+    RegBase = InstancePtr->RegBase + (InstancePtr->HasMm2S ?
+        XAXIDMA_TX_OFFSET : XAXIDMA_RX_OFFSET);
+    XAxiDma_WriteReg(RegBase, XAXIDMA_CR_OFFSET, XAXIDMA_CR_RESET_MASK);
+}
+
+int XAxiDma_ResetIsDone(XAxiDma *InstancePtr)
+{
+    u32 RegisterValue;
+
+    if (InstancePtr->HasMm2S) {
+        RegisterValue = XAxiDma_ReadReg(InstancePtr->RegBase +
+            XAXIDMA_TX_OFFSET, XAXIDMA_CR_OFFSET);
+        if (RegisterValue & XAXIDMA_CR_RESET_MASK)
+            return 0;
+    }
+
+    if (InstancePtr->HasS2Mm) {
+        RegisterValue = XAxiDma_ReadReg(InstancePtr->RegBase +
+            XAXIDMA_RX_OFFSET, XAXIDMA_CR_OFFSET);
+        if (RegisterValue & XAXIDMA_CR_RESET_MASK)
+            return 0;
+    }
+
+    return 1;
+}
+
+int XAxiDma_Pause(XAxiDma *InstancePtr)
+{
+    XAxiDma_BdRing *RingPtr;
+
+    if (!InstancePtr->Initialized)
+        return XST_NOT_SGDMA;
+
+    if (InstancePtr->HasMm2S) {
+        RingPtr = XAxiDma_GetTxRing(InstancePtr);
+        XAxiDma_WriteReg(RingPtr->ChanBase, XAXIDMA_CR_OFFSET,
+            XAxiDma_ReadReg(RingPtr->ChanBase, XAXIDMA_CR_OFFSET) &
+            ~XAXIDMA_CR_RUNSTOP_MASK);
+        RingPtr->RunState = AXIDMA_CHANNEL_HALTED;
+    }
+
+    if (InstancePtr->HasS2Mm) {
+        RingPtr = XAxiDma_GetRxRing(InstancePtr);
+        XAxiDma_WriteReg(RingPtr->ChanBase, XAXIDMA_CR_OFFSET,
+            XAxiDma_ReadReg(RingPtr->ChanBase, XAXIDMA_CR_OFFSET) &
+            ~XAXIDMA_CR_RUNSTOP_MASK);
+        RingPtr->RunState = AXIDMA_CHANNEL_HALTED;
+    }
+
+    return XST_SUCCESS;
+}
+
+int XAxiDma_Resume(XAxiDma *InstancePtr)
+{
+    XAxiDma_BdRing *RingPtr;
+    int Status;
+
+    if (!InstancePtr->Initialized)
+        return XST_NOT_SGDMA;
+
+    if (InstancePtr->HasMm2S) {
+        RingPtr = XAxiDma_GetTxRing(InstancePtr);
+        if (RingPtr->RunState == AXIDMA_CHANNEL_HALTED) {
+            Status = XAxiDma_BdRingStart(RingPtr);
+            if (Status != XST_SUCCESS)
+                return Status;
+        }
+    }
+
+    if (InstancePtr->HasS2Mm) {
+        RingPtr = XAxiDma_GetRxRing(InstancePtr);
+        if (RingPtr->RunState == AXIDMA_CHANNEL_HALTED) {
+            Status = XAxiDma_BdRingStart(RingPtr);
+            if (Status != XST_SUCCESS)
+                return Status;
+        }
+    }
+
+    return XST_SUCCESS;
+}
+
+u32 XAxiDma_Busy(XAxiDma *InstancePtr, int Direction)
+{
+    XAxiDma_BdRing *RingPtr = (Direction == XAXIDMA_DMA_TO_DEVICE) ?
+        XAxiDma_GetTxRing(InstancePtr) : XAxiDma_GetRxRing(InstancePtr);
+
+    return XAxiDma_BdRingBusy(RingPtr) ? TRUE : FALSE;
+}
+
+int XAxiDma_SelectCyclicMode(XAxiDma *InstancePtr, int Direction, int Select)
+{
+    UINTPTR ChanBase = InstancePtr->RegBase +
+        ((Direction == XAXIDMA_DMA_TO_DEVICE) ?
+        XAXIDMA_TX_OFFSET : XAXIDMA_RX_OFFSET);
+    u32 Cr = XAxiDma_ReadReg(ChanBase, XAXIDMA_CR_OFFSET);
+
+    if (Select)
+        Cr |= XAXIDMA_CR_CYCLIC_MASK;
+    else
+        Cr &= ~XAXIDMA_CR_CYCLIC_MASK;
+
+    XAxiDma_WriteReg(ChanBase, XAXIDMA_CR_OFFSET, Cr);
+
+    return XST_SUCCESS;
+}
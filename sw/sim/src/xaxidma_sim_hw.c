@@ -0,0 +1,625 @@
+/**
+ * @brief  Host model of the AXI DMA core in SG mode with the MM2S stream
+ *         looped back to S2MM through an AXI4-Stream data FIFO, matching
+ *         the zybo.bd reference design.
+ *
+ *         Each core is a register file plus an engine thread. The CPU side
+ *         only touches the register file (through XAxiDma_ReadReg/WriteReg)
+ *         and the descriptors, exactly like software on the Zynq does. The
+ *         engine walks the descriptor chains through NDESC, moves data
+ *         through the FIFO honouring TLAST and backpressure, writes the
+ *         descriptor status words, runs the coalesce/delay interrupt logic
+ *         and raises the channel interrupt lines on the simulated GIC.
+ *
+ *         Simplifications against PG021:
+ *          - clearing RS or resetting abandons an in-flight descriptor
+ *          - reset is acknowledged before the register write returns
+ *          - the delay timer runs on host time, see SIM_AXIDMA_DELAY_TICK_NS
+ *
+ *         When it cannot make progress the engine sleeps on a doorbell that
+ *         every CPU register write rings, so the model also behaves on a
+ *         single core host where a spinning engine would starve the CPU.
+ */
+
+#define _GNU_SOURCE
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include "xaxidma.h"
+#include "sim_axidma.h"
+#include "sim_internal.h"
+
+/* Loopback FIFO size in bytes */
+#define FIFO_BYTES (XPAR_AXIS_DATA_FIFO_0_DEPTH * XPAR_AXIS_DATA_FIFO_0_TDATA_NUM_BYTES)
+
+/* Engine idle spins before it sleeps on the doorbell, multi core hosts only */
+#define ENGINE_IDLE_SPINS 2000
+
+#define REG(chan, off) ((chan)->regs[(off) / sizeof(u32)])
+
+struct simChan {
+    u32 *regs;          /* channel window inside the register file */
+    int isRx;
+    u32 irqId;
+
+    /* written by the CPU side */
+    u32 startSeq;       /* bumped on every RS transition */
+    u32 startTailSeq;   /* tailSeq at the time RS was set */
+    u32 tailSeq;        /* bumped on every TDESC write */
+    u32 injectErr;      /* BD error bits for the next descriptor */
+    u32 injectEofErr;   /* BD error bits for the next descriptor with TXEOF */
+    u32 dropIrqs;       /* interrupts still to swallow */
+
+    /* engine thread only */
+    u32 startSeen;
+    u32 tailSeen;
+    int running;
+    int active;         /* a tail was written that has not been reached */
+    UINTPTR tail;
+    UINTPTR cur;        /* next descriptor to fetch */
+    UINTPTR bd;         /* descriptor being worked on, 0 if none */
+    u8 *buf;
+    u32 len;
+    u32 off;
+    int sof;            /* next rx descriptor starts a packet */
+    u32 irqCount;       /* completions since the last interrupt */
+    u64 lastCmpltNs;
+};
+
+struct simDev {
+    u32 regs[XAXIDMA_REG_SPACE_SIZE / sizeof(u32)] __attribute__((aligned(64)));
+    struct simChan mm2s;
+    struct simChan s2mm;
+    u32 resetSeq;
+    u32 resetSeen;
+    u32 doorbell;       /* bumped on every CPU register write */
+    u32 sleeping;       /* engine is waiting on the doorbell */
+    int started;
+    pthread_t thread;
+    /* loopback FIFO, one TLAST flag per byte */
+    u8 fifo[FIFO_BYTES];
+    u8 fifoLast[FIFO_BYTES];
+    u64 fifoWr;
+    u64 fifoRd;
+};
+
+static struct simDev simDevs[XPAR_XAXIDMA_NUM_INSTANCES];
+static const u32 simIrqIds[XPAR_XAXIDMA_NUM_INSTANCES][2] = {
+    { XPAR_FABRIC_AXI_DMA_0_MM2S_INTROUT_INTR,
+      XPAR_FABRIC_AXI_DMA_0_S2MM_INTROUT_INTR }
+};
+static pthread_mutex_t simStartLock = PTHREAD_MUTEX_INITIALIZER;
+static int simIdleSpins;
+
+static u64 simAxiDma_nowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+static u32 ld(u32 *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void st(u32 *p, u32 v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+/******************************* Interrupts **********************************/
+
+static void simAxiDma_setIrq(struct simChan *chan, u32 mask)
+{
+    u32 drop;
+
+    __atomic_fetch_or(&REG(chan, XAXIDMA_SR_OFFSET), mask, __ATOMIC_SEQ_CST);
+    if (!(ld(&REG(chan, XAXIDMA_CR_OFFSET)) & mask))
+        return;
+
+    /* a lost interrupt still leaves its status bit behind */
+    drop = ld(&chan->dropIrqs);
+    while (drop && !__atomic_compare_exchange_n(&chan->dropIrqs, &drop, drop - 1,
+            0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+        ;
+    if (drop == 0)
+        simGic_raise(chan->irqId);
+}
+
+static void simAxiDma_halt(struct simChan *chan, u32 errMask)
+{
+    __atomic_fetch_and(&REG(chan, XAXIDMA_CR_OFFSET), ~XAXIDMA_CR_RUNSTOP_MASK,
+        __ATOMIC_SEQ_CST);
+    __atomic_fetch_or(&REG(chan, XAXIDMA_SR_OFFSET),
+        errMask | XAXIDMA_HALTED_MASK, __ATOMIC_SEQ_CST);
+    chan->running = 0;
+    chan->bd = 0;
+    simAxiDma_setIrq(chan, XAXIDMA_IRQ_ERROR_MASK);
+}
+
+/*
+ * Raises a completion irq and holds the engine until the CPU acknowledged it,
+ * so the completion handler reaps the bd just failed before the error irq
+ */
+static void simAxiDma_cmpltFirst(struct simChan *chan)
+{
+    if (!(ld(&REG(chan, XAXIDMA_CR_OFFSET)) & XAXIDMA_IRQ_IOC_MASK))
+        return;
+    simAxiDma_setIrq(chan, XAXIDMA_IRQ_IOC_MASK);
+    while (ld(&REG(chan, XAXIDMA_SR_OFFSET)) & XAXIDMA_IRQ_IOC_MASK)
+        sched_yield();
+}
+
+/* Returns ns until the delay timer of the channel expires, 0 if not armed */
+static u64 simAxiDma_delayTimer(struct simChan *chan, u64 now)
+{
+    u32 delay = (ld(&REG(chan, XAXIDMA_CR_OFFSET)) & XAXIDMA_DELAY_MASK) >>
+        XAXIDMA_DELAY_SHIFT;
+    u64 expiry = chan->lastCmpltNs + (u64)delay * SIM_AXIDMA_DELAY_TICK_NS;
+
+    if (chan->irqCount == 0 || delay == 0)
+        return 0;
+    if (now < expiry)
+        return expiry - now;
+    chan->irqCount = 0;
+    simAxiDma_setIrq(chan, XAXIDMA_IRQ_DELAY_MASK);
+    return 0;
+}
+
+/******************************* Descriptors *********************************/
+
+static UINTPTR simAxiDma_bdNext(UINTPTR bd)
+{
+    return (UINTPTR)XAxiDma_BdRead(bd, XAXIDMA_BD_NDESC_OFFSET) |
+        ((UINTPTR)((u64)XAxiDma_BdRead(bd, XAXIDMA_BD_NDESC_MSB_OFFSET) << 32));
+}
+
+static void simAxiDma_refreshTail(struct simChan *chan)
+{
+    u32 seq = ld(&chan->tailSeq);
+
+    if (seq == chan->tailSeen)
+        return;
+    chan->tailSeen = seq;
+    chan->tail = (UINTPTR)ld(&REG(chan, XAXIDMA_TDESC_OFFSET)) |
+        ((UINTPTR)((u64)ld(&REG(chan, XAXIDMA_TDESC_MSB_OFFSET)) << 32));
+    if (!chan->active) {
+        chan->active = 1;
+        __atomic_fetch_and(&REG(chan, XAXIDMA_SR_OFFSET), ~XAXIDMA_IDLE_MASK,
+            __ATOMIC_SEQ_CST);
+    }
+}
+
+/* Returns 1 when chan->bd holds a descriptor ready to move data */
+static int simAxiDma_fetch(struct simChan *chan)
+{
+    u32 cr;
+    u32 err;
+    int eofErr = 0;
+
+    if (chan->bd)
+        return 1;
+    if (!chan->running || !chan->active)
+        return 0;
+
+    cr = ld(&REG(chan, XAXIDMA_CR_OFFSET));
+    if (!(cr & XAXIDMA_CR_CYCLIC_MASK) &&
+            (XAxiDma_BdRead(chan->cur, XAXIDMA_BD_STS_OFFSET) &
+            XAXIDMA_BD_STS_COMPLETE_MASK)) {
+        /* descriptor already owned by software */
+        simAxiDma_halt(chan, XAXIDMA_ERR_SG_INT_MASK);
+        return 0;
+    }
+
+    chan->bd = chan->cur;
+    st(&REG(chan, XAXIDMA_CDESC_OFFSET), (u32)chan->bd);
+    st(&REG(chan, XAXIDMA_CDESC_MSB_OFFSET), (u32)((u64)chan->bd >> 32));
+    chan->buf = (u8 *)((UINTPTR)XAxiDma_BdRead(chan->bd, XAXIDMA_BD_BUFA_OFFSET) |
+        ((UINTPTR)((u64)XAxiDma_BdRead(chan->bd, XAXIDMA_BD_BUFA_MSB_OFFSET) << 32)));
+    chan->len = XAxiDma_BdRead(chan->bd, XAXIDMA_BD_CTRL_LEN_OFFSET) &
+        XAXIDMA_BD_CTRL_LENGTH_MASK;
+    chan->off = 0;
+
+    err = __atomic_exchange_n(&chan->injectErr, 0, __ATOMIC_SEQ_CST);
+    if (!err && !chan->isRx &&
+        (XAxiDma_BdRead(chan->bd, XAXIDMA_BD_CTRL_LEN_OFFSET) & XAXIDMA_BD_CTRL_TXEOF_MASK)) {
+        err = __atomic_exchange_n(&chan->injectEofErr, 0, __ATOMIC_SEQ_CST);
+        eofErr = err != 0;
+    }
+    if (chan->len == 0 && !err)
+        err = XAXIDMA_BD_STS_INT_ERR_MASK;
+    if (err) {
+        u32 srErr = XAXIDMA_ERR_INTERNAL_MASK;
+
+        if (err & XAXIDMA_BD_STS_DEC_ERR_MASK)
+            srErr = XAXIDMA_ERR_DECODE_MASK;
+        else if (err & XAXIDMA_BD_STS_SLV_ERR_MASK)
+            srErr = XAXIDMA_ERR_SLAVE_MASK;
+        XAxiDma_BdWrite(chan->bd, XAXIDMA_BD_STS_OFFSET,
+            XAXIDMA_BD_STS_COMPLETE_MASK | (err & XAXIDMA_BD_STS_ALL_ERR_MASK));
+        if (eofErr)
+            simAxiDma_cmpltFirst(chan);
+        simAxiDma_halt(chan, srErr);
+        return 0;
+    }
+
+    return 1;
+}
+
+static void simAxiDma_complete(struct simChan *chan, u32 sts)
+{
+    u32 thresh;
+    u32 cr = ld(&REG(chan, XAXIDMA_CR_OFFSET));
+
+    XAxiDma_BdWrite(chan->bd, XAXIDMA_BD_STS_OFFSET,
+        XAXIDMA_BD_STS_COMPLETE_MASK | sts);
+
+    if (!(cr & XAXIDMA_CR_CYCLIC_MASK) && chan->bd == chan->tail) {
+        chan->active = 0;
+        __atomic_fetch_or(&REG(chan, XAXIDMA_SR_OFFSET), XAXIDMA_IDLE_MASK,
+            __ATOMIC_SEQ_CST);
+    }
+    chan->cur = simAxiDma_bdNext(chan->bd);
+    chan->bd = 0;
+
+    chan->lastCmpltNs = simAxiDma_nowNs();
+    thresh = (cr & XAXIDMA_COALESCE_MASK) >> XAXIDMA_COALESCE_SHIFT;
+    if (++chan->irqCount >= (thresh ? thresh : 1)) {
+        chan->irqCount = 0;
+        simAxiDma_setIrq(chan, XAXIDMA_IRQ_IOC_MASK);
+    }
+}
+
+/******************************* Data movers *********************************/
+
+static int simAxiDma_mm2sStep(struct simDev *dev)
+{
+    struct simChan *chan = &dev->mm2s;
+    u32 space;
+    u32 n;
+
+    if (!simAxiDma_fetch(chan))
+        return 0;
+
+    space = FIFO_BYTES - (u32)(dev->fifoWr - dev->fifoRd);
+    n = chan->len - chan->off;
+    if (n > space)
+        n = space;
+    if (n == 0)
+        return 0;
+
+    while (n) {
+        u32 idx = (u32)(dev->fifoWr % FIFO_BYTES);
+        u32 run = FIFO_BYTES - idx;
+
+        if (run > n)
+            run = n;
+        memcpy(&dev->fifo[idx], chan->buf + chan->off, run);
+        memset(&dev->fifoLast[idx], 0, run);
+        dev->fifoWr += run;
+        chan->off += run;
+        n -= run;
+    }
+
+    if (chan->off == chan->len) {
+        if (XAxiDma_BdRead(chan->bd, XAXIDMA_BD_CTRL_LEN_OFFSET) &
+                XAXIDMA_BD_CTRL_TXEOF_MASK)
+            dev->fifoLast[(dev->fifoWr - 1) % FIFO_BYTES] = 1;
+        simAxiDma_complete(chan, chan->len);
+    }
+
+    return 1;
+}
+
+static int simAxiDma_s2mmStep(struct simDev *dev)
+{
+    struct simChan *chan = &dev->s2mm;
+    int last = 0;
+    u32 avail = (u32)(dev->fifoWr - dev->fifoRd);
+    u32 n;
+
+    if (avail == 0)
+        return 0;
+    if (!simAxiDma_fetch(chan))
+        return 0;
+
+    n = chan->len - chan->off;
+    if (n > avail)
+        n = avail;
+
+    while (n && !last) {
+        u32 idx = (u32)(dev->fifoRd % FIFO_BYTES);
+        u32 run = FIFO_BYTES - idx;
+        u8 *eop;
+
+        if (run > n)
+            run = n;
+        eop = memchr(&dev->fifoLast[idx], 1, run);
+        if (eop != NULL) {
+            run = (u32)(eop - &dev->fifoLast[idx]) + 1;
+            last = 1;
+        }
+        memcpy(chan->buf + chan->off, &dev->fifo[idx], run);
+        dev->fifoRd += run;
+        chan->off += run;
+        n -= run;
+    }
+
+    if (last || chan->off == chan->len) {
+        u32 sts = chan->off;
+
+        if (chan->sof)
+            sts |= XAXIDMA_BD_STS_RXSOF_MASK;
+        if (last)
+            sts |= XAXIDMA_BD_STS_RXEOF_MASK;
+        chan->sof = last;
+        simAxiDma_complete(chan, sts);
+    }
+
+    return 1;
+}
+
+/******************************* Engine **************************************/
+
+static void simAxiDma_chanReset(struct simChan *chan)
+{
+    chan->running = 0;
+    chan->active = 0;
+    chan->bd = 0;
+    chan->sof = 1;
+    chan->irqCount = 0;
+    chan->startSeen = ld(&chan->startSeq);
+    chan->tailSeen = ld(&chan->tailSeq);
+    st(&chan->injectErr, 0);
+    st(&chan->injectEofErr, 0);
+    st(&chan->dropIrqs, 0);
+    st(&REG(chan, XAXIDMA_SR_OFFSET), XAXIDMA_HALTED_MASK);
+}
+
+static void simAxiDma_chanRunStop(struct simChan *chan)
+{
+    u32 seq = ld(&chan->startSeq);
+
+    if (seq == chan->startSeen)
+        return;
+    chan->startSeen = seq;
+    chan->bd = 0;
+    chan->active = 0;
+
+    if ((ld(&REG(chan, XAXIDMA_CR_OFFSET)) & XAXIDMA_CR_RUNSTOP_MASK) &&
+            !(ld(&REG(chan, XAXIDMA_SR_OFFSET)) & XAXIDMA_HALTED_MASK)) {
+        chan->running = 1;
+        chan->cur = (UINTPTR)ld(&REG(chan, XAXIDMA_CDESC_OFFSET)) |
+            ((UINTPTR)((u64)ld(&REG(chan, XAXIDMA_CDESC_MSB_OFFSET)) << 32));
+        chan->tailSeen = ld(&chan->startTailSeq);
+        __atomic_fetch_or(&REG(chan, XAXIDMA_SR_OFFSET), XAXIDMA_IDLE_MASK,
+            __ATOMIC_SEQ_CST);
+    } else {
+        chan->running = 0;
+    }
+}
+
+static void simAxiDma_ring(struct simDev *dev)
+{
+    __atomic_fetch_add(&dev->doorbell, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&dev->sleeping, __ATOMIC_SEQ_CST))
+        syscall(SYS_futex, &dev->doorbell, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+static void simAxiDma_sleep(struct simDev *dev, u32 bell, u64 timeoutNs)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(timeoutNs / 1000000000ULL);
+    ts.tv_nsec = (long)(timeoutNs % 1000000000ULL);
+
+    __atomic_store_n(&dev->sleeping, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&dev->doorbell, __ATOMIC_SEQ_CST) == bell)
+        syscall(SYS_futex, &dev->doorbell, FUTEX_WAIT_PRIVATE, bell,
+            timeoutNs ? &ts : NULL, NULL, 0);
+    __atomic_store_n(&dev->sleeping, 0, __ATOMIC_SEQ_CST);
+}
+
+static void *simAxiDma_engine(void *arg)
+{
+    struct simDev *dev = arg;
+    int idle = 0;
+
+    for (;;) {
+        int progress = 0;
+        u64 now;
+        u64 wait;
+        u64 txWait;
+        u32 bell = ld(&dev->doorbell);
+        u32 seq = ld(&dev->resetSeq);
+
+        if (seq != dev->resetSeen) {
+            simAxiDma_chanReset(&dev->mm2s);
+            simAxiDma_chanReset(&dev->s2mm);
+            dev->fifoWr = 0;
+            dev->fifoRd = 0;
+            st(&REG(&dev->mm2s, XAXIDMA_CR_OFFSET), 0);
+            st(&REG(&dev->s2mm, XAXIDMA_CR_OFFSET), 0);
+            st(&dev->resetSeen, seq);
+            continue;
+        }
+
+        simAxiDma_chanRunStop(&dev->mm2s);
+        simAxiDma_chanRunStop(&dev->s2mm);
+        simAxiDma_refreshTail(&dev->mm2s);
+        simAxiDma_refreshTail(&dev->s2mm);
+
+        progress |= simAxiDma_mm2sStep(dev);
+        progress |= simAxiDma_s2mmStep(dev);
+
+        now = simAxiDma_nowNs();
+        txWait = simAxiDma_delayTimer(&dev->mm2s, now);
+        wait = simAxiDma_delayTimer(&dev->s2mm, now);
+        if (txWait && (!wait || txWait < wait))
+            wait = txWait;
+
+        if (progress) {
+            idle = 0;
+        } else if (++idle < simIdleSpins) {
+            sched_yield();
+        } else {
+            simAxiDma_sleep(dev, bell, wait);
+            idle = 0;
+        }
+    }
+
+    return NULL;
+}
+
+/******************************* Register file *******************************/
+
+static struct simDev *simAxiDma_devOf(UINTPTR addr, u32 *off)
+{
+    u32 i;
+
+    for (i = 0; i < XPAR_XAXIDMA_NUM_INSTANCES; i++) {
+        UINTPTR base = (UINTPTR)simDevs[i].regs;
+
+        if (addr >= base && addr < base + XAXIDMA_REG_SPACE_SIZE) {
+            *off = (u32)(addr - base);
+            return &simDevs[i];
+        }
+    }
+
+    return NULL;
+}
+
+UINTPTR simAxiDma_hwBase(u32 deviceId)
+{
+    struct simDev *dev;
+
+    if (deviceId >= XPAR_XAXIDMA_NUM_INSTANCES)
+        return 0;
+    dev = &simDevs[deviceId];
+
+    pthread_mutex_lock(&simStartLock);
+    if (!dev->started) {
+        dev->mm2s.regs = &dev->regs[XAXIDMA_TX_OFFSET / sizeof(u32)];
+        dev->mm2s.isRx = 0;
+        dev->mm2s.irqId = simIrqIds[deviceId][0];
+        dev->s2mm.regs = &dev->regs[XAXIDMA_RX_OFFSET / sizeof(u32)];
+        dev->s2mm.isRx = 1;
+        dev->s2mm.irqId = simIrqIds[deviceId][1];
+        simAxiDma_chanReset(&dev->mm2s);
+        simAxiDma_chanReset(&dev->s2mm);
+        simIdleSpins = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? ENGINE_IDLE_SPINS : 0;
+        pthread_create(&dev->thread, NULL, simAxiDma_engine, dev);
+        dev->started = 1;
+    }
+    pthread_mutex_unlock(&simStartLock);
+
+    return (UINTPTR)dev->regs;
+}
+
+u32 simAxiDma_regRead(UINTPTR addr)
+{
+    return ld((u32 *)addr);
+}
+
+void simAxiDma_regWrite(UINTPTR addr, u32 data)
+{
+    u32 off;
+    u32 old;
+    struct simDev *dev = simAxiDma_devOf(addr, &off);
+    struct simChan *chan;
+
+    if (dev == NULL) {
+        st((u32 *)addr, data);
+        return;
+    }
+
+    chan = (off >= XAXIDMA_RX_OFFSET) ? &dev->s2mm : &dev->mm2s;
+    off %= XAXIDMA_RX_OFFSET;
+
+    switch (off) {
+    case XAXIDMA_CR_OFFSET:
+        if (data & XAXIDMA_CR_RESET_MASK) {
+            u32 seq = ld(&dev->resetSeq) + 1;
+
+            st(&REG(&dev->mm2s, XAXIDMA_CR_OFFSET), XAXIDMA_CR_RESET_MASK);
+            st(&REG(&dev->s2mm, XAXIDMA_CR_OFFSET), XAXIDMA_CR_RESET_MASK);
+            st(&dev->resetSeq, seq);
+            simAxiDma_ring(dev);
+            while (ld(&dev->resetSeen) != seq)
+                sched_yield();
+            break;
+        }
+        old = ld(&REG(chan, XAXIDMA_CR_OFFSET));
+        st(&REG(chan, XAXIDMA_CR_OFFSET), data);
+        if (!(old & XAXIDMA_CR_RUNSTOP_MASK) && (data & XAXIDMA_CR_RUNSTOP_MASK)) {
+            /* a channel with latched errors stays halted until reset */
+            if (!(ld(&REG(chan, XAXIDMA_SR_OFFSET)) & XAXIDMA_ERR_ALL_MASK))
+                __atomic_fetch_and(&REG(chan, XAXIDMA_SR_OFFSET),
+                    ~XAXIDMA_HALTED_MASK, __ATOMIC_SEQ_CST);
+            st(&chan->startTailSeq, ld(&chan->tailSeq));
+            __atomic_fetch_add(&chan->startSeq, 1, __ATOMIC_SEQ_CST);
+        } else if ((old & XAXIDMA_CR_RUNSTOP_MASK) && !(data & XAXIDMA_CR_RUNSTOP_MASK)) {
+            __atomic_fetch_or(&REG(chan, XAXIDMA_SR_OFFSET),
+                XAXIDMA_HALTED_MASK, __ATOMIC_SEQ_CST);
+            __atomic_fetch_add(&chan->startSeq, 1, __ATOMIC_SEQ_CST);
+        }
+        /* enabling an interrupt that is already pending asserts the line */
+        if (ld(&REG(chan, XAXIDMA_SR_OFFSET)) & data & XAXIDMA_IRQ_ALL_MASK)
+            simGic_raise(chan->irqId);
+        break;
+    case XAXIDMA_SR_OFFSET:
+        /* interrupt bits are write one to clear, the rest read only */
+        __atomic_fetch_and(&REG(chan, XAXIDMA_SR_OFFSET),
+            ~(data & XAXIDMA_IRQ_ALL_MASK), __ATOMIC_SEQ_CST);
+        break;
+    case XAXIDMA_TDESC_OFFSET:
+        st(&REG(chan, XAXIDMA_TDESC_OFFSET), data);
+        __atomic_fetch_add(&chan->tailSeq, 1, __ATOMIC_SEQ_CST);
+        break;
+    default:
+        st((u32 *)addr, data);
+        break;
+    }
+
+    simAxiDma_ring(dev);
+}
+
+void simAxiDma_injectBdError(u32 deviceId, int direction, u32 stsErrMask)
+{
+    struct simDev *dev;
+
+    if (deviceId >= XPAR_XAXIDMA_NUM_INSTANCES)
+        return;
+    dev = &simDevs[deviceId];
+    st(direction == XAXIDMA_DMA_TO_DEVICE ? &dev->mm2s.injectErr :
+        &dev->s2mm.injectErr, stsErrMask & XAXIDMA_BD_STS_ALL_ERR_MASK);
+    simAxiDma_ring(dev);
+}
+
+void simAxiDma_injectTxEofError(u32 deviceId, u32 stsErrMask)
+{
+    struct simDev *dev;
+
+    if (deviceId >= XPAR_XAXIDMA_NUM_INSTANCES)
+        return;
+    dev = &simDevs[deviceId];
+    st(&dev->mm2s.injectEofErr, stsErrMask & XAXIDMA_BD_STS_ALL_ERR_MASK);
+    simAxiDma_ring(dev);
+}
+
+void simAxiDma_dropIrqs(u32 deviceId, int direction, u32 count)
+{
+    struct simDev *dev;
+
+    if (deviceId >= XPAR_XAXIDMA_NUM_INSTANCES)
+        return;
+    dev = &simDevs[deviceId];
+    st(direction == XAXIDMA_DMA_TO_DEVICE ? &dev->mm2s.dropIrqs :
+        &dev->s2mm.dropIrqs, count);
+}
@@ -0,0 +1,75 @@
+/**
+ * @brief  Host simulation of the standalone BSP memory and timer services:
+ *         maps the DDR window described in xparameters.h, stubs cache and
+ *         MMU maintenance and backs the global timer with CLOCK_MONOTONIC.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include "xparameters.h"
+#include "xil_cache.h"
+#include "xil_mmu.h"
+#include "xtime_l.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#define DDR_SIZE (XPAR_PS7_DDR_0_S_AXI_HIGHADDR - XPAR_PS7_DDR_0_S_AXI_BASEADDR + 1)
+
+static void simXil_mapDdr(void) __attribute__((constructor));
+
+static void simXil_mapDdr(void)
+{
+    void *ddr;
+
+    ddr = mmap((void *)(UINTPTR)XPAR_PS7_DDR_0_S_AXI_BASEADDR, DDR_SIZE,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (ddr != (void *)(UINTPTR)XPAR_PS7_DDR_0_S_AXI_BASEADDR) {
+        fprintf(stderr, "sim: could not map DDR window at 0x%x\n",
+            (unsigned int)XPAR_PS7_DDR_0_S_AXI_BASEADDR);
+        abort();
+    }
+}
+
+void Xil_SetTlbAttributes(UINTPTR Addr, u32 attrib)
+{
+    (void)Addr;
+    (void)attrib;
+}
+
+void Xil_DCacheEnable(void) {}
+void Xil_DCacheDisable(void) {}
+void Xil_DCacheFlush(void) {}
+void Xil_DCacheInvalidate(void) {}
+void Xil_ICacheEnable(void) {}
+void Xil_ICacheDisable(void) {}
+
+void Xil_DCacheFlushRange(INTPTR adr, u32 len)
+{
+    (void)adr;
+    (void)len;
+}
+
+void Xil_DCacheInvalidateRange(INTPTR adr, u32 len)
+{
+    (void)adr;
+    (void)len;
+}
+
+void XTime_SetTime(XTime Xtime_Global)
+{
+    (void)Xtime_Global;
+}
+
+void XTime_GetTime(XTime *Xtime_Global)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    *Xtime_Global = (XTime)ts.tv_sec * 1000000000ULL + (XTime)ts.tv_nsec;
+}
@@ -0,0 +1,221 @@
+/**
+ * @brief  Host simulation of the SCU GIC and the ARM IRQ exception.
+ *
+ *         Interrupt lines are latched in a pending bitmap. Raising a line
+ *         sends SIM_IRQ_SIGNAL to the thread that enabled exceptions; the
+ *         signal handler plays the part of the IRQ vector and runs the
+ *         registered exception handler (normally XScuGic_InterruptHandler)
+ *         on that thread, preempting it like a real interrupt. Masking
+ *         exceptions blocks the signal.
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include "xscugic.h"
+#include "sim_internal.h"
+
+#define SIM_IRQ_SIGNAL SIGUSR1
+#define GIC_WORDS ((XSCUGIC_MAX_NUM_INTR_INPUTS + 31U) / 32U)
+
+static XScuGic_Config gicConfigTable[XPAR_SCUGIC_NUM_INSTANCES] = {
+    { XPAR_SCUGIC_0_DEVICE_ID, 0xF8F00100U, 0xF8F01000U, {{0}} }
+};
+
+static u32 gicPending[GIC_WORDS];
+static u32 gicEnabled[GIC_WORDS];
+static u8 gicPriority[XSCUGIC_MAX_NUM_INTR_INPUTS];
+
+static pthread_t cpuThread;
+static int cpuThreadValid;
+static Xil_ExceptionHandler irqHandler;
+static void *irqHandlerData;
+
+static void simGic_kick(void)
+{
+    if (__atomic_load_n(&cpuThreadValid, __ATOMIC_ACQUIRE))
+        pthread_kill(cpuThread, SIM_IRQ_SIGNAL);
+}
+
+static void simGic_irqVector(int sig)
+{
+    (void)sig;
+    if (irqHandler != NULL)
+        irqHandler(irqHandlerData);
+}
+
+static void simGic_installVector(void) __attribute__((constructor));
+
+static void simGic_installVector(void)
+{
+    struct sigaction sa;
+    sigset_t set;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = simGic_irqVector;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIM_IRQ_SIGNAL, &sa, NULL);
+
+    /* IRQs start masked, every thread created later inherits this */
+    sigemptyset(&set);
+    sigaddset(&set, SIM_IRQ_SIGNAL);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+}
+
+void simGic_raise(u32 intId)
+{
+    if (intId >= XSCUGIC_MAX_NUM_INTR_INPUTS)
+        return;
+    __atomic_fetch_or(&gicPending[intId / 32U], 1U << (intId % 32U),
+        __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&gicEnabled[intId / 32U], __ATOMIC_ACQUIRE) &
+            (1U << (intId % 32U)))
+        simGic_kick();
+}
+
+void Xil_ExceptionInit(void)
+{
+}
+
+void Xil_ExceptionRegisterHandler(u32 Exception_id,
+    Xil_ExceptionHandler Handler, void *Data)
+{
+    if (Exception_id != XIL_EXCEPTION_ID_INT)
+        return;
+    irqHandlerData = Data;
+    irqHandler = Handler;
+}
+
+void Xil_ExceptionRemoveHandler(u32 Exception_id)
+{
+    if (Exception_id != XIL_EXCEPTION_ID_INT)
+        return;
+    irqHandler = NULL;
+    irqHandlerData = NULL;
+}
+
+void Xil_ExceptionEnable(void)
+{
+    sigset_t set;
+
+    cpuThread = pthread_self();
+    __atomic_store_n(&cpuThreadValid, 1, __ATOMIC_RELEASE);
+
+    sigemptyset(&set);
+    sigaddset(&set, SIM_IRQ_SIGNAL);
+    pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+
+    /* pick up anything latched while masked */
+    simGic_kick();
+}
+
+void Xil_ExceptionDisable(void)
+{
+    sigset_t set;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIM_IRQ_SIGNAL);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+}
+
+XScuGic_Config *XScuGic_LookupConfig(u16 DeviceId)
+{
+    (void)DeviceId;
+    return &gicConfigTable[0];
+}
+
+s32 XScuGic_CfgInitialize(XScuGic *InstancePtr, XScuGic_Config *ConfigPtr,
+    u32 EffectiveAddr)
+{
+    (void)EffectiveAddr;
+    if (InstancePtr == NULL || ConfigPtr == NULL)
+        return XST_INVALID_PARAM;
+    InstancePtr->Config = ConfigPtr;
+    InstancePtr->UnhandledInterrupts = 0;
+    InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+    return XST_SUCCESS;
+}
+
+s32 XScuGic_Connect(XScuGic *InstancePtr, u32 Int_Id,
+    Xil_InterruptHandler Handler, void *CallBackRef)
+{
+    if (Int_Id >= XSCUGIC_MAX_NUM_INTR_INPUTS || Handler == NULL)
+        return XST_INVALID_PARAM;
+    InstancePtr->Config->HandlerTable[Int_Id].CallBackRef = CallBackRef;
+    InstancePtr->Config->HandlerTable[Int_Id].Handler = Handler;
+    return XST_SUCCESS;
+}
+
+void XScuGic_Disconnect(XScuGic *InstancePtr, u32 Int_Id)
+{
+    if (Int_Id >= XSCUGIC_MAX_NUM_INTR_INPUTS)
+        return;
+    XScuGic_Disable(InstancePtr, Int_Id);
+    InstancePtr->Config->HandlerTable[Int_Id].Handler = NULL;
+    InstancePtr->Config->HandlerTable[Int_Id].CallBackRef = NULL;
+}
+
+void XScuGic_Enable(XScuGic *InstancePtr, u32 Int_Id)
+{
+    (void)InstancePtr;
+    if (Int_Id >= XSCUGIC_MAX_NUM_INTR_INPUTS)
+        return;
+    __atomic_fetch_or(&gicEnabled[Int_Id / 32U], 1U << (Int_Id % 32U),
+        __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&gicPending[Int_Id / 32U], __ATOMIC_ACQUIRE) &
+            (1U << (Int_Id % 32U)))
+        simGic_kick();
+}
+
+void XScuGic_Disable(XScuGic *InstancePtr, u32 Int_Id)
+{
+    (void)InstancePtr;
+    if (Int_Id >= XSCUGIC_MAX_NUM_INTR_INPUTS)
+        return;
+    __atomic_fetch_and(&gicEnabled[Int_Id / 32U], ~(1U << (Int_Id % 32U)),
+        __ATOMIC_SEQ_CST);
+}
+
+void XScuGic_SetPriorityTriggerType(XScuGic *InstancePtr, u32 Int_Id,
+    u8 Priority, u8 Trigger)
+{
+    (void)InstancePtr;
+    (void)Trigger;
+    if (Int_Id >= XSCUGIC_MAX_NUM_INTR_INPUTS)
+        return;
+    gicPriority[Int_Id] = Priority;
+}
+
+void XScuGic_InterruptHandler(XScuGic *InstancePtr)
+{
+    u32 w;
+    u32 active;
+    int serviced;
+
+    /* priorities are recorded but not used, lines are serviced lowest id first */
+    do {
+        serviced = 0;
+        for (w = 0; w < GIC_WORDS; w++) {
+            active = __atomic_load_n(&gicPending[w], __ATOMIC_ACQUIRE) &
+                __atomic_load_n(&gicEnabled[w], __ATOMIC_ACQUIRE);
+            while (active) {
+                u32 bit = (u32)__builtin_ctz(active);
+                u32 intId = w * 32U + bit;
+                XScuGic_VectorTableEntry *entry;
+
+                active &= ~(1U << bit);
+                __atomic_fetch_and(&gicPending[w], ~(1U << bit),
+                    __ATOMIC_SEQ_CST);
+
+                entry = &InstancePtr->Config->HandlerTable[intId];
+                if (entry->Handler != NULL)
+                    entry->Handler(entry->CallBackRef);
+                else
+                    InstancePtr->UnhandledInterrupts++;
+                serviced = 1;
+            }
+        }
+    } while (serviced);
+}
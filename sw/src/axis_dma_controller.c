@@ -8,7 +8,10 @@
 #include "xil_exception.h"
 #include "xdebug.h"
 #include "xil_mmu.h"
+#include "xil_cache.h"
+#include "xtime_l.h"
 #include "stdio.h"
+#include "string.h"
 #include "axis_dma_controller.h"
 
 /******************** Constant Definitions **********************************/
@@ -19,9 +22,208 @@
 #define RESET_TIMEOUT_COUNTER 10000
 #define DELAY_TIMER_COUNT 100
 
+#define RXQ_MASK (AXISDMA_RXQ_DEPTH - 1)
+#if (AXISDMA_RXQ_DEPTH & RXQ_MASK) != 0
+#error "AXISDMA_RXQ_DEPTH must be a power of 2"
+#endif
+
+#define TXQ_MASK (AXISDMA_TXQ_MAX - 1)
+#if (AXISDMA_TXQ_MAX & TXQ_MASK) != 0
+#error "AXISDMA_TXQ_MAX must be a power of 2"
+#endif
+#if AXISDMA_TXQ_PRIOS < 2
+#error "AXISDMA_TXQ_PRIOS must be at least 2"
+#endif
+
+#define TRACE_MASK (AXISDMA_TRACE_DEPTH - 1)
+#if (AXISDMA_TRACE_DEPTH & TRACE_MASK) != 0
+#error "AXISDMA_TRACE_DEPTH must be a power of 2"
+#endif
+
+/*
+ * Geometry used by the hot paths, compile time constants in the
+ * AXISDMA_STATIC_* build so that the divisions and modulos below fold into
+ * shifts and masks and a disabled channel drops out.
+ */
+#ifdef AXISDMA_STATIC_BD_BUF_SIZE
+#define BD_BUF_SIZE(inst) ((u32)AXISDMA_STATIC_BD_BUF_SIZE)
+#else
+#define BD_BUF_SIZE(inst) ((u32)(inst)->params.bd_buf_size)
+#endif
+#ifdef AXISDMA_STATIC_TX_BDS
+#if AXISDMA_STATIC_TX_BDS > AXISDMA_TX_BD_MAX
+#error "AXISDMA_STATIC_TX_BDS exceeds AXISDMA_TX_BD_MAX"
+#endif
+#define TX_BDS(ringPtr) ((u32)AXISDMA_STATIC_TX_BDS)
+#else
+#define TX_BDS(ringPtr) ((u32)(ringPtr)->AllCnt)
+#endif
+#ifdef AXISDMA_STATIC_RX_BDS
+#define RX_BDS(ringPtr) ((u32)AXISDMA_STATIC_RX_BDS)
+#else
+#define RX_BDS(ringPtr) ((u32)(ringPtr)->AllCnt)
+#endif
+/* both rings are created with this alignment, which a bd fills exactly */
+#if defined(AXISDMA_STATIC_TX_BDS) || defined(AXISDMA_STATIC_RX_BDS)
+#define BD_SEP(ringPtr) ((u32)XAXIDMA_BD_MINIMUM_ALIGNMENT)
+#else
+#define BD_SEP(ringPtr) ((u32)(ringPtr)->Separation)
+#endif
+#ifdef AXISDMA_STATIC_TXEN
+#define TX_EN(inst) (AXISDMA_STATIC_TXEN)
+#else
+#define TX_EN(inst) ((inst)->params.txEn)
+#endif
+#ifdef AXISDMA_STATIC_RXEN
+#define RX_EN(inst) (AXISDMA_STATIC_RXEN)
+#else
+#define RX_EN(inst) ((inst)->params.rxEn)
+#endif
+#if defined(AXISDMA_STATIC_TXEN) && defined(AXISDMA_STATIC_RXEN) && !AXISDMA_STATIC_TXEN && !AXISDMA_STATIC_RXEN
+#error "AXISDMA_STATIC_TXEN and AXISDMA_STATIC_RXEN cannot both be 0"
+#endif
+
 /**************************** Type Definitions *******************************/
+/* completed rx bd as queued by the isr in deferred mode */
+struct rxq_entry {
+    uint32_t addr;
+    uint32_t len;
+    u32 sts;
+};
+
+/* packet waiting in the tx software queue */
+struct txq_entry {
+    uint8_t *buf;
+    size_t len;
+    void *cookie;
+};
+
+/* one priority of the tx software queue */
+struct txQueue {
+    struct txq_entry ent[AXISDMA_TXQ_MAX];
+    uint32_t head;
+    uint32_t cnt;
+};
+
+/* runtime state of an adaptive coalescing policy */
+struct coalesceState {
+    u32 count;
+    XTime lastIrq;
+};
+
+/* progress of one ring as last seen by axisDmaCtrl_watchdog */
+struct stallState {
+    XAxiDma_Bd *head;
+    XTime since;
+};
+
+/* everything one controller instance owns, handed out by axisDmaCtrl_init */
+struct axisDmaCtrl {
+    int inUse;
+    XAxiDma axiDma;
+    XScuGic *intc;
+    struct axisDmaCtrl_params params;
+
+    dma_tx_cb_t txCb;
+    dma_tx_pkt_cb_t txPktCb;
+    dma_rx_cb_t rxCb;
+    dma_rx_pkt_cb_t rxPktCb;
+    dma_tx_lost_cb_t txLostCb;
+    dma_tx_flow_cb_t txFlowCb;
+    dma_stall_cb_t stallCb;
+    void *cbCtx;
+
+    /* packet mode reassembly state */
+    struct axisDmaCtrl_pkt rxPkt;
+    uint8_t *rxPktCopyBuf;
+    size_t rxPktCopyBufSize;
+    int rxPktOpen;
+
+    /* block rx mode, chunks are the bd_buf_size pieces of the rx region
+     * numbered in the order they are armed and complete in */
+    dma_rx_block_cb_t rxBlkCb;
+    uint32_t rxBlkChunks;   /* chunks in the whole blocks of the region */
+    uint32_t rxBlkArmSeq;   /* next chunk to attach to a bd */
+    uint32_t rxBlkDoneSeq;  /* next chunk to complete */
+    uint32_t rxBlkStartSeq; /* first chunk of the block not handed over yet */
+    uint32_t rxBlkBytes;
+    uint16_t rxBlkFlags;
+    int rxBlkShort;
+    XTime rxBlkLast;
+
+    /* cyclic rx walk position and producer index */
+    XAxiDma_Bd *rxCycBd;
+    volatile uint32_t rxCycProd;
+
+    /* set by the rx isr in napi mode, cleared by axisDmaCtrl_rxPoll once the ring is dry */
+    volatile int rxPolling;
+
+    /* AXISDMA_ERR_* set by the error irqs, cleared by axisDmaCtrl_recover */
+    volatile int errPending;
+
+    /* deferred rx completion queue, isr produces and axisDmaCtrl_rxPoll consumes */
+    struct rxq_entry rxq[AXISDMA_RXQ_DEPTH];
+    volatile uint32_t rxqHead;
+    volatile uint32_t rxqTail;
+    /* entries from rxqHead on that were delivered but whose bds an open
+     * zero copy packet still points into */
+    uint32_t rxqHeld;
+
+    /* rx lending free pool, a stack of buffer addresses, and which
+     * buffers the user holds, by offset / bd_buf_size */
+    uint32_t rxPool[AXISDMA_RX_POOL_MAX];
+    int rxPoolCnt;
+    int rxPoolSize;
+    uint8_t rxLent[AXISDMA_RX_POOL_MAX];
+
+    /* tx buffer pool, a stack of free block addresses */
+    uint32_t txPool[AXISDMA_TX_POOL_MAX];
+    int txPoolCnt;
+    int txPoolSize;
+
+    /* packet tx completion, cookies sit at the index of the EOF bd of their
+     * packet and the bytes of the packet being completed add up here */
+    void *txCookie[AXISDMA_TX_BD_MAX];
+    uint32_t txPktBytes;
+
+    /* tx software queues, one per priority. submit calls add with the tx
+     * irq masked and the tx isr drains them */
+    struct txQueue txq[AXISDMA_TXQ_PRIOS];
+    uint32_t txqCnt;    /* queued over all priorities */
+    int txqStopped;
+    int txqCur;         /* bulk priority whose turn it is when weighted */
+    int txqCredit;      /* packets it may still send this turn */
+
+    /* bulk bds owned by the hardware, a bulk packet keeps its bd count at
+     * the index of its EOF bd */
+    uint16_t txBulk[AXISDMA_TX_BD_MAX];
+    uint32_t txBulkBds;
+
+    /* current coalesce thresholds */
+    struct coalesceState txCoal;
+    struct coalesceState rxCoal;
+
+    /* stall watchdog */
+    struct stallState txStall;
+    struct stallState rxStall;
+
+    /* runtime counters, written by whoever owns the ring at the time */
+    struct axisDmaCtrl_stats stats;
+
+#ifdef AXISDMA_ENABLE_LATENCY
+    struct axisDmaCtrl_latency lat;
+#endif
+
+    /* event trace, slots are claimed atomically by isrs and thread context alike */
+    volatile int traceOn;
+    volatile uint32_t traceHead;
+    struct axisDmaCtrl_traceEvt trace[AXISDMA_TRACE_DEPTH];
+};
 
 /***************** Macros (Inline Functions) Definitions *********************/
+/* orders the queue entry against the index publishing it */
+#define AXISDMA_DMB() __sync_synchronize()
+
 #ifdef AXISDMA_ENABLE_DEBUG_PRINTS
     #define AXISDMA_ERROR_PRINT(fmt, args...) printf("ERROR: %s:%d(): " fmt, \
             __func__,__LINE__, ##args)
@@ -37,264 +239,1326 @@
     #endif
 #endif
 
+/* one branch when tracing is off */
+#define AXISDMA_TRACE(inst, type, chan, bd, buf, len, sts) \
+    do { \
+        if ((inst)->traceOn) \
+            axisDmaCtrl_traceRec(inst, type, chan, (u32)(UINTPTR)(bd), buf, len, sts); \
+    } while (0)
+
+/* stage timing, declares nothing and costs nothing without AXISDMA_ENABLE_LATENCY */
+#ifdef AXISDMA_ENABLE_LATENCY
+    #define AXISDMA_LAT_VAR(t) XTime t
+    #define AXISDMA_LAT_START(t) XTime_GetTime(&(t))
+    #define AXISDMA_LAT_END(inst, stg, t) axisDmaCtrl_latRecord(&(inst)->lat.stage[stg], t)
+    #define AXISDMA_TX_ISR axisDmaCtrl_txIntrTimed
+    #define AXISDMA_RX_ISR axisDmaCtrl_rxIntrTimed
+#else
+    #define AXISDMA_LAT_VAR(t)
+    #define AXISDMA_LAT_START(t)
+    #define AXISDMA_LAT_END(inst, stg, t)
+    #define AXISDMA_TX_ISR axisDmaCtrl_txIntrHandler
+    #define AXISDMA_RX_ISR axisDmaCtrl_rxIntrHandler
+#endif
+
 /************************** Function Prototypes ******************************/
 static void axisDmaCtrl_txIntrHandler(void *callback);
 static void axisDmaCtrl_rxIntrHandler(void *callback);
-static int axisDmaCtrl_setupIntrSystem(XScuGic * intcInstancePtr);
-static void axisDmaCtrl_disableIntrSystem(XScuGic * intcInstancePtr);
-static int axisDmaCtrl_rxSetup(XAxiDma * axiDmaInstPtr);
-static int axisDmaCtrl_txSetup(XAxiDma * axiDmaInstPtr);
-static void axisDmaCtrl_txIrqBdHandler(XAxiDma_BdRing * txRingPtr);
-static void axisDmaCtrl_rxIrqBdHandler(XAxiDma_BdRing * rxRingPtr);
-static int axisDmaCtrl_markMemNoncache(void);
+static int axisDmaCtrl_setupIntrSystem(struct axisDmaCtrl *inst);
+static void axisDmaCtrl_disableIntrSystem(struct axisDmaCtrl *inst);
+static int axisDmaCtrl_rxSetup(struct axisDmaCtrl *inst);
+static int axisDmaCtrl_txSetup(struct axisDmaCtrl *inst);
+static int axisDmaCtrl_txIrqBdHandler(struct axisDmaCtrl *inst);
+static int axisDmaCtrl_rxIrqBdHandler(struct axisDmaCtrl *inst);
+static int axisDmaCtrl_coalesceSetup(XAxiDma_BdRing * ringPtr, struct coalesceState *st,
+    const struct axisDmaCtrl_coalesce *pol, u32 staticCount);
+static void axisDmaCtrl_coalesceAdapt(XAxiDma_BdRing * ringPtr, struct coalesceState *st,
+    const struct axisDmaCtrl_coalesce *pol, u32 irqStatus, int bdCount);
+static int axisDmaCtrl_markMemNoncache(struct axisDmaCtrl *inst);
+static void axisDmaCtrl_statsReset(struct axisDmaCtrl *inst);
+static void axisDmaCtrl_statsHw(struct axisDmaCtrl_ringStats *st, XAxiDma_BdRing * ringPtr, int reaped);
+static void axisDmaCtrl_statsBdErr(struct axisDmaCtrl_ringStats *st, u32 bdSts);
+static void axisDmaCtrl_traceRec(struct axisDmaCtrl *inst, u8 type, u8 chan,
+    u32 bd, u32 buf, u32 len, u32 sts);
+#ifdef AXISDMA_ENABLE_LATENCY
+static void axisDmaCtrl_txIntrTimed(void *callback);
+static void axisDmaCtrl_rxIntrTimed(void *callback);
+static void axisDmaCtrl_latReset(struct axisDmaCtrl *inst);
+static void axisDmaCtrl_latRecord(struct axisDmaCtrl_latStage *st, XTime start);
+#endif
+static int axisDmaCtrl_initInst(struct axisDmaCtrl *inst,
+    struct axisDmaCtrl_params *paramsIn, XScuGic * intcInstancePtr,
+    dma_rx_cb_t rxCb, dma_tx_cb_t txCb, void *cbCtx);
 static struct axisDmaCtrl_params axisDmaCtrl_copyParamsStruct(struct axisDmaCtrl_params * in);
 static void axisDmaCtrl_emptyParamsStruct(struct axisDmaCtrl_params * in);
+static void axisDmaCtrl_rxPktFrag(struct axisDmaCtrl *inst, uint32_t addr, uint32_t len, u32 bdSts);
+static void axisDmaCtrl_rxBdDeliver(struct axisDmaCtrl *inst, uint32_t addr, uint32_t len, u32 bdSts);
+static void axisDmaCtrl_rxRecycle(struct axisDmaCtrl *inst, int bdCount, XAxiDma_Bd * bdPtr);
+static void axisDmaCtrl_rxDeliverBds(struct axisDmaCtrl *inst, int bdCount, XAxiDma_Bd * bdPtr);
+static int axisDmaCtrl_rxPollRing(struct axisDmaCtrl *inst, int budget);
+static int axisDmaCtrl_rxPktBds(XAxiDma_BdRing * ringPtr);
+static int axisDmaCtrl_rxRefillDue(struct axisDmaCtrl *inst, int done);
+static int axisDmaCtrl_rxPktHeld(struct axisDmaCtrl *inst);
+static int axisDmaCtrl_rxCyclicWalk(struct axisDmaCtrl *inst);
+static int axisDmaCtrl_rxPollQueue(struct axisDmaCtrl *inst, int budget);
+static uint32_t axisDmaCtrl_rxBlockAddr(struct axisDmaCtrl *inst, uint32_t seq);
+static void axisDmaCtrl_rxBlockFrag(struct axisDmaCtrl *inst, uint32_t len, int err);
+static void axisDmaCtrl_rxBlockFlush(struct axisDmaCtrl *inst, uint16_t flags);
+static void axisDmaCtrl_rxBlockTimeout(struct axisDmaCtrl *inst);
+static void axisDmaCtrl_rxPoolPut(struct axisDmaCtrl *inst, uint32_t addr);
+static int axisDmaCtrl_rxDrain(struct axisDmaCtrl *inst);
+static void axisDmaCtrl_txReclaim(struct axisDmaCtrl *inst, struct axisDmaCtrl_recovery *info);
+static void axisDmaCtrl_rxReclaim(struct axisDmaCtrl *inst, struct axisDmaCtrl_recovery *info);
+static int axisDmaCtrl_stallCheck(struct axisDmaCtrl *inst, XAxiDma_BdRing * ringPtr,
+    struct stallState *st, XTime now, int rx);
+static int axisDmaCtrl_txPacket(struct axisDmaCtrl *inst, uint8_t * packetBuf, size_t packetSize,
+    void *cookie, int prio);
+static int axisDmaCtrl_txSubmit(struct axisDmaCtrl *inst, uint8_t * packetBuf, size_t packetSize,
+    void *cookie, int prio);
+static void axisDmaCtrl_txQueuePush(struct axisDmaCtrl *inst);
+static int axisDmaCtrl_txQueueMove(struct axisDmaCtrl *inst, struct txq_entry *bad);
+static int axisDmaCtrl_txSchedPick(struct axisDmaCtrl *inst, int freeBds);
+static int axisDmaCtrl_txSchedFits(struct axisDmaCtrl *inst, int prio, int freeBds);
+static int axisDmaCtrl_txBulkRoom(struct axisDmaCtrl *inst, int bds);
+static void axisDmaCtrl_txBulkMark(struct axisDmaCtrl *inst, XAxiDma_Bd * bdPtr, int bds);
+static int axisDmaCtrl_txPoolIdx(struct axisDmaCtrl *inst, uint32_t addr);
+static int axisDmaCtrl_txBdIdx(XAxiDma_BdRing * ringPtr, XAxiDma_Bd * bdPtr);
+static int axisDmaCtrl_txReapWhole(XAxiDma_BdRing * ringPtr, XAxiDma_Bd * bdPtr, int bdCount);
+static int axisDmaCtrl_txBdsFor(struct axisDmaCtrl *inst, size_t len);
+static XAxiDma_Bd *axisDmaCtrl_txFillBds(struct axisDmaCtrl *inst,
+    XAxiDma_Bd * bdCurPtr, u32 BufferAddr, size_t len, int sof, int eof, void *cookie);
 
 /************************** Variable Definitions *****************************/
-static XAxiDma axiDma;
+static struct axisDmaCtrl instances[AXISDMA_MAX_INSTANCES];
+
+struct axisDmaCtrl *axisDmaCtrl_init(struct axisDmaCtrl_params *paramsIn, 
+    XScuGic * intcInstancePtr,
+    dma_rx_cb_t rxCb,
+    dma_tx_cb_t txCb,
+    void *cbCtx
+    )
+{
+    struct axisDmaCtrl *inst = NULL;
+    int rc;
+    int i;
+
+    if (paramsIn == NULL || intcInstancePtr == NULL)
+        return NULL;
+
+    /* one instance per dma core */
+    for (i = 0; i < AXISDMA_MAX_INSTANCES; i++) {
+        if (instances[i].inUse) {
+            if (instances[i].params.dmaDevId == paramsIn->dmaDevId) {
+                AXISDMA_ERROR_PRINT("dma %u already in use\r\n",paramsIn->dmaDevId);
+                return NULL;
+            }
+        } else if (inst == NULL) {
+            inst = &instances[i];
+        }
+    }
+    if (inst == NULL) {
+        AXISDMA_ERROR_PRINT("no free instance, raise AXISDMA_MAX_INSTANCES\r\n");
+        return NULL;
+    }
+
+    memset(inst, 0, sizeof(*inst));
+    inst->inUse = 1;
+    axisDmaCtrl_statsReset(inst);
+#ifdef AXISDMA_ENABLE_LATENCY
+    axisDmaCtrl_latReset(inst);
+#endif
+    rc = axisDmaCtrl_initInst(inst, paramsIn, intcInstancePtr, rxCb, txCb, cbCtx);
+    if (rc != XST_SUCCESS) {
+        inst->inUse = 0;
+        return NULL;
+    }
 
-static dma_tx_cb_t _tx_cb = NULL;
-static dma_rx_cb_t _rx_cb = NULL;
-static struct axisDmaCtrl_params params;
+    return inst;
+}
 
-int axisDmaCtrl_init(struct axisDmaCtrl_params *paramsIn, 
+static int axisDmaCtrl_initInst(struct axisDmaCtrl *inst,
+    struct axisDmaCtrl_params *paramsIn,
     XScuGic * intcInstancePtr,
     dma_rx_cb_t rxCb,
-    dma_tx_cb_t txCb
+    dma_tx_cb_t txCb,
+    void *cbCtx
     )
 {
     int rc;
     XAxiDma_Config *config;
 
-    rc = axisDmaCtrl_register_tx_cb(txCb);
-    if (rc != XST_SUCCESS) {
-        AXISDMA_ERROR_PRINT("axisDmaCtrl_register_tx_cb failed!\r\n");
-        return rc;
+    if (txCb == NULL) {
+        AXISDMA_ERROR_PRINT("no tx callback!\r\n");
+        return XST_FAILURE;
     }
 
-    axisDmaCtrl_register_rx_cb(rxCb);
-    if (rc != XST_SUCCESS) {
-        AXISDMA_ERROR_PRINT("axisDmaCtrl_register_rx_cb failed!\r\n");
-        return rc;
+    if (rxCb == NULL) {
+        AXISDMA_ERROR_PRINT("no rx callback!\r\n");
+        return XST_FAILURE;
     }
 
-    params = axisDmaCtrl_copyParamsStruct(paramsIn);
+    inst->txCb  = txCb;
+    inst->rxCb  = rxCb;
+    inst->cbCtx = cbCtx;
+    inst->intc  = intcInstancePtr;
+    inst->params = axisDmaCtrl_copyParamsStruct(paramsIn);
 
-    rc = axisDmaCtrl_markMemNoncache();
+    rc = axisDmaCtrl_markMemNoncache(inst);
     if (rc != XST_SUCCESS) {
         AXISDMA_ERROR_PRINT("axisDmaCtrl_markMemNoncache failed!\r\n");
         return XST_FAILURE;
     }
 
-    config = XAxiDma_LookupConfig(params.dmaDevId);
-    rc = XAxiDma_CfgInitialize(&axiDma, config);
+    config = XAxiDma_LookupConfig(inst->params.dmaDevId);
+    if (config == NULL) {
+        AXISDMA_ERROR_PRINT("XAxiDma_LookupConfig failed!\r\n");
+        return XST_FAILURE;
+    }
+    rc = XAxiDma_CfgInitialize(&inst->axiDma, config);
     if (rc != XST_SUCCESS) {
         AXISDMA_ERROR_PRINT("XAxiDma_CfgInitialize failed!\r\n");
         return XST_FAILURE;
     }
 
-    if (!XAxiDma_HasSg(&axiDma)) {
+    if (!XAxiDma_HasSg(&inst->axiDma)) {
         AXISDMA_ERROR_PRINT("DMA NOT in SG Mode...\r\n");
         return XST_FAILURE;
     }
 
-    /* Set up TX/RX channels to be ready to transmit and receive packets */
-    if (params.txEn) {
-        rc = axisDmaCtrl_txSetup(&axiDma);
-        if (rc != XST_SUCCESS) {
-            AXISDMA_ERROR_PRINT("Failed TX setup\r\n");
-            return XST_FAILURE;
-        }
+    /* Set up TX/RX channels to be ready to transmit and receive packets */
+    if (TX_EN(inst)) {
+        rc = axisDmaCtrl_txSetup(inst);
+        if (rc != XST_SUCCESS) {
+            AXISDMA_ERROR_PRINT("Failed TX setup\r\n");
+            return XST_FAILURE;
+        }
+    }
+
+    if (RX_EN(inst)) {
+        rc = axisDmaCtrl_rxSetup(inst);
+        if (rc != XST_SUCCESS) {
+            AXISDMA_ERROR_PRINT("Failed RX setup\r\n");
+            return XST_FAILURE;
+        }
+    }
+
+    /* Set up Interrupt system  */
+    rc = axisDmaCtrl_setupIntrSystem(inst);
+    if (rc != XST_SUCCESS) {
+        AXISDMA_ERROR_PRINT("Failed interrupt setup\r\n");
+        return XST_FAILURE;
+    }
+
+    return XST_SUCCESS;
+}
+
+void axisDmaCtrl_printParams(struct axisDmaCtrl_params *in)
+{
+    int i;
+
+    printf("rx_bd_space_base      : 0x%x\r\n",(unsigned int)in->rx_bd_space_base);
+    printf("rx_bd_space_high      : 0x%x\r\n",(unsigned int)in->rx_bd_space_high);
+    printf("tx_bd_space_base      : 0x%x\r\n",(unsigned int)in->tx_bd_space_base);
+    printf("tx_bd_space_high      : 0x%x\r\n",(unsigned int)in->tx_bd_space_high);
+    printf("tx_buffer_base        : 0x%x\r\n",(unsigned int)in->tx_buffer_base);
+    printf("tx_buffer_high        : 0x%x\r\n",(unsigned int)in->tx_buffer_high);
+    printf("rx_buffer_base        : 0x%x\r\n",(unsigned int)in->rx_buffer_base);
+    printf("rx_buffer_high        : 0x%x\r\n",(unsigned int)in->rx_buffer_high);
+    printf("bd_buf_size           : 0x%x\r\n",(unsigned int)in->bd_buf_size);
+    printf("tx_block_size         : 0x%x\r\n",(unsigned int)in->tx_block_size);
+    printf("rx_block_size         : 0x%x\r\n",(unsigned int)in->rx_block_size);
+    printf("dmaDevId              : 0x%x\r\n",(unsigned int)in->dmaDevId);
+    printf("txEn                  : %u\r\n",in->txEn);
+    printf("txIrqPriority         : 0x%x\r\n",(unsigned int)in->txIrqPriority);
+    printf("txIrqId               : 0x%x\r\n",(unsigned int)in->txIrqId);
+    printf("rxEn                  : %u\r\n",in->rxEn);
+    printf("coalesce_count        : %u\r\n",in->coalesce_count);
+    printf("rxIrqId               : 0x%x\r\n",(unsigned int)in->rxIrqId);
+    printf("rxIrqPriority         : 0x%x\r\n",(unsigned int)in->rxIrqPriority);
+    printf("cacheable_bufs        : %u\r\n",in->cacheable_bufs);
+    printf("rx_deferred           : %u\r\n",in->rx_deferred);
+    printf("rx_lend               : %u\r\n",in->rx_lend);
+    printf("rx_mode               : %u\r\n",in->rx_mode);
+    printf("rx_cyclic             : %u\r\n",in->rx_cyclic);
+    printf("rx_refill_watermark   : %u\r\n",in->rx_refill_watermark);
+    printf("rx_block_timeout_us   : %u\r\n",(unsigned int)in->rx_block_timeout_us);
+    printf("stall_timeout_us      : %u\r\n",(unsigned int)in->stall_timeout_us);
+    printf("stall_recover         : %u\r\n",in->stall_recover);
+    printf("tx_queue_depth        : %u\r\n",in->tx_queue_depth);
+    printf("tx_queue_high         : %u\r\n",in->tx_queue_high);
+    printf("tx_queue_low          : %u\r\n",in->tx_queue_low);
+    printf("tx_sched              : %u, weights",in->tx_sched);
+    for (i = 1; i < AXISDMA_TXQ_PRIOS; i++)
+        printf(" %u",in->tx_weight[i]);
+    printf("\r\n");
+    printf("tx_bulk_max_bds       : %u\r\n",in->tx_bulk_max_bds);
+    printf("tx_coalesce           : adaptive %u, min %u, max %u, delay %u, irq_interval_us %u\r\n",
+        in->tx_coalesce.adaptive,in->tx_coalesce.min_count,in->tx_coalesce.max_count,
+        in->tx_coalesce.delay,(unsigned int)in->tx_coalesce.irq_interval_us);
+    printf("rx_coalesce           : adaptive %u, min %u, max %u, delay %u, irq_interval_us %u\r\n",
+        in->rx_coalesce.adaptive,in->rx_coalesce.min_count,in->rx_coalesce.max_count,
+        in->rx_coalesce.delay,(unsigned int)in->rx_coalesce.irq_interval_us);
+}
+
+void axisDmaCtrl_disable(struct axisDmaCtrl *inst)
+{
+    int i;
+
+    if (inst == NULL || !inst->inUse)
+        return;
+    axisDmaCtrl_disableIntrSystem(inst);
+    inst->intc = NULL;
+    inst->rxqHead = 0;
+    inst->rxqTail = 0;
+    inst->rxqHeld = 0;
+    inst->rxPolling = 0;
+    inst->rxCycBd = NULL;
+    inst->rxCycProd = 0;
+    inst->rxPoolCnt = 0;
+    inst->rxPoolSize = 0;
+    memset(inst->rxLent, 0, sizeof(inst->rxLent));
+    inst->txPoolCnt = 0;
+    inst->txPoolSize = 0;
+    inst->txCb = NULL;
+    inst->txPktCb = NULL;
+    inst->txPktBytes = 0;
+    inst->rxCb = NULL;
+    inst->rxPktCb = NULL;
+    inst->cbCtx = NULL;
+    inst->rxPktCopyBuf = NULL;
+    inst->rxPktCopyBufSize = 0;
+    inst->rxPktOpen = 0;
+    inst->txLostCb = NULL;
+    inst->txFlowCb = NULL;
+    for (i = 0; i < AXISDMA_TXQ_PRIOS; i++) {
+        inst->txq[i].head = 0;
+        inst->txq[i].cnt = 0;
+    }
+    inst->txqCnt = 0;
+    inst->txqStopped = 0;
+    inst->stallCb = NULL;
+    inst->errPending = 0;
+    axisDmaCtrl_emptyParamsStruct(&inst->params);
+    inst->inUse = 0;
+}
+
+int axisDmaCtrl_register_tx_cb(struct axisDmaCtrl *inst, dma_tx_cb_t cb)
+{
+    if (cb == NULL)
+        return XST_FAILURE;
+    XAxiDma_Pause(&inst->axiDma);
+    inst->txCb = cb;
+    XAxiDma_Resume(&inst->axiDma);
+    return XST_SUCCESS;
+}
+
+int axisDmaCtrl_register_rx_cb(struct axisDmaCtrl *inst, dma_rx_cb_t cb)
+{
+    if (cb == NULL)
+        return XST_FAILURE;
+    XAxiDma_Pause(&inst->axiDma);
+    inst->rxCb = cb;
+    XAxiDma_Resume(&inst->axiDma);
+    return XST_SUCCESS;
+}
+
+int axisDmaCtrl_register_rx_pkt_cb(struct axisDmaCtrl *inst, dma_rx_pkt_cb_t cb,
+    uint8_t *copyBuf, size_t copyBufSize)
+{
+    XAxiDma_Pause(&inst->axiDma);
+    inst->rxPktCb = cb;
+    inst->rxPktCopyBuf = copyBufSize ? copyBuf : NULL;
+    inst->rxPktCopyBufSize = inst->rxPktCopyBuf ? copyBufSize : 0;
+    inst->rxPktOpen = 0;
+    XAxiDma_Resume(&inst->axiDma);
+    return XST_SUCCESS;
+}
+
+int axisDmaCtrl_register_rx_block_cb(struct axisDmaCtrl *inst, dma_rx_block_cb_t cb)
+{
+    if (inst->params.rx_block_size == 0)
+        return XST_FAILURE;
+    XAxiDma_Pause(&inst->axiDma);
+    inst->rxBlkCb = cb;
+    XAxiDma_Resume(&inst->axiDma);
+    return XST_SUCCESS;
+}
+
+int axisDmaCtrl_register_tx_pkt_cb(struct axisDmaCtrl *inst, dma_tx_pkt_cb_t cb)
+{
+    XAxiDma_Pause(&inst->axiDma);
+    inst->txPktCb = cb;
+    XAxiDma_Resume(&inst->axiDma);
+    return XST_SUCCESS;
+}
+
+int axisDmaCtrl_register_tx_lost_cb(struct axisDmaCtrl *inst, dma_tx_lost_cb_t cb)
+{
+    inst->txLostCb = cb;
+    return XST_SUCCESS;
+}
+
+int axisDmaCtrl_register_tx_flow_cb(struct axisDmaCtrl *inst, dma_tx_flow_cb_t cb)
+{
+    inst->txFlowCb = cb;
+    return XST_SUCCESS;
+}
+
+int axisDmaCtrl_register_stall_cb(struct axisDmaCtrl *inst, dma_stall_cb_t cb)
+{
+    inst->stallCb = cb;
+    return XST_SUCCESS;
+}
+
+int axisDmaCtrl_getStats(struct axisDmaCtrl *inst, struct axisDmaCtrl_stats *stats, int reset)
+{
+    /* both isrs write counters, the polling rx modes do so from this context */
+    if (inst->intc != NULL) {
+        if (TX_EN(inst))
+            XScuGic_Disable(inst->intc, inst->params.txIrqId);
+        if (RX_EN(inst))
+            XScuGic_Disable(inst->intc, inst->params.rxIrqId);
+    }
+    if (stats != NULL)
+        *stats = inst->stats;
+    if (reset)
+        axisDmaCtrl_statsReset(inst);
+    if (inst->intc != NULL) {
+        if (TX_EN(inst))
+            XScuGic_Enable(inst->intc, inst->params.txIrqId);
+        if (RX_EN(inst))
+            XScuGic_Enable(inst->intc, inst->params.rxIrqId);
+    }
+    return XST_SUCCESS;
+}
+
+#ifdef AXISDMA_ENABLE_LATENCY
+int axisDmaCtrl_getLatency(struct axisDmaCtrl *inst, struct axisDmaCtrl_latency *lat, int reset)
+{
+    if (inst->intc != NULL) {
+        if (TX_EN(inst))
+            XScuGic_Disable(inst->intc, inst->params.txIrqId);
+        if (RX_EN(inst))
+            XScuGic_Disable(inst->intc, inst->params.rxIrqId);
+    }
+    if (lat != NULL)
+        *lat = inst->lat;
+    if (reset)
+        axisDmaCtrl_latReset(inst);
+    if (inst->intc != NULL) {
+        if (TX_EN(inst))
+            XScuGic_Enable(inst->intc, inst->params.txIrqId);
+        if (RX_EN(inst))
+            XScuGic_Enable(inst->intc, inst->params.rxIrqId);
+    }
+    return XST_SUCCESS;
+}
+#endif
+
+void axisDmaCtrl_traceEnable(struct axisDmaCtrl *inst, int enable)
+{
+    inst->traceOn = enable ? 1 : 0;
+}
+
+uint32_t axisDmaCtrl_traceDump(struct axisDmaCtrl *inst, void *buf, uint32_t size)
+{
+    struct axisDmaCtrl_traceHdr *hdr = (struct axisDmaCtrl_traceHdr *)buf;
+    struct axisDmaCtrl_traceEvt *evt = (struct axisDmaCtrl_traceEvt *)(hdr + 1);
+    uint32_t head = inst->traceHead;
+    uint32_t count = head < AXISDMA_TRACE_DEPTH ? head : AXISDMA_TRACE_DEPTH;
+    uint32_t i;
+
+    if (buf == NULL || size < sizeof(*hdr))
+        return 0;
+    if (count > (size - sizeof(*hdr)) / sizeof(*evt))
+        count = (size - sizeof(*hdr)) / sizeof(*evt);
+
+    for (i = 0; i < count; i++)
+        evt[i] = inst->trace[(head - count + i) & TRACE_MASK];
+
+    hdr->magic    = AXISDMA_TRACE_MAGIC;
+    hdr->version  = AXISDMA_TRACE_VERSION;
+    hdr->evt_size = sizeof(*evt);
+    hdr->count    = count;
+    hdr->head     = head;
+    hdr->counts_per_second = COUNTS_PER_SECOND;
+
+    return sizeof(*hdr) + count * sizeof(*evt);
+}
+
+int axisDmaCtrl_errorPending(struct axisDmaCtrl *inst)
+{
+    return inst->errPending;
+}
+
+int axisDmaCtrl_recover(struct axisDmaCtrl *inst, struct axisDmaCtrl_recovery *info)
+{
+    XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&inst->axiDma);
+    struct axisDmaCtrl_recovery tmp;
+    XTime start, now, quiet;
+    int timeOut;
+    int rc = XST_SUCCESS;
+
+    if (inst->intc == NULL)
+        return XST_FAILURE;
+    if (info == NULL)
+        info = &tmp;
+    memset(info, 0, sizeof(*info));
+    XTime_GetTime(&start);
+
+    /*
+     * Whatever s2mm still finds in the stream is delivered first, the
+     * reset would throw it away. Stops early once nothing came in for a
+     * while or the channel is the one that halted.
+     */
+    if (RX_EN(inst)) {
+        quiet = start;
+        do {
+            int bdCount = axisDmaCtrl_rxDrain(inst);
+
+            XTime_GetTime(&now);
+            if (bdCount > 0) {
+                info->rx_drained_bds += bdCount;
+                quiet = now;
+            }
+        } while (XAxiDma_BdRingHwIsStarted(rxRingPtr) &&
+            now - quiet < (XTime)AXISDMA_RECOVER_DRAIN_US * COUNTS_PER_SECOND / 1000000 &&
+            now - start < (XTime)AXISDMA_RECOVER_TIMEOUT_US * COUNTS_PER_SECOND / 1000000);
+    }
+
+    /* both isrs and the rx polling work on the rings torn down below */
+    if (TX_EN(inst))
+        XScuGic_Disable(inst->intc, inst->params.txIrqId);
+    if (RX_EN(inst))
+        XScuGic_Disable(inst->intc, inst->params.rxIrqId);
+
+    AXISDMA_TRACE(inst, AXISDMA_TRACE_RESET, AXISDMA_TRACE_TX, 0, 0, 0, inst->errPending);
+    XAxiDma_Reset(&inst->axiDma);
+    timeOut = RESET_TIMEOUT_COUNTER;
+    while (timeOut) {
+        if (XAxiDma_ResetIsDone(&inst->axiDma))
+            break;
+        timeOut -= 1;
+    }
+    if (!timeOut) {
+        AXISDMA_ERROR_PRINT("reset did not complete\r\n");
+        rc = XST_FAILURE;
+        goto out;
+    }
+
+    /* the bds still hold what hardware left behind, go through them before
+     * the rings are created again */
+    if (TX_EN(inst)) {
+        axisDmaCtrl_txReclaim(inst, info);
+        inst->stats.tx.resets++;
+        if (axisDmaCtrl_txSetup(inst) != XST_SUCCESS) {
+            AXISDMA_ERROR_PRINT("Failed TX setup\r\n");
+            rc = XST_FAILURE;
+            goto out;
+        }
+    }
+    if (RX_EN(inst)) {
+        axisDmaCtrl_rxReclaim(inst, info);
+        inst->stats.rx.resets++;
+        if (axisDmaCtrl_rxSetup(inst) != XST_SUCCESS) {
+            AXISDMA_ERROR_PRINT("Failed RX setup\r\n");
+            rc = XST_FAILURE;
+            goto out;
+        }
+    }
+    inst->errPending = 0;
+    memset(&inst->txStall, 0, sizeof(inst->txStall));
+    memset(&inst->rxStall, 0, sizeof(inst->rxStall));
+
+    /* what queued up while the engine was down goes out now */
+    if (inst->txqCnt)
+        axisDmaCtrl_txQueuePush(inst);
+
+out:
+    if (TX_EN(inst))
+        XScuGic_Enable(inst->intc, inst->params.txIrqId);
+    if (RX_EN(inst))
+        XScuGic_Enable(inst->intc, inst->params.rxIrqId);
+
+    XTime_GetTime(&now);
+    info->time_us = (now - start) * 1000000 / COUNTS_PER_SECOND;
+    AXISDMA_DEBUG_PRINT("recovered in %u us, %u tx packets lost\r\n",
+        (unsigned int)info->time_us, (unsigned int)info->tx_lost_pkts);
+
+    return rc;
+}
+
+int axisDmaCtrl_watchdog(struct axisDmaCtrl *inst)
+{
+    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
+    XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&inst->axiDma);
+    int stalled = 0;
+    XTime now;
+
+    if (inst->intc == NULL || inst->params.stall_timeout_us == 0)
+        return 0;
+    XTime_GetTime(&now);
+
+    /* the isrs move the hw heads */
+    if (TX_EN(inst)) {
+        XScuGic_Disable(inst->intc, inst->params.txIrqId);
+        if (axisDmaCtrl_stallCheck(inst, txRingPtr, &inst->txStall, now, 0))
+            stalled |= AXISDMA_ERR_TX;
+        XScuGic_Enable(inst->intc, inst->params.txIrqId);
+    }
+    if (RX_EN(inst) && !inst->params.rx_cyclic) {
+        XScuGic_Disable(inst->intc, inst->params.rxIrqId);
+        if (axisDmaCtrl_stallCheck(inst, rxRingPtr, &inst->rxStall, now, 1))
+            stalled |= AXISDMA_ERR_RX;
+        XScuGic_Enable(inst->intc, inst->params.rxIrqId);
+    }
+
+    if ((stalled & AXISDMA_ERR_TX) && inst->stallCb != NULL)
+        inst->stallCb(inst->cbCtx, AXISDMA_ERR_TX, XAxiDma_BdRingGetSr(txRingPtr));
+    if ((stalled & AXISDMA_ERR_RX) && inst->stallCb != NULL)
+        inst->stallCb(inst->cbCtx, AXISDMA_ERR_RX, XAxiDma_BdRingGetSr(rxRingPtr));
+
+    if (stalled && inst->params.stall_recover &&
+            axisDmaCtrl_recover(inst, NULL) != XST_SUCCESS)
+        AXISDMA_ERROR_PRINT("recovery after stall failed\r\n");
+
+    return stalled;
+}
+
+int axisDmaCtrl_getAvailTxBds(struct axisDmaCtrl *inst)
+{
+    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
+    return txRingPtr->FreeCnt;
+}
+
+int axisDmaCtrl_getAvailRxBds(struct axisDmaCtrl *inst)
+{
+    XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&inst->axiDma);
+    return rxRingPtr->FreeCnt;
+}
+
+int axisDmaCtrl_getAvailRxBufs(struct axisDmaCtrl *inst)
+{
+    return inst->rxPoolCnt;
+}
+
+int axisDmaCtrl_getAvailTxBufs(struct axisDmaCtrl *inst)
+{
+    return inst->txPoolCnt;
+}
+
+int axisDmaCtrl_getTxQueued(struct axisDmaCtrl *inst)
+{
+    return inst->txqCnt;
+}
+
+int axisDmaCtrl_getTxCoalesce(struct axisDmaCtrl *inst)
+{
+    return inst->txCoal.count;
+}
+
+int axisDmaCtrl_getRxCoalesce(struct axisDmaCtrl *inst)
+{
+    return inst->rxCoal.count;
+}
+
+uint8_t *axisDmaCtrl_txBufGet(struct axisDmaCtrl *inst)
+{
+    uint8_t *buf = NULL;
+
+    if (inst->txPoolSize == 0 || inst->intc == NULL)
+        return NULL;
+
+    /* completions push blocks back from the tx isr */
+    XScuGic_Disable(inst->intc, inst->params.txIrqId);
+    if (inst->txPoolCnt > 0)
+        buf = (uint8_t *)(UINTPTR)inst->txPool[--inst->txPoolCnt];
+    XScuGic_Enable(inst->intc, inst->params.txIrqId);
+
+    return buf;
+}
+
+void axisDmaCtrl_txBufPut(struct axisDmaCtrl *inst, uint8_t * buf)
+{
+    uint32_t addr = (uint32_t)(UINTPTR)buf;
+
+    if (inst->intc == NULL || axisDmaCtrl_txPoolIdx(inst, addr) < 0)
+        return;
+
+    XScuGic_Disable(inst->intc, inst->params.txIrqId);
+    if (inst->txPoolCnt < inst->txPoolSize)
+        inst->txPool[inst->txPoolCnt++] = addr;
+    XScuGic_Enable(inst->intc, inst->params.txIrqId);
+}
+
+int axisDmaCtrl_txBufSubmit(struct axisDmaCtrl *inst, uint8_t * buf, size_t packetSize)
+{
+    if (axisDmaCtrl_txPoolIdx(inst, (uint32_t)(UINTPTR)buf) < 0 ||
+        packetSize == 0 || packetSize > inst->params.tx_block_size)
+        return XST_INVALID_PARAM;
+
+    /* the region is noncacheable, nothing to flush */
+    return axisDmaCtrl_txSubmit(inst, buf, packetSize, buf, 0);
+}
+
+int axisDmaCtrl_rxRelease(struct axisDmaCtrl *inst, uint32_t buf_addr)
+{
+    uint32_t offset = buf_addr - (uint32_t)inst->params.rx_buffer_base;
+
+    if (!inst->params.rx_lend || inst->intc == NULL)
+        return XST_FAILURE;
+    if (buf_addr < inst->params.rx_buffer_base ||
+        offset >= inst->rxPoolSize * BD_BUF_SIZE(inst) ||
+        offset % BD_BUF_SIZE(inst)) {
+        AXISDMA_ERROR_PRINT("0x%x is not an rx buffer\r\n",(unsigned int)buf_addr);
+        return XST_INVALID_PARAM;
+    }
+
+    /* the isr pops from the pool and arms bds on the same ring */
+    XScuGic_Disable(inst->intc, inst->params.rxIrqId);
+    if (!inst->rxLent[offset / BD_BUF_SIZE(inst)]) {
+        XScuGic_Enable(inst->intc, inst->params.rxIrqId);
+        AXISDMA_ERROR_PRINT("0x%x is not lent out\r\n",(unsigned int)buf_addr);
+        return XST_INVALID_PARAM;
+    }
+    axisDmaCtrl_rxPoolPut(inst, buf_addr);
+    axisDmaCtrl_rxRecycle(inst, 0, NULL);
+    XScuGic_Enable(inst->intc, inst->params.rxIrqId);
+
+    return XST_SUCCESS;
+}
+
+int axisDmaCtrl_sendPackets(struct axisDmaCtrl *inst, uint8_t * packetBuf, size_t packetSize)
+{
+    /* Flush the SrcBuffer before the DMA transfer, in case the Data Cache
+     * is enabled. Only the packet itself, the bytes past it belong to the
+     * caller */
+    Xil_DCacheFlushRange((UINTPTR)packetBuf, packetSize);
+
+    return axisDmaCtrl_txSubmit(inst, packetBuf, packetSize, packetBuf, 0);
+}
+
+int axisDmaCtrl_sendPacketCookie(struct axisDmaCtrl *inst, uint8_t * packetBuf, size_t packetSize,
+    void *cookie)
+{
+    Xil_DCacheFlushRange((UINTPTR)packetBuf, packetSize);
+
+    return axisDmaCtrl_txSubmit(inst, packetBuf, packetSize, cookie, 0);
+}
+
+int axisDmaCtrl_sendPacketPrio(struct axisDmaCtrl *inst, uint8_t * packetBuf, size_t packetSize,
+    void *cookie, int prio)
+{
+    /* bulk accounting runs with the tx irq masked, which only the queue does */
+    if (prio < 0 || prio >= AXISDMA_TXQ_PRIOS || (prio > 0 && inst->params.tx_queue_depth == 0))
+        return XST_INVALID_PARAM;
+
+    Xil_DCacheFlushRange((UINTPTR)packetBuf, packetSize);
+
+    return axisDmaCtrl_txSubmit(inst, packetBuf, packetSize, cookie, prio);
+}
+
+int axisDmaCtrl_sendPacketBatch(struct axisDmaCtrl *inst, const struct axisDmaCtrl_txPkt *pkts, int numPkts)
+{
+    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
+    XAxiDma_Bd *bdPtr, *bdCurPtr;
+    int freeBds = txRingPtr->FreeCnt;
+    int reqBds = 0;
+    int accepted;
+    int rc;
+    int i;
+
+    if (pkts == NULL || numPkts <= 0)
+        return E_AXISDMA_FAILED;
+
+    /* queued packets go first, only the tx isr drains the queue */
+    if (inst->txqCnt) {
+        inst->stats.tx.nobds++;
+        return 0;
+    }
+
+    /* take whole packets in order for as long as the ring has room */
+    for (accepted = 0; accepted < numPkts; accepted++) {
+        int bds = axisDmaCtrl_txBdsFor(inst, pkts[accepted].len);
+
+        if (bds == 0 || reqBds + bds > freeBds)
+            break;
+        reqBds += bds;
+    }
+    if (accepted < numPkts)
+        inst->stats.tx.nobds++;
+    if (accepted == 0)
+        return 0;
+
+    rc = XAxiDma_BdRingAlloc(txRingPtr, reqBds, &bdPtr);
+    if (rc != XST_SUCCESS) {
+        AXISDMA_ERROR_PRINT("Failed bd alloc (%d/%d)\r\n", reqBds, txRingPtr->FreeCnt);
+        return 0;
+    }
+
+    bdCurPtr = bdPtr;
+    for (i = 0; i < accepted; i++) {
+        /* pool blocks are noncacheable */
+        if (axisDmaCtrl_txPoolIdx(inst, (uint32_t)(UINTPTR)pkts[i].buf) < 0)
+            Xil_DCacheFlushRange((UINTPTR)pkts[i].buf, pkts[i].len);
+
+        bdCurPtr = axisDmaCtrl_txFillBds(inst, bdCurPtr,
+            (uint32_t)(UINTPTR)pkts[i].buf, pkts[i].len, 1, 1,
+            pkts[i].cookie ? pkts[i].cookie : pkts[i].buf);
+        if (bdCurPtr == NULL) {
+            XAxiDma_BdRingUnAlloc(txRingPtr, reqBds, bdPtr);
+            return E_AXISDMA_FAILED;
+        }
+    }
+
+    /* one tail pointer update for the whole batch */
+    rc = XAxiDma_BdRingToHw(txRingPtr, reqBds, bdPtr);
+    if (rc != XST_SUCCESS) {
+        AXISDMA_ERROR_PRINT("Failed to hw, %d bds\r\n", reqBds);
+        XAxiDma_BdRingUnAlloc(txRingPtr, reqBds, bdPtr);
+        return E_AXISDMA_FAILED;
+    }
+    axisDmaCtrl_statsHw(&inst->stats.tx, txRingPtr, 0);
+    AXISDMA_TRACE(inst, AXISDMA_TRACE_TOHW, AXISDMA_TRACE_TX, bdPtr, 0, reqBds, 0);
+
+    return accepted;
+}
+
+int axisDmaCtrl_sendPacketIov(struct axisDmaCtrl *inst, const struct axisDmaCtrl_iovec *iov, int iovcnt)
+{
+    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
+    XAxiDma_Bd *bdPtr, *bdCurPtr;
+    int first = -1;
+    int last = -1;
+    int reqBds = 0;
+    int rc;
+    int i;
+
+    if (iov == NULL)
+        return XST_FAILURE;
+
+    /* SOF/EOF belong to the first/last segment that has data */
+    for (i = 0; i < iovcnt; i++) {
+        if (iov[i].len == 0)
+            continue;
+        if (first < 0)
+            first = i;
+        last = i;
+        reqBds += axisDmaCtrl_txBdsFor(inst, iov[i].len);
+    }
+    if (first < 0)
+        return XST_FAILURE;
+    if (inst->txqCnt) {
+        inst->stats.tx.nobds++;
+        return E_AXISDMA_NOBDS;
+    }
+
+    rc = XAxiDma_BdRingAlloc(txRingPtr, reqBds, &bdPtr);
+    if (rc != XST_SUCCESS) {
+        AXISDMA_ERROR_PRINT("Failed bd alloc (%d/%d)\r\n", reqBds, txRingPtr->FreeCnt);
+        inst->stats.tx.nobds++;
+        return E_AXISDMA_NOBDS;
+    }
+
+    bdCurPtr = bdPtr;
+    for (i = first; i <= last; i++) {
+        if (iov[i].len == 0)
+            continue;
+        if (axisDmaCtrl_txPoolIdx(inst, (uint32_t)(UINTPTR)iov[i].buf) < 0)
+            Xil_DCacheFlushRange((UINTPTR)iov[i].buf, iov[i].len);
+
+        bdCurPtr = axisDmaCtrl_txFillBds(inst, bdCurPtr,
+            (uint32_t)(UINTPTR)iov[i].buf, iov[i].len, i == first, i == last, iov[first].buf);
+        if (bdCurPtr == NULL) {
+            XAxiDma_BdRingUnAlloc(txRingPtr, reqBds, bdPtr);
+            return XST_FAILURE;
+        }
+    }
+
+    rc = XAxiDma_BdRingToHw(txRingPtr, reqBds, bdPtr);
+    if (rc != XST_SUCCESS) {
+        AXISDMA_ERROR_PRINT("Failed to hw, %d bds\r\n", reqBds);
+        XAxiDma_BdRingUnAlloc(txRingPtr, reqBds, bdPtr);
+        return XST_FAILURE;
+    }
+    axisDmaCtrl_statsHw(&inst->stats.tx, txRingPtr, 0);
+    AXISDMA_TRACE(inst, AXISDMA_TRACE_TOHW, AXISDMA_TRACE_TX, bdPtr, 0, reqBds, 0);
+
+    return XST_SUCCESS;
+}
+
+int axisDmaCtrl_txPrepare(struct axisDmaCtrl *inst, struct axisDmaCtrl_txPrep *prep, size_t packetSize)
+{
+    XAxiDma_BdRing *txRingPtr;
+    XAxiDma_Bd *bdPtr;
+    u32 wordLen;
+    u32 lastLen;
+    int nbds;
+
+    if (inst == NULL || prep == NULL || !TX_EN(inst))
+        return XST_INVALID_PARAM;
+    txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
+
+    nbds = axisDmaCtrl_txBdsFor(inst, packetSize);
+    if (nbds == 0 || nbds > (int)TX_BDS(txRingPtr))
+        return XST_INVALID_PARAM;
+    lastLen = packetSize - (nbds - 1) * BD_BUF_SIZE(inst);
+    if (lastLen > txRingPtr->MaxTransferLen ||
+        (nbds > 1 && BD_BUF_SIZE(inst) > txRingPtr->MaxTransferLen))
+        return XST_INVALID_PARAM;
+
+    /* the alignment XAxiDma_BdSetBufAddr would check on every bd */
+    bdPtr = (XAxiDma_Bd *)txRingPtr->FirstBdAddr;
+    wordLen = XAxiDma_BdRead(bdPtr, XAXIDMA_BD_HAS_DRE_OFFSET) & XAXIDMA_BD_WORDLEN_MASK;
+    prep->align = (wordLen && !XAxiDma_BdHasDRE(bdPtr)) ? wordLen - 1 : 0;
+    if (nbds > 1 && (BD_BUF_SIZE(inst) & prep->align))
+        return XST_INVALID_PARAM;
+
+    prep->len = packetSize;
+    prep->nbds = nbds;
+    prep->bd_len = BD_BUF_SIZE(inst);
+    prep->ctrl_first = BD_BUF_SIZE(inst) | XAXIDMA_BD_CTRL_TXSOF_MASK;
+    prep->ctrl_mid = BD_BUF_SIZE(inst);
+    prep->ctrl_last = lastLen | XAXIDMA_BD_CTRL_TXEOF_MASK;
+    if (nbds == 1)
+        prep->ctrl_last |= XAXIDMA_BD_CTRL_TXSOF_MASK;
+
+    return XST_SUCCESS;
+}
+
+int axisDmaCtrl_sendPrepared(struct axisDmaCtrl *inst, const struct axisDmaCtrl_txPrep *prep,
+    uint8_t * packetBuf, void *cookie)
+{
+    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
+    XAxiDma_Bd *bdPtr, *bdCurPtr;
+    u32 addr = (u32)(UINTPTR)packetBuf;
+    u32 ctrl;
+    u32 i;
+    int idx;
+    int rc;
+
+    if (addr & prep->align)
+        return XST_INVALID_PARAM;
+
+    /*
+     * Packets already queued go first. Only this context queues, the isr
+     * only adds free bds, so the check holds until the bds are allocated.
+     */
+    if (inst->params.tx_queue_depth && (inst->txqCnt || txRingPtr->FreeCnt < (int)prep->nbds))
+        return axisDmaCtrl_txSubmit(inst, packetBuf, prep->len, cookie, 0);
+
+    rc = XAxiDma_BdRingAlloc(txRingPtr, prep->nbds, &bdPtr);
+    if (rc != XST_SUCCESS) {
+        inst->stats.tx.nobds++;
+        return E_AXISDMA_NOBDS;
+    }
+
+    AXISDMA_TRACE(inst, AXISDMA_TRACE_SUBMIT, AXISDMA_TRACE_TX, bdPtr, addr, prep->len, 0);
+
+    /* only the buffer address differs from the previous packet */
+    bdCurPtr = bdPtr;
+    ctrl = prep->ctrl_first;
+    for (i = 1; i < prep->nbds; i++) {
+        XAxiDma_BdWrite(bdCurPtr, XAXIDMA_BD_BUFA_OFFSET, addr);
+        XAxiDma_BdWrite(bdCurPtr, XAXIDMA_BD_CTRL_LEN_OFFSET, ctrl);
+        ctrl = prep->ctrl_mid;
+        addr += prep->bd_len;
+        bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(txRingPtr, bdCurPtr);
+    }
+    XAxiDma_BdWrite(bdCurPtr, XAXIDMA_BD_BUFA_OFFSET, addr);
+    XAxiDma_BdWrite(bdCurPtr, XAXIDMA_BD_CTRL_LEN_OFFSET, prep->ctrl_last);
+
+    /* the isr only looks at the id (pool return) and cookie of the EOF bd */
+    XAxiDma_BdSetId(bdCurPtr, addr);
+    idx = axisDmaCtrl_txBdIdx(txRingPtr, bdCurPtr);
+    inst->txCookie[idx] = cookie;
+    inst->txBulk[idx] = 0;
+
+    rc = XAxiDma_BdRingToHw(txRingPtr, prep->nbds, bdPtr);
+    if (rc != XST_SUCCESS) {
+        AXISDMA_ERROR_PRINT("Failed to hw, %d bds\r\n", (int)prep->nbds);
+        XAxiDma_BdRingUnAlloc(txRingPtr, prep->nbds, bdPtr);
+        return XST_FAILURE;
+    }
+    axisDmaCtrl_statsHw(&inst->stats.tx, txRingPtr, 0);
+    AXISDMA_TRACE(inst, AXISDMA_TRACE_TOHW, AXISDMA_TRACE_TX, bdPtr, 0, prep->nbds, 0);
+
+    return XST_SUCCESS;
+}
+
+/*
+ * Single packet path of every submit call but the batch and gather ones.
+ * With the tx queue a packet goes straight to hardware only when nothing
+ * waits in any queue and the ring (and for bulk data the bulk cap) has
+ * room, otherwise it is queued at its priority.
+ */
+static int axisDmaCtrl_txSubmit(struct axisDmaCtrl *inst, uint8_t * packetBuf, size_t packetSize,
+    void *cookie, int prio)
+{
+    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
+    struct txQueue *q = &inst->txq[prio];
+    u32 high = inst->params.tx_queue_high ? inst->params.tx_queue_high : inst->params.tx_queue_depth;
+    int reqBds;
+    int rc;
+
+    if (inst->params.tx_queue_depth == 0)
+        return axisDmaCtrl_txPacket(inst, packetBuf, packetSize, cookie, 0);
+
+    /* would never leave the queue */
+    reqBds = axisDmaCtrl_txBdsFor(inst, packetSize);
+    if (reqBds == 0 || reqBds > (int)TX_BDS(txRingPtr))
+        return XST_INVALID_PARAM;
+
+    XScuGic_Disable(inst->intc, inst->params.txIrqId);
+    if (inst->txqCnt == 0 && txRingPtr->FreeCnt >= reqBds &&
+        (prio == 0 || axisDmaCtrl_txBulkRoom(inst, reqBds))) {
+        rc = axisDmaCtrl_txPacket(inst, packetBuf, packetSize, cookie, prio);
+    } else if (q->cnt < inst->params.tx_queue_depth) {
+        struct txq_entry *ent = &q->ent[(q->head + q->cnt) & TXQ_MASK];
+
+        ent->buf = packetBuf;
+        ent->len = packetSize;
+        ent->cookie = cookie;
+        q->cnt++;
+        inst->txqCnt++;
+        if (!inst->txqStopped && inst->txqCnt >= high) {
+            inst->txqStopped = 1;
+            if (inst->txFlowCb != NULL)
+                inst->txFlowCb(inst->cbCtx, 1);
+        }
+        rc = XST_SUCCESS;
+    } else {
+        inst->stats.tx.nobds++;
+        rc = E_AXISDMA_NOBDS;
+    }
+    XScuGic_Enable(inst->intc, inst->params.txIrqId);
+
+    return rc;
+}
+
+/*
+ * Moves queued packets into the tx ring in the order the scheduler picks
+ * them for as long as they fit. Runs from the tx isr or with the tx irq
+ * masked. A packet whose bds are rejected would block its queue for good,
+ * it is dropped and completed with a failed status instead.
+ */
+static void axisDmaCtrl_txQueuePush(struct axisDmaCtrl *inst)
+{
+    struct txq_entry bad;
+
+    /* the callback of a dropped packet may submit, run it between batches */
+    while (axisDmaCtrl_txQueueMove(inst, &bad)) {
+        inst->stats.tx.dropped++;
+        if (axisDmaCtrl_txPoolIdx(inst, (uint32_t)(UINTPTR)bad.buf) >= 0)
+            inst->txPool[inst->txPoolCnt++] = (uint32_t)(UINTPTR)bad.buf;
+        if (inst->txPktCb != NULL)
+            inst->txPktCb(inst->cbCtx, bad.cookie, 0, 0);
+    }
+
+    if (inst->txqStopped && inst->txqCnt <= inst->params.tx_queue_low) {
+        inst->txqStopped = 0;
+        if (inst->txFlowCb != NULL)
+            inst->txFlowCb(inst->cbCtx, 0);
     }
+}
+
+/*
+ * One batch of axisDmaCtrl_txQueuePush. Each packet gets its own bd
+ * allocation, the tail pointer is updated once for all of them. Stops
+ * early at a packet whose bds were rejected, takes it off its queue into
+ * bad and returns 1.
+ */
+static int axisDmaCtrl_txQueueMove(struct axisDmaCtrl *inst, struct txq_entry *bad)
+{
+    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
+    XAxiDma_Bd *bdPtr = NULL;
+    XAxiDma_Bd *bdCurPtr;
+    u32 bulkBds = 0;
+    int reqBds = 0;
+    int dropped = 0;
+    int prio;
+    int rc;
+
+    while ((prio = axisDmaCtrl_txSchedPick(inst, txRingPtr->FreeCnt)) >= 0) {
+        struct txQueue *q = &inst->txq[prio];
+        struct txq_entry *ent = &q->ent[q->head & TXQ_MASK];
+        int bds = axisDmaCtrl_txBdsFor(inst, ent->len);
 
-    if (params.rxEn) {
-        rc = axisDmaCtrl_rxSetup(&axiDma);
+        rc = XAxiDma_BdRingAlloc(txRingPtr, bds, &bdCurPtr);
         if (rc != XST_SUCCESS) {
-            AXISDMA_ERROR_PRINT("Failed RX setup\r\n");
-            return XST_FAILURE;
+            AXISDMA_ERROR_PRINT("Failed bd alloc (%d/%d)\r\n", bds, txRingPtr->FreeCnt);
+            break;
+        }
+        if (axisDmaCtrl_txFillBds(inst, bdCurPtr, (uint32_t)(UINTPTR)ent->buf,
+                ent->len, 1, 1, ent->cookie) == NULL) {
+            XAxiDma_BdRingUnAlloc(txRingPtr, bds, bdCurPtr);
+            *bad = *ent;
+            q->head++;
+            q->cnt--;
+            inst->txqCnt--;
+            dropped = 1;
+            break;
+        }
+        if (prio > 0) {
+            axisDmaCtrl_txBulkMark(inst, bdCurPtr, bds);
+            bulkBds += bds;
+            if (inst->txqCredit > 0)
+                inst->txqCredit--;
         }
+        if (bdPtr == NULL)
+            bdPtr = bdCurPtr;
+        reqBds += bds;
+        q->head++;
+        q->cnt--;
+        inst->txqCnt--;
     }
+    if (reqBds == 0)
+        return dropped;
 
-    /* Set up Interrupt system  */
-    rc = axisDmaCtrl_setupIntrSystem(intcInstancePtr);
+    rc = XAxiDma_BdRingToHw(txRingPtr, reqBds, bdPtr);
     if (rc != XST_SUCCESS) {
-        AXISDMA_ERROR_PRINT("Failed interrupt setup\r\n");
-        return XST_FAILURE;
+        /* the packets are off their queues already, they are lost */
+        AXISDMA_ERROR_PRINT("Failed to hw, %d bds\r\n", reqBds);
+        XAxiDma_BdRingUnAlloc(txRingPtr, reqBds, bdPtr);
+        inst->txBulkBds -= bulkBds;
+    } else {
+        axisDmaCtrl_statsHw(&inst->stats.tx, txRingPtr, 0);
+        AXISDMA_TRACE(inst, AXISDMA_TRACE_TOHW, AXISDMA_TRACE_TX, bdPtr, 0, reqBds, 0);
     }
 
-    return XST_SUCCESS;
+    return dropped;
 }
 
-void axisDmaCtrl_printParams(struct axisDmaCtrl_params *in)
+/*
+ * Tx scheduler, returns the priority whose oldest packet goes to hardware
+ * next, -1 when none may. Priority 0 always comes first, the bulk ones
+ * follow in strict order or take turns of tx_weight[] packets. A packet
+ * that does not fit yet is never overtaken.
+ */
+static int axisDmaCtrl_txSchedPick(struct axisDmaCtrl *inst, int freeBds)
 {
-    printf("rx_bd_space_base      : 0x%x\r\n",(unsigned int)in->rx_bd_space_base);
-    printf("rx_bd_space_high      : 0x%x\r\n",(unsigned int)in->rx_bd_space_high);
-    printf("tx_bd_space_base      : 0x%x\r\n",(unsigned int)in->tx_bd_space_base);
-    printf("tx_bd_space_high      : 0x%x\r\n",(unsigned int)in->tx_bd_space_high);
-    printf("tx_buffer_base        : 0x%x\r\n",(unsigned int)in->tx_buffer_base);
-    printf("tx_buffer_high        : 0x%x\r\n",(unsigned int)in->tx_buffer_high);
-    printf("rx_buffer_base        : 0x%x\r\n",(unsigned int)in->rx_buffer_base);
-    printf("rx_buffer_high        : 0x%x\r\n",(unsigned int)in->rx_buffer_high);
-    printf("bd_buf_size           : 0x%x\r\n",(unsigned int)in->bd_buf_size);
-    printf("dmaDevId              : 0x%x\r\n",(unsigned int)in->dmaDevId);
-    printf("txEn                  : %u\r\n",in->txEn);
-    printf("txIrqPriority         : 0x%x\r\n",(unsigned int)in->txIrqPriority);
-    printf("txIrqId               : 0x%x\r\n",(unsigned int)in->txIrqId);
-    printf("rxEn                  : %u\r\n",in->rxEn);
-    printf("coalesce_count        : %u\r\n",in->coalesce_count);
-    printf("rxIrqId               : 0x%x\r\n",(unsigned int)in->rxIrqId);
-    printf("rxIrqPriority         : 0x%x\r\n",(unsigned int)in->rxIrqPriority);
-}
+    int p;
 
-void axisDmaCtrl_disable(XScuGic * intcInstancePtr)
-{
-    axisDmaCtrl_disableIntrSystem(intcInstancePtr);
-    _tx_cb = NULL;
-    _rx_cb = NULL;
-    axisDmaCtrl_emptyParamsStruct(&params);
-}
+    if (inst->txq[0].cnt)
+        return axisDmaCtrl_txSchedFits(inst, 0, freeBds) ? 0 : -1;
 
-int axisDmaCtrl_register_tx_cb(dma_tx_cb_t cb)
-{
-    if (cb == NULL)
-        return XST_FAILURE;
-    XAxiDma_Pause(&axiDma);
-    _tx_cb = cb;
-    XAxiDma_Resume(&axiDma);
-    return XST_SUCCESS;
+    if (inst->params.tx_sched != AXISDMA_TX_SCHED_WEIGHTED) {
+        for (p = 1; p < AXISDMA_TXQ_PRIOS; p++)
+            if (inst->txq[p].cnt)
+                return axisDmaCtrl_txSchedFits(inst, p, freeBds) ? p : -1;
+        return -1;
+    }
+
+    /* stay with the current priority while it has packets and credit left */
+    for (p = 0; p < AXISDMA_TXQ_PRIOS; p++) {
+        if (inst->txqCredit > 0 && inst->txq[inst->txqCur].cnt)
+            return axisDmaCtrl_txSchedFits(inst, inst->txqCur, freeBds) ? inst->txqCur : -1;
+        inst->txqCur = inst->txqCur + 1 < AXISDMA_TXQ_PRIOS ? inst->txqCur + 1 : 1;
+        inst->txqCredit = inst->params.tx_weight[inst->txqCur] ? inst->params.tx_weight[inst->txqCur] : 1;
+    }
+    return -1;
 }
 
-int axisDmaCtrl_register_rx_cb(dma_rx_cb_t cb)
+/* whether the oldest packet of prio fits the ring, and the cap for bulk data */
+static int axisDmaCtrl_txSchedFits(struct axisDmaCtrl *inst, int prio, int freeBds)
 {
-    if (cb == NULL)
-        return XST_FAILURE;
-    XAxiDma_Pause(&axiDma);
-    _rx_cb = cb;
-    XAxiDma_Resume(&axiDma);
-    return XST_SUCCESS;
+    struct txQueue *q = &inst->txq[prio];
+    int bds = axisDmaCtrl_txBdsFor(inst, q->ent[q->head & TXQ_MASK].len);
+
+    return bds <= freeBds && (prio == 0 || axisDmaCtrl_txBulkRoom(inst, bds));
 }
 
-int axisDmaCtrl_getAvailTxBds(void)
+/* a bulk packet bigger than the cap still goes out once the others are done */
+static int axisDmaCtrl_txBulkRoom(struct axisDmaCtrl *inst, int bds)
 {
-    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&axiDma);
-    return txRingPtr->FreeCnt;
+    return inst->params.tx_bulk_max_bds == 0 || inst->txBulkBds == 0 ||
+        inst->txBulkBds + bds <= inst->params.tx_bulk_max_bds;
 }
 
-int axisDmaCtrl_getAvailRxBds(void)
+/* counts the bds of a bulk packet starting at bdPtr until its EOF bd completes */
+static void axisDmaCtrl_txBulkMark(struct axisDmaCtrl *inst, XAxiDma_Bd * bdPtr, int bds)
 {
-    XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&axiDma);
-    return rxRingPtr->FreeCnt;
+    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
+
+    inst->txBulk[(axisDmaCtrl_txBdIdx(txRingPtr, bdPtr) + bds - 1) % TX_BDS(txRingPtr)] = bds;
+    inst->txBulkBds += bds;
 }
 
-int axisDmaCtrl_sendPackets(uint8_t * packetBuf, size_t packetSize)
+/*
+ * Splits packetBuf into bd_buf_size bds and hands them to the hardware.
+ * Cache maintenance is up to the caller.
+ */
+static int axisDmaCtrl_txPacket(struct axisDmaCtrl *inst, uint8_t * packetBuf, size_t packetSize,
+    void *cookie, int prio)
 {
-    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&axiDma);
-    XAxiDma_Bd *bdPtr, *bdCurPtr;
+    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
+    XAxiDma_Bd *bdPtr;
     int rc;
-    u32 BufferAddr;
     int reqBds;
-    int i;
-    size_t remaining_bytes;
 
     /* find number of bds required */
-    remaining_bytes = packetSize;
-    reqBds = packetSize / params.bd_buf_size;
-    reqBds += (packetSize % params.bd_buf_size) ? 1 : 0;
-    
-    /* Flush the SrcBuffer before the DMA transfer, in case the Data Cache
-     * is enabled */
-    Xil_DCacheFlushRange((UINTPTR)packetBuf, params.bd_buf_size * reqBds);
+    reqBds = axisDmaCtrl_txBdsFor(inst, packetSize);
 
     rc = XAxiDma_BdRingAlloc(txRingPtr, reqBds, &bdPtr);
     if (rc != XST_SUCCESS) {
         AXISDMA_ERROR_PRINT("Failed bd alloc (%d/%d)\r\n", reqBds, txRingPtr->FreeCnt);
+        inst->stats.tx.nobds++;
         return E_AXISDMA_NOBDS;
     }
 
-    BufferAddr = (UINTPTR)packetBuf;
-    bdCurPtr = bdPtr;
+    AXISDMA_DEBUG_PRINT("pkt_len : %d, # bds req %d\r\n",(int)packetSize, reqBds);
+
+    if (axisDmaCtrl_txFillBds(inst, bdPtr, (UINTPTR)packetBuf,
+            packetSize, 1, 1, cookie) == NULL) {
+        XAxiDma_BdRingUnAlloc(txRingPtr, reqBds, bdPtr);
+        return XST_FAILURE;
+    }
+    if (prio > 0)
+        axisDmaCtrl_txBulkMark(inst, bdPtr, reqBds);
+
+    /* Give the BD to hardware */
+    rc = XAxiDma_BdRingToHw(txRingPtr, reqBds, bdPtr);
+    if (rc != XST_SUCCESS) {
+        AXISDMA_ERROR_PRINT("Failed to hw, length %d\r\n",
+            (int)XAxiDma_BdGetLength(bdPtr,txRingPtr->MaxTransferLen));
+        XAxiDma_BdRingUnAlloc(txRingPtr, reqBds, bdPtr);
+        if (prio > 0)
+            inst->txBulkBds -= reqBds;
+        return XST_FAILURE;
+    }
+    axisDmaCtrl_statsHw(&inst->stats.tx, txRingPtr, 0);
+    AXISDMA_TRACE(inst, AXISDMA_TRACE_TOHW, AXISDMA_TRACE_TX, bdPtr, 0, reqBds, 0);
+
+    return XST_SUCCESS;
+}
+
+/* number of bd_buf_size bds a segment of len bytes takes */
+static int axisDmaCtrl_txBdsFor(struct axisDmaCtrl *inst, size_t len)
+{
+    return len / BD_BUF_SIZE(inst) + ((len % BD_BUF_SIZE(inst)) ? 1 : 0);
+}
+
+/*
+ * Fills the bds starting at bdCurPtr with one contiguous segment cut into
+ * bd_buf_size pieces. SOF goes on the first piece when sof is set and EOF
+ * on the last piece when eof is set, cookie is kept for the EOF bd.
+ *
+ * Returns the bd following the segment, NULL if a bd was rejected.
+ */
+static XAxiDma_Bd *axisDmaCtrl_txFillBds(struct axisDmaCtrl *inst,
+    XAxiDma_Bd * bdCurPtr, u32 BufferAddr, size_t len, int sof, int eof, void *cookie)
+{
+    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
+    int reqBds = axisDmaCtrl_txBdsFor(inst, len);
+    size_t remaining_bytes = len;
+    int idx;
+    int rc;
+    int i;
 
-    AXISDMA_DEBUG_PRINT("pkt_len : %d, # bds req %d\r\n",packetSize, reqBds);
+    AXISDMA_TRACE(inst, AXISDMA_TRACE_SUBMIT, AXISDMA_TRACE_TX, bdCurPtr, BufferAddr, len, 0);
 
     for (i = 0; i < reqBds; i++) {
         u32 CrBits = 0;
         size_t bytes2send = 0;
 
-        /* if this is the only bd send the full received packetSize */
+        /* if this is the last bd send the remaining bytes */
         if (i == reqBds - 1) {
             bytes2send = remaining_bytes;
         }
         /* else send the maximum buffer_size and calculate number of remaining bytes */
         else {
-            bytes2send = params.bd_buf_size;
-            remaining_bytes -= params.bd_buf_size;
+            bytes2send = BD_BUF_SIZE(inst);
+            remaining_bytes -= BD_BUF_SIZE(inst);
         }
 
         rc = XAxiDma_BdSetBufAddr(bdCurPtr, BufferAddr);
         if (rc != XST_SUCCESS) {
             AXISDMA_ERROR_PRINT("Tx set buffer addr %x on BD %x failed %d\r\n",
             (unsigned int)BufferAddr,
-            (UINTPTR)bdPtr, rc);
-            return XST_FAILURE;
+            (unsigned int)(UINTPTR)bdCurPtr, rc);
+            return NULL;
         }
 
         rc = XAxiDma_BdSetLength(bdCurPtr, (uint32_t)bytes2send,
                     txRingPtr->MaxTransferLen);
         if (rc != XST_SUCCESS) {
             AXISDMA_ERROR_PRINT("Tx set length %d on BD %x failed %d\r\n",
-            params.bd_buf_size, (UINTPTR)bdCurPtr, rc);
-            return XST_FAILURE;
+            (int)bytes2send, (unsigned int)(UINTPTR)bdCurPtr, rc);
+            return NULL;
         }
 
-        if (i == 0)
+        if (i == 0 && sof)
             CrBits |= XAXIDMA_BD_CTRL_TXSOF_MASK;
-        if (i == reqBds - 1)
+        if (i == reqBds - 1 && eof) {
             CrBits |= XAXIDMA_BD_CTRL_TXEOF_MASK;
+            idx = axisDmaCtrl_txBdIdx(txRingPtr, bdCurPtr);
+            inst->txCookie[idx] = cookie;
+            inst->txBulk[idx] = 0;
+        }
 
         XAxiDma_BdSetCtrl(bdCurPtr, CrBits);
         XAxiDma_BdSetId(bdCurPtr, BufferAddr);
 
-        if (i != reqBds-1) {
-            BufferAddr += params.bd_buf_size;
-            bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(txRingPtr, bdCurPtr);
-        }
-    }
-
-    /* Give the BD to hardware */
-    rc = XAxiDma_BdRingToHw(txRingPtr, reqBds, bdPtr);
-    if (rc != XST_SUCCESS) {
-        AXISDMA_ERROR_PRINT("Failed to hw, length %d\r\n",
-            (int)XAxiDma_BdGetLength(bdPtr,txRingPtr->MaxTransferLen));
-        return XST_FAILURE;
+        BufferAddr += BD_BUF_SIZE(inst);
+        bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(txRingPtr, bdCurPtr);
     }
 
-    return XST_SUCCESS;
+    return bdCurPtr;
 }
 
-static int axisDmaCtrl_markMemNoncache(void)
+static int axisDmaCtrl_markMemNoncache(struct axisDmaCtrl *inst)
 {
     size_t i = 0;
     int invalid_struct = 0;
-    invalid_struct |= (!params.txEn && !params.rxEn)
-            | (params.rxEn && params.coalesce_count == 0)
-            | (params.rxEn && ((params.rx_bd_space_high - params.rx_bd_space_base) == 0))
-            | (params.rxEn && ((params.rx_buffer_high   - params.rx_buffer_base) == 0))
-            | (params.txEn && ((params.tx_bd_space_high - params.tx_bd_space_base) == 0))
-            | (params.txEn && ((params.tx_buffer_high   - params.tx_buffer_base) == 0)
+    invalid_struct |= (!inst->params.txEn && !inst->params.rxEn)
+            | (inst->params.rxEn && inst->params.coalesce_count == 0 && !inst->params.rx_coalesce.adaptive)
+            | (inst->params.txEn && inst->params.coalesce_count == 0 && !inst->params.tx_coalesce.adaptive)
+            | (inst->params.rx_mode > AXISDMA_RX_MODE_BUSYPOLL)
+            | (inst->params.rx_mode != AXISDMA_RX_MODE_IRQ && inst->params.rx_deferred)
+            | (inst->params.rx_cyclic && (inst->params.rx_deferred || inst->params.rx_lend ||
+                inst->params.rx_mode != AXISDMA_RX_MODE_IRQ))
+            | (inst->params.rx_block_size && (inst->params.rx_lend || inst->params.rx_cyclic ||
+                inst->params.bd_buf_size == 0 || (inst->params.rx_block_size % inst->params.bd_buf_size) ||
+                (inst->params.rx_block_size * 2 > (inst->params.rx_buffer_high - inst->params.rx_buffer_base + 1))))
+            | (inst->params.rx_coalesce.adaptive && (inst->params.rx_coalesce.min_count == 0 ||
+                inst->params.rx_coalesce.min_count > inst->params.rx_coalesce.max_count))
+            | (inst->params.tx_coalesce.adaptive && (inst->params.tx_coalesce.min_count == 0 ||
+                inst->params.tx_coalesce.min_count > inst->params.tx_coalesce.max_count))
+            | (inst->params.rxEn && ((inst->params.rx_bd_space_high - inst->params.rx_bd_space_base) == 0))
+            | (inst->params.rxEn && ((inst->params.rx_buffer_high   - inst->params.rx_buffer_base) == 0))
+            | (inst->params.txEn && ((inst->params.tx_bd_space_high - inst->params.tx_bd_space_base) == 0))
+            | (inst->params.txEn && ((inst->params.tx_buffer_high   - inst->params.tx_buffer_base) == 0))
+            | (inst->params.txEn && (inst->params.tx_block_size > (inst->params.tx_buffer_high - inst->params.tx_buffer_base + 1)))
+            /* invalidating a partial line would throw away a neighbours data */
+            | (inst->params.rxEn && inst->params.cacheable_bufs &&
+                ((inst->params.rx_buffer_base % AXISDMA_CACHE_LINE_SIZE) ||
+                (inst->params.bd_buf_size % AXISDMA_CACHE_LINE_SIZE))
             );
+    /* a static build only drives the geometry it was compiled for */
+#ifdef AXISDMA_STATIC_BD_BUF_SIZE
+    invalid_struct |= (inst->params.bd_buf_size != AXISDMA_STATIC_BD_BUF_SIZE);
+#endif
+#ifdef AXISDMA_STATIC_TXEN
+    invalid_struct |= (!inst->params.txEn != !AXISDMA_STATIC_TXEN);
+#endif
+#ifdef AXISDMA_STATIC_RXEN
+    invalid_struct |= (!inst->params.rxEn != !AXISDMA_STATIC_RXEN);
+#endif
     if (invalid_struct)
         return XST_FAILURE;
-    if (params.rxEn) {
-        for (i = params.rx_bd_space_base; i <= params.rx_bd_space_high; i += ONE_MB)
-            Xil_SetTlbAttributes(i, NORM_NONCACHE);
-        for (i = params.rx_buffer_base; i <= params.rx_buffer_high; i += ONE_MB)
+    if (RX_EN(inst)) {
+        for (i = inst->params.rx_bd_space_base; i <= inst->params.rx_bd_space_high; i += ONE_MB)
             Xil_SetTlbAttributes(i, NORM_NONCACHE);
+        if (!inst->params.cacheable_bufs)
+            for (i = inst->params.rx_buffer_base; i <= inst->params.rx_buffer_high; i += ONE_MB)
+                Xil_SetTlbAttributes(i, NORM_NONCACHE);
     }
-    if (params.txEn) {
-        for (i = params.tx_bd_space_base; i <= params.tx_bd_space_high; i += ONE_MB)
-            Xil_SetTlbAttributes(i, NORM_NONCACHE);
-        for (i = params.tx_buffer_base; i <= params.tx_buffer_high; i += ONE_MB)
+    if (TX_EN(inst)) {
+        for (i = inst->params.tx_bd_space_base; i <= inst->params.tx_bd_space_high; i += ONE_MB)
             Xil_SetTlbAttributes(i, NORM_NONCACHE);
+        if (!inst->params.cacheable_bufs || inst->params.tx_block_size)
+            for (i = inst->params.tx_buffer_base; i <= inst->params.tx_buffer_high; i += ONE_MB)
+                Xil_SetTlbAttributes(i, NORM_NONCACHE);
     }
     return XST_SUCCESS;
 }
@@ -311,6 +1575,8 @@ static struct axisDmaCtrl_params axisDmaCtrl_copyParamsStruct(struct axisDmaCtrl
     tmp.rx_buffer_base   = in->rx_buffer_base;
     tmp.rx_buffer_high   = in->rx_buffer_high;
     tmp.bd_buf_size      = in->bd_buf_size;
+    tmp.tx_block_size    = in->tx_block_size;
+    tmp.rx_block_size    = in->rx_block_size;
     tmp.txEn             = in->txEn;
     tmp.txIrqId          = in->txIrqId;
     tmp.txIrqPriority    = in->txIrqPriority;
@@ -319,6 +1585,23 @@ static struct axisDmaCtrl_params axisDmaCtrl_copyParamsStruct(struct axisDmaCtrl
     tmp.rxIrqPriority    = in->rxIrqPriority;
     tmp.rxIrqId          = in->rxIrqId;
     tmp.dmaDevId         = in->dmaDevId;
+    tmp.cacheable_bufs   = in->cacheable_bufs;
+    tmp.rx_deferred      = in->rx_deferred;
+    tmp.rx_lend          = in->rx_lend;
+    tmp.rx_mode          = in->rx_mode;
+    tmp.rx_cyclic        = in->rx_cyclic;
+    tmp.rx_refill_watermark = in->rx_refill_watermark;
+    tmp.rx_block_timeout_us = in->rx_block_timeout_us;
+    tmp.stall_timeout_us = in->stall_timeout_us;
+    tmp.stall_recover    = in->stall_recover;
+    tmp.tx_queue_depth   = in->tx_queue_depth;
+    tmp.tx_queue_high    = in->tx_queue_high;
+    tmp.tx_queue_low     = in->tx_queue_low;
+    tmp.tx_sched         = in->tx_sched;
+    memcpy(tmp.tx_weight, in->tx_weight, sizeof(tmp.tx_weight));
+    tmp.tx_bulk_max_bds  = in->tx_bulk_max_bds;
+    tmp.tx_coalesce      = in->tx_coalesce;
+    tmp.rx_coalesce      = in->rx_coalesce;
     return tmp;
 }
 
@@ -333,26 +1616,52 @@ static void axisDmaCtrl_emptyParamsStruct(struct axisDmaCtrl_params * in)
     in->rx_buffer_base   = 0;
     in->rx_buffer_high   = 0;
     in->bd_buf_size      = 0;
+    in->tx_block_size    = 0;
+    in->rx_block_size    = 0;
     in->coalesce_count   = 1;
     in->rxIrqPriority    = 0xff;
     in->txIrqPriority    = 0xff;
     in->txEn             = 0;
     in->rxEn             = 0;
+    in->cacheable_bufs   = 0;
+    in->rx_deferred      = 0;
+    in->rx_lend          = 0;
+    in->rx_mode          = AXISDMA_RX_MODE_IRQ;
+    in->rx_cyclic        = 0;
+    in->rx_refill_watermark = 0;
+    in->rx_block_timeout_us = 0;
+    in->stall_timeout_us = 0;
+    in->stall_recover    = 0;
+    in->tx_queue_depth   = 0;
+    in->tx_queue_high    = 0;
+    in->tx_queue_low     = 0;
+    in->tx_sched         = AXISDMA_TX_SCHED_STRICT;
+    memset(in->tx_weight, 0, sizeof(in->tx_weight));
+    in->tx_bulk_max_bds  = 0;
+    memset(&in->tx_coalesce, 0, sizeof(in->tx_coalesce));
+    memset(&in->rx_coalesce, 0, sizeof(in->rx_coalesce));
 }
 
-static void axisDmaCtrl_txIrqBdHandler(XAxiDma_BdRing * txRingPtr)
+static int axisDmaCtrl_txIrqBdHandler(struct axisDmaCtrl *inst)
 {
+    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
     int bdCount;
     u32 bdSts;
+    u32 bdCtrl;
+    u32 bdLen;
     XAxiDma_Bd *bdPtr;
     XAxiDma_Bd *bdCurPtr;
+    int eofIdx = 0;
     int rc;
     int i;
+    AXISDMA_LAT_VAR(t);
 
     /* Get all processed BDs from hardware */
     bdCount = XAxiDma_BdRingFromHw(txRingPtr, XAXIDMA_ALL_BDS, &bdPtr);
     if (bdCount < 1)
-        return;
+        return 0;
+    axisDmaCtrl_statsHw(&inst->stats.tx, txRingPtr, 1);
+    bdCount = axisDmaCtrl_txReapWhole(txRingPtr, bdPtr, bdCount);
 
     /* Handle the BDs */
     bdCurPtr = bdPtr;
@@ -374,34 +1683,83 @@ static void axisDmaCtrl_txIrqBdHandler(XAxiDma_BdRing * txRingPtr)
                 AXISDMA_ERROR_PRINT("All Errors\r\n");
             else
                 AXISDMA_ERROR_PRINT("Unspecified\r\n");
-            return;
+            /* the engine halted here, this bd and the ones behind it stay
+             * in the post state until axisDmaCtrl_recover accounts them */
+            bdCount = i;
+            break;
         }
 
-        _tx_cb();
+        bdCtrl = XAxiDma_BdGetCtrl(bdCurPtr);
+        bdLen = XAxiDma_BdGetLength(bdCurPtr, txRingPtr->MaxTransferLen);
+        inst->stats.tx.bds++;
+        inst->stats.tx.bytes += bdLen;
+        if (bdCtrl & XAXIDMA_BD_CTRL_TXEOF_MASK)
+            inst->stats.tx.pkts++;
+        AXISDMA_TRACE(inst, AXISDMA_TRACE_COMPLETE, AXISDMA_TRACE_TX, bdCurPtr, XAxiDma_BdGetBufAddr(bdCurPtr),
+            bdLen, bdSts);
+        inst->txPktBytes += bdLen;
 
         /*
-         * Here we don't need to do anything. But if a RTOS is being
-         * used, we may need to free the packet buffer attached to
-         * the processed BD
+         * A pool block goes back once the last bd of its packet is out,
+         * every bd id lies inside the block it was cut from. Before the
+         * callback so the packet callback can take it right away. The
+         * bds of a bulk packet stop counting against the bulk cap.
          */
+        if (bdCtrl & XAXIDMA_BD_CTRL_TXEOF_MASK) {
+            eofIdx = axisDmaCtrl_txBdIdx(txRingPtr, bdCurPtr);
+            inst->txBulkBds -= inst->txBulk[eofIdx];
+            if (inst->txPoolSize) {
+                int idx = axisDmaCtrl_txPoolIdx(inst, XAxiDma_BdGetId(bdCurPtr));
+
+                if (idx >= 0)
+                    inst->txPool[inst->txPoolCnt++] = inst->params.tx_buffer_base + idx * inst->params.tx_block_size;
+            }
+        }
+
+        if (inst->txPktCb == NULL) {
+            AXISDMA_TRACE(inst, AXISDMA_TRACE_CALLBACK, AXISDMA_TRACE_TX, bdCurPtr, XAxiDma_BdGetBufAddr(bdCurPtr), 0, 0);
+            AXISDMA_LAT_START(t);
+            inst->txCb(inst->cbCtx);
+            AXISDMA_LAT_END(inst, AXISDMA_LAT_TX_CB, t);
+        } else if (bdCtrl & XAXIDMA_BD_CTRL_TXEOF_MASK) {
+            void *cookie = inst->txCookie[eofIdx];
+
+            AXISDMA_TRACE(inst, AXISDMA_TRACE_CALLBACK, AXISDMA_TRACE_TX, bdCurPtr,
+                (u32)(UINTPTR)cookie, inst->txPktBytes, bdSts);
+            AXISDMA_LAT_START(t);
+            inst->txPktCb(inst->cbCtx, cookie, inst->txPktBytes, bdSts);
+            AXISDMA_LAT_END(inst, AXISDMA_LAT_TX_CB, t);
+        }
+        if (bdCtrl & XAXIDMA_BD_CTRL_TXEOF_MASK)
+            inst->txPktBytes = 0;
 
         /* Find the next processed BD */
         if (i != bdCount-1)
             bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(txRingPtr, bdCurPtr);
     }
 
+    if (bdCount == 0)
+        return 0;
+
     /* Free all processed BDs for future transmission */
+    AXISDMA_TRACE(inst, AXISDMA_TRACE_FREE, AXISDMA_TRACE_TX, bdPtr, 0, bdCount, 0);
     rc = XAxiDma_BdRingFree(txRingPtr, bdCount, bdPtr);
     if (rc != XST_SUCCESS) {
         AXISDMA_ERROR_PRINT("XAxiDma_BdRingFree\r\n");
     }
+
+    /* the freed bds go to what waits in the tx queue */
+    if (inst->txqCnt)
+        axisDmaCtrl_txQueuePush(inst);
+
+    return bdCount;
 }
 
 static void axisDmaCtrl_txIntrHandler(void *callback)
 {
-    XAxiDma_BdRing *txRingPtr = (XAxiDma_BdRing *) callback;
+    struct axisDmaCtrl *inst = (struct axisDmaCtrl *) callback;
+    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
     u32 irqStatus;
-    int timeOut;
 
     /* Read pending interrupts */
     irqStatus = XAxiDma_BdRingGetIrq(txRingPtr);
@@ -416,114 +1774,624 @@ static void axisDmaCtrl_txIntrHandler(void *callback)
     }
 
     /*
-     * If error interrupt is asserted, raise error flag, reset the
-     * hardware to recover from the error, and return with no further
-     * processing.
+     * If error interrupt is asserted, raise the error flag and return with
+     * no further processing. The channel is halted, axisDmaCtrl_recover
+     * resets the hardware and rebuilds the rings from thread context.
      */
     if ((irqStatus & XAXIDMA_IRQ_ERROR_MASK)) {
 
-        XAxiDma_BdRingDumpRegs(txRingPtr);
-        AXISDMA_ERROR_PRINT("XAXIDMA_IRQ_ERROR_MASK\r\n");
+        XAxiDma_BdRingDumpRegs(txRingPtr);
+        AXISDMA_ERROR_PRINT("XAXIDMA_IRQ_ERROR_MASK\r\n");
+        inst->stats.tx.err_irqs++;
+        inst->errPending |= AXISDMA_ERR_TX;
+        AXISDMA_TRACE(inst, AXISDMA_TRACE_ERROR, AXISDMA_TRACE_TX, 0, 0, 0, irqStatus);
+        return;
+    }
+
+    /*
+     * If Transmit done interrupt is asserted, call TX call back function
+     * to handle the processed BDs and raise the according flag
+     */
+    if ((irqStatus & (XAXIDMA_IRQ_DELAY_MASK | XAXIDMA_IRQ_IOC_MASK))) {
+        int bdCount = axisDmaCtrl_txIrqBdHandler(inst);
+
+        inst->stats.tx.irqs++;
+        if ((u32)bdCount > inst->stats.tx.irq_bds_max)
+            inst->stats.tx.irq_bds_max = bdCount;
+
+        if (inst->params.tx_coalesce.adaptive)
+            axisDmaCtrl_coalesceAdapt(txRingPtr, &inst->txCoal,
+                &inst->params.tx_coalesce, irqStatus, bdCount);
+    }
+}
+
+static int axisDmaCtrl_rxIrqBdHandler(struct axisDmaCtrl *inst)
+{
+    XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&inst->axiDma);
+    int bdCount;
+    XAxiDma_Bd *bdPtr;
+    XAxiDma_Bd *bdCurPtr;
+    int i;
+
+    /* the bds never come back from hardware in cyclic mode */
+    if (inst->params.rx_cyclic)
+        return axisDmaCtrl_rxCyclicWalk(inst);
+
+    /* Get finished BDs from hardware */
+    bdCount = XAxiDma_BdRingFromHw(rxRingPtr, XAXIDMA_ALL_BDS, &bdPtr);
+    if (bdCount == 0) {
+        return 0;
+    }
+    axisDmaCtrl_statsHw(&inst->stats.rx, rxRingPtr, 1);
+
+    AXISDMA_DEBUG_PRINT("rx %d bds\r\n",bdCount);
+
+    if (!inst->params.rx_deferred) {
+        axisDmaCtrl_rxDeliverBds(inst, bdCount, bdPtr);
+        return bdCount;
+    }
+
+    /*
+     * Deferred mode only queues the bds, they stay in the post state
+     * until axisDmaCtrl_rxPoll hands them back. The queue holds as many
+     * entries as there are bds so it can not overflow.
+     */
+    bdCurPtr = bdPtr;
+    for (i = 0; i < bdCount; i++) {
+        uint32_t tail = inst->rxqTail;
+
+        inst->rxq[tail & RXQ_MASK].addr = XAxiDma_BdGetBufAddr(bdCurPtr);
+        inst->rxq[tail & RXQ_MASK].len  = XAxiDma_BdGetActualLength(bdCurPtr,rxRingPtr->MaxTransferLen);
+        inst->rxq[tail & RXQ_MASK].sts  = XAxiDma_BdGetSts(bdCurPtr);
+        AXISDMA_TRACE(inst, AXISDMA_TRACE_COMPLETE, AXISDMA_TRACE_RX, bdCurPtr, inst->rxq[tail & RXQ_MASK].addr,
+            inst->rxq[tail & RXQ_MASK].len, inst->rxq[tail & RXQ_MASK].sts);
+        AXISDMA_DMB();
+        inst->rxqTail = tail + 1;
+
+        /* Find the next processed BD */
+        if (i != bdCount-1)
+            bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(rxRingPtr, bdCurPtr);
+    }
+
+    return bdCount;
+}
+
+/*
+ * Delivers bds just taken from the ring and hands them back to hardware,
+ * rx_refill_watermark at a time when set.
+ */
+static void axisDmaCtrl_rxDeliverBds(struct axisDmaCtrl *inst, int bdCount, XAxiDma_Bd * bdPtr)
+{
+    XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&inst->axiDma);
+    XAxiDma_Bd *bdCurPtr;
+    XAxiDma_Bd *doneHead;
+    int done = 0;
+    u32 bdSts;
+    int i;
+
+    bdCurPtr = bdPtr;
+    doneHead = bdPtr;
+    for (i = 0; i < bdCount; i++) {
+        uint32_t addr;
+        uint32_t pktLen;
+
+        bdSts  = XAxiDma_BdGetSts(bdCurPtr);
+        addr   = XAxiDma_BdGetBufAddr(bdCurPtr);
+        pktLen = XAxiDma_BdGetActualLength(bdCurPtr,rxRingPtr->MaxTransferLen);
+        AXISDMA_TRACE(inst, AXISDMA_TRACE_COMPLETE, AXISDMA_TRACE_RX, bdCurPtr, addr, pktLen, bdSts);
+
+        /*
+        * Check the flags set by the hardware for status
+        * If error happens the bd is not delivered, the DMA engine
+        * is halted after this BD.
+        */
+        if ((bdSts & XAXIDMA_BD_STS_ALL_ERR_MASK) ||
+            (!(bdSts & XAXIDMA_BD_STS_COMPLETE_MASK))) {
+            AXISDMA_ERROR_PRINT("XAxiDma_BdGetSts\r\n");
+            axisDmaCtrl_statsBdErr(&inst->stats.rx, bdSts);
+            AXISDMA_TRACE(inst, AXISDMA_TRACE_ERROR, AXISDMA_TRACE_RX, bdCurPtr, addr, pktLen, bdSts);
+            if (inst->params.rx_lend)
+                axisDmaCtrl_rxPoolPut(inst, addr);
+            else if (inst->params.rx_block_size)
+                axisDmaCtrl_rxBlockFrag(inst, 0, 1);
+        } else {
+            AXISDMA_DEBUG_PRINT("pkt %d, pktLen %u\r\n",i,(unsigned int)pktLen);
+            axisDmaCtrl_rxBdDeliver(inst, addr, pktLen, bdSts);
+        }
+
+        /* Find the next processed BD */
+        if (i != bdCount-1)
+            bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(rxRingPtr, bdCurPtr);
+
+        /* keep s2mm fed while the rest of the batch is delivered */
+        if (axisDmaCtrl_rxRefillDue(inst, ++done) && i != bdCount-1) {
+            axisDmaCtrl_rxRecycle(inst, done, doneHead);
+            doneHead = bdCurPtr;
+            done = 0;
+        }
+    }
+
+    if (done > 0)
+        axisDmaCtrl_rxRecycle(inst, done, doneHead);
+}
+
+/*
+ * True once enough consumed bds piled up to hand them back early. Zero copy
+ * packets point into the ring buffers, bds of an open one are held.
+ */
+static int axisDmaCtrl_rxRefillDue(struct axisDmaCtrl *inst, int done)
+{
+    if (inst->params.rx_refill_watermark == 0 || done < inst->params.rx_refill_watermark)
+        return 0;
+    return !axisDmaCtrl_rxPktHeld(inst);
+}
+
+/* an open zero copy packet points into the ring buffers of its bds */
+static int axisDmaCtrl_rxPktHeld(struct axisDmaCtrl *inst)
+{
+    return inst->rxPktCb != NULL && inst->rxPktOpen &&
+        inst->rxPktCopyBuf == NULL && !inst->params.rx_lend;
+}
+
+int axisDmaCtrl_rxPoll(struct axisDmaCtrl *inst, int budget)
+{
+    int bdCount = 0;
+
+    if (inst->intc == NULL)
+        return 0;
+    if (inst->params.rx_mode != AXISDMA_RX_MODE_IRQ)
+        bdCount = axisDmaCtrl_rxPollRing(inst, budget);
+    else if (inst->params.rx_deferred)
+        bdCount = axisDmaCtrl_rxPollQueue(inst, budget);
+
+    /* nothing came in since the last call, the stream may have stopped */
+    if (bdCount == 0 && inst->params.rx_block_size && inst->params.rx_block_timeout_us) {
+        XScuGic_Disable(inst->intc, inst->params.rxIrqId);
+        axisDmaCtrl_rxBlockTimeout(inst);
+        XScuGic_Enable(inst->intc, inst->params.rxIrqId);
+    }
+
+    return bdCount;
+}
+
+/*
+ * Runs the callbacks for bds the isr queued in deferred mode. A budget is
+ * rounded up to the next EOF so packets are taken whole, the bds of a
+ * zero copy packet still open at the end stay held for the next call.
+ */
+static int axisDmaCtrl_rxPollQueue(struct axisDmaCtrl *inst, int budget)
+{
+    XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&inst->axiDma);
+    uint32_t head = inst->rxqHead + inst->rxqHeld;
+    uint32_t avail;
+    int bdCount;
+    int done = inst->rxqHeld;
+    int i;
+
+    AXISDMA_DMB();
+    avail = inst->rxqTail - head;
+    bdCount = (budget > 0 && (uint32_t)budget < avail) ? budget : (int)avail;
+    if (bdCount == 0)
+        return 0;
+    while ((uint32_t)bdCount < avail &&
+        !(inst->rxq[(head + bdCount - 1) & RXQ_MASK].sts & XAXIDMA_BD_STS_RXEOF_MASK))
+        bdCount++;
+
+    for (i = 0; i < bdCount; i++) {
+        struct rxq_entry *e = &inst->rxq[(head + i) & RXQ_MASK];
+
+        if ((e->sts & XAXIDMA_BD_STS_ALL_ERR_MASK) ||
+            (!(e->sts & XAXIDMA_BD_STS_COMPLETE_MASK))) {
+            AXISDMA_ERROR_PRINT("XAxiDma_BdGetSts 0x%x\r\n",(unsigned int)e->sts);
+            axisDmaCtrl_statsBdErr(&inst->stats.rx, e->sts);
+            AXISDMA_TRACE(inst, AXISDMA_TRACE_ERROR, AXISDMA_TRACE_RX, 0, e->addr, e->len, e->sts);
+            if (inst->params.rx_lend) {
+                XScuGic_Disable(inst->intc, inst->params.rxIrqId);
+                axisDmaCtrl_rxPoolPut(inst, e->addr);
+                XScuGic_Enable(inst->intc, inst->params.rxIrqId);
+            } else if (inst->params.rx_block_size) {
+                axisDmaCtrl_rxBlockFrag(inst, 0, 1);
+            }
+        } else {
+            axisDmaCtrl_rxBdDeliver(inst, e->addr, e->len, e->sts);
+        }
+
+        /* entries leave the queue before their bds can complete again */
+        if (axisDmaCtrl_rxRefillDue(inst, ++done) ||
+            (i == bdCount-1 && !axisDmaCtrl_rxPktHeld(inst))) {
+            AXISDMA_DMB();
+            inst->rxqHead = head + i + 1;
+
+            /* the isr runs FromHw on the same ring, keep it out while the
+             * processed bds are freed and handed back */
+            XScuGic_Disable(inst->intc, inst->params.rxIrqId);
+            axisDmaCtrl_rxRecycle(inst, done, rxRingPtr->PostHead);
+            XScuGic_Enable(inst->intc, inst->params.rxIrqId);
+            done = 0;
+        }
+    }
+    inst->rxqHeld = done;
+
+    return bdCount;
+}
+
+/*
+ * Cyclic rx mode, follows the engine around the ring. Hardware sets the
+ * complete bit of a bd each time it fills it and never looks at it, so
+ * clearing it (the length stays) marks the fill as counted. At most one
+ * lap is walked per call so a line rate stream can not keep the caller.
+ */
+static int axisDmaCtrl_rxCyclicWalk(struct axisDmaCtrl *inst)
+{
+    XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&inst->axiDma);
+    XAxiDma_Bd *bdCurPtr = inst->rxCycBd;
+    int bdCount = 0;
+    u32 bdSts;
+
+    while (bdCount < (int)RX_BDS(rxRingPtr)) {
+        /* the raw word, XAxiDma_BdGetSts drops the length */
+        bdSts = XAxiDma_BdRead(bdCurPtr, XAXIDMA_BD_STS_OFFSET);
+        if (!(bdSts & XAXIDMA_BD_STS_COMPLETE_MASK))
+            break;
+        XAxiDma_BdWrite(bdCurPtr, XAXIDMA_BD_STS_OFFSET, bdSts & ~XAXIDMA_BD_STS_COMPLETE_MASK);
+        inst->stats.rx.bds++;
+        inst->stats.rx.bytes += bdSts & rxRingPtr->MaxTransferLen;
+        AXISDMA_TRACE(inst, AXISDMA_TRACE_COMPLETE, AXISDMA_TRACE_RX, bdCurPtr, XAxiDma_BdGetBufAddr(bdCurPtr),
+            bdSts & rxRingPtr->MaxTransferLen, bdSts);
+        if (bdSts & XAXIDMA_BD_STS_RXEOF_MASK)
+            inst->stats.rx.pkts++;
+        bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(rxRingPtr, bdCurPtr);
+        bdCount++;
+    }
+
+    inst->rxCycBd = bdCurPtr;
+    AXISDMA_DMB();
+    inst->rxCycProd += bdCount;
+
+    return bdCount;
+}
+
+uint32_t axisDmaCtrl_rxCyclicProducer(struct axisDmaCtrl *inst)
+{
+    if (!inst->params.rx_cyclic || inst->intc == NULL)
+        return 0;
+
+    /* the isr walks the same bds */
+    XScuGic_Disable(inst->intc, inst->params.rxIrqId);
+    axisDmaCtrl_rxCyclicWalk(inst);
+    XScuGic_Enable(inst->intc, inst->params.rxIrqId);
+
+    return inst->rxCycProd;
+}
+
+/*
+ * The bd of index prod is being filled and shares its slot with
+ * prod - AllCnt, so one lap minus one bd is readable.
+ */
+uint32_t axisDmaCtrl_rxCyclicOldest(struct axisDmaCtrl *inst)
+{
+    uint32_t prod = inst->rxCycProd;
+    uint32_t lap = RX_BDS(XAxiDma_GetRxRing(&inst->axiDma)) - 1;
+
+    return (prod > lap) ? prod - lap : 0;
+}
+
+int axisDmaCtrl_rxCyclicGet(struct axisDmaCtrl *inst, uint32_t idx, struct axisDmaCtrl_frag *frag)
+{
+    XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&inst->axiDma);
+    uint32_t ahead = inst->rxCycProd - idx;
+    XAxiDma_Bd *bdPtr;
+
+    if (!inst->params.rx_cyclic || frag == NULL)
+        return XST_FAILURE;
+    AXISDMA_DMB();
+    if ((int32_t)ahead <= 0)
+        return XST_FAILURE;
+    if (ahead >= RX_BDS(rxRingPtr))
+        return E_AXISDMA_OVERRUN;
+
+    bdPtr = (XAxiDma_Bd *)(rxRingPtr->FirstBdAddr + (idx % RX_BDS(rxRingPtr)) * BD_SEP(rxRingPtr));
+    frag->buf_addr = XAxiDma_BdGetBufAddr(bdPtr);
+    frag->buf_len  = XAxiDma_BdGetActualLength(bdPtr, rxRingPtr->MaxTransferLen);
+
+    /* lines pulled in during the previous lap are stale */
+    if (inst->params.cacheable_bufs)
+        Xil_DCacheInvalidateRange((INTPTR)frag->buf_addr, frag->buf_len);
+
+    return XST_SUCCESS;
+}
+
+/*
+ * Polling rx modes, takes completed bds straight from the ring. The isr
+ * never touches the ring in these modes so no masking is needed. In napi
+ * mode a dry ring hands control back to the rx irq: stale completion
+ * status is acked first so unmasking does not fire for bds already
+ * delivered, and a bd completing around the unmask keeps the ring polled.
+ */
+static int axisDmaCtrl_rxPollRing(struct axisDmaCtrl *inst, int budget)
+{
+    XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&inst->axiDma);
+    XAxiDma_Bd *bdPtr;
+    int bdCount;
+
+    if (!inst->rxPolling)
+        return 0;
 
-        /*
-         * Reset should never fail for transmit channel
-         */
-        XAxiDma_Reset(&axiDma);
+    bdCount = XAxiDma_BdRingFromHw(rxRingPtr,
+        budget > 0 ? (unsigned int)budget : XAXIDMA_ALL_BDS, &bdPtr);
+    /* only whole packets come back, the next one is taken alone when it
+     * is larger than the budget */
+    if (bdCount == 0 && budget > 0) {
+        int pktBds = axisDmaCtrl_rxPktBds(rxRingPtr);
 
-        /** @todo raise an error flag */
-        timeOut = RESET_TIMEOUT_COUNTER;
-        while (timeOut) {
-            if (XAxiDma_ResetIsDone(&axiDma)) {
-                break;
-            }
-            timeOut -= 1;
-        }
-        return;
+        if (pktBds > 0)
+            bdCount = XAxiDma_BdRingFromHw(rxRingPtr, pktBds, &bdPtr);
     }
 
-    /*
-     * If Transmit done interrupt is asserted, call TX call back function
-     * to handle the processed BDs and raise the according flag
-     */
-    if ((irqStatus & (XAXIDMA_IRQ_DELAY_MASK | XAXIDMA_IRQ_IOC_MASK))) {
-        axisDmaCtrl_txIrqBdHandler(txRingPtr);
+    if (bdCount > 0) {
+        axisDmaCtrl_statsHw(&inst->stats.rx, rxRingPtr, 1);
+        axisDmaCtrl_rxDeliverBds(inst, bdCount, bdPtr);
+        return bdCount;
     }
+
+    if (inst->params.rx_mode == AXISDMA_RX_MODE_NAPI) {
+        inst->rxPolling = 0;
+        XAxiDma_BdRingAckIrq(rxRingPtr, XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
+        XAxiDma_BdRingIntEnable(rxRingPtr, XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
+        if (rxRingPtr->HwCnt > 0 &&
+            (XAxiDma_BdGetSts(rxRingPtr->HwHead) & XAXIDMA_BD_STS_COMPLETE_MASK)) {
+            XAxiDma_BdRingIntDisable(rxRingPtr, XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
+            inst->rxPolling = 1;
+        }
+    }
+
+    return 0;
 }
 
-static void axisDmaCtrl_rxIrqBdHandler(XAxiDma_BdRing * rxRingPtr)
+/*
+ * Returns the bds of the oldest packet still with hardware, 0 while its last
+ * bd has not completed.
+ */
+static int axisDmaCtrl_rxPktBds(XAxiDma_BdRing * ringPtr)
 {
-    int bdCount;
-    XAxiDma_Bd *bdPtr;
-    XAxiDma_Bd *bdCurPtr;
+    XAxiDma_Bd *bdCurPtr = ringPtr->HwHead;
     u32 bdSts;
     int i;
+
+    for (i = 0; i < ringPtr->HwCnt; i++) {
+        bdSts = XAxiDma_BdGetSts(bdCurPtr);
+        if (!(bdSts & XAXIDMA_BD_STS_COMPLETE_MASK))
+            return 0;
+        if (bdSts & XAXIDMA_BD_STS_RXEOF_MASK)
+            return i + 1;
+        bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(ringPtr, bdCurPtr);
+    }
+    return 0;
+}
+
+/*
+ * Hands one completed BD to the user, either directly or through the packet
+ * reassembly.
+ */
+static void axisDmaCtrl_rxBdDeliver(struct axisDmaCtrl *inst, uint32_t addr, uint32_t len, u32 bdSts)
+{
+    AXISDMA_LAT_VAR(t);
+
+    /* drop any lines the cpu speculatively pulled in while the
+     * hardware owned the buffer */
+    if (inst->params.cacheable_bufs)
+        Xil_DCacheInvalidateRange((INTPTR)addr, len);
+
+    inst->stats.rx.bds++;
+    inst->stats.rx.bytes += len;
+    if (bdSts & XAXIDMA_BD_STS_RXEOF_MASK)
+        inst->stats.rx.pkts++;
+
+    /* the buffer is the user's until it goes back to the pool */
+    if (inst->params.rx_lend)
+        inst->rxLent[(addr - inst->params.rx_buffer_base) / BD_BUF_SIZE(inst)] = 1;
+
+    if (inst->params.rx_block_size)
+        axisDmaCtrl_rxBlockFrag(inst, len, 0);
+    else if (inst->rxPktCb != NULL)
+        axisDmaCtrl_rxPktFrag(inst, addr, len, bdSts);
+    else {
+        AXISDMA_TRACE(inst, AXISDMA_TRACE_CALLBACK, AXISDMA_TRACE_RX, 0, addr, len, bdSts);
+        AXISDMA_LAT_START(t);
+        inst->rxCb(inst->cbCtx, addr, len);
+        AXISDMA_LAT_END(inst, AXISDMA_LAT_RX_CB, t);
+    }
+}
+
+/*
+ * Return processed BDs to RX channel so we are ready to receive new
+ * packets:
+ *    - Free the processed BDs
+ *    - Allocate all free RX BDs (as many as the pool has buffers for when
+ *      lending, the rest waits for axisDmaCtrl_rxRelease)
+ *    - Pass the BDs to RX channel
+ */
+static void axisDmaCtrl_rxRecycle(struct axisDmaCtrl *inst, int bdCount, XAxiDma_Bd * bdPtr)
+{
+    XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&inst->axiDma);
     u32 freeBdCount;
+    XAxiDma_Bd *bdCurPtr;
+    u32 i;
     int rc;
+    AXISDMA_LAT_VAR(t);
 
-    /* Get finished BDs from hardware */
-    bdCount = XAxiDma_BdRingFromHw(rxRingPtr, XAXIDMA_ALL_BDS, &bdPtr);
-    if (bdCount == 0) {
+    AXISDMA_LAT_START(t);
+
+    if (bdCount > 0) {
+        AXISDMA_TRACE(inst, AXISDMA_TRACE_FREE, AXISDMA_TRACE_RX, bdPtr, 0, bdCount, 0);
+        rc = XAxiDma_BdRingFree(rxRingPtr, bdCount, bdPtr);
+        if (rc != XST_SUCCESS)
+            AXISDMA_ERROR_PRINT("XAxiDma_BdRingFree rc %d\r\n",rc);
+    }
+
+    freeBdCount = XAxiDma_BdRingGetFreeCnt(rxRingPtr);
+    if (inst->params.rx_lend && freeBdCount > (u32)inst->rxPoolCnt)
+        freeBdCount = inst->rxPoolCnt;
+    /* a chunk is reused once the block it belonged to a lap ago was handed over */
+    if (inst->params.rx_block_size &&
+            freeBdCount > inst->rxBlkStartSeq + inst->rxBlkChunks - inst->rxBlkArmSeq)
+        freeBdCount = inst->rxBlkStartSeq + inst->rxBlkChunks - inst->rxBlkArmSeq;
+    if (freeBdCount == 0) {
+        AXISDMA_LAT_END(inst, AXISDMA_LAT_RX_RECYCLE, t);
         return;
     }
 
-    AXISDMA_DEBUG_PRINT("rx %d bds\r\n",bdCount);
+    rc = XAxiDma_BdRingAlloc(rxRingPtr, freeBdCount, &bdPtr);
+    if (rc != XST_SUCCESS) {
+        AXISDMA_ERROR_PRINT("XAxiDma_BdRingAlloc failed %d - freeBdCount %u\r\n",rc,freeBdCount);
+    }
 
-    bdCurPtr = bdPtr;
-    for (i = 0; i < bdCount; i++) {
-        uint32_t addr;
-        uint32_t pktLen;
-        /*
-        * Check the flags set by the hardware for status
-        * If error happens, processing stops, because the DMA engine
-        * is halted after this BD.
-        */
-        bdSts = XAxiDma_BdGetSts(bdCurPtr);
-        if ((bdSts & XAXIDMA_BD_STS_ALL_ERR_MASK) ||
-            (!(bdSts & XAXIDMA_BD_STS_COMPLETE_MASK))) {
-            AXISDMA_ERROR_PRINT("XAxiDma_BdGetSts\r\n");
-            break;
+    /* lent buffers are gone, attach fresh ones from the pool */
+    if (inst->params.rx_lend) {
+        bdCurPtr = bdPtr;
+        for (i = 0; i < freeBdCount; i++) {
+            uint32_t addr = inst->rxPool[--inst->rxPoolCnt];
+
+            /* the borrower may have left dirty lines behind */
+            if (inst->params.cacheable_bufs)
+                Xil_DCacheInvalidateRange((INTPTR)addr, BD_BUF_SIZE(inst));
+            XAxiDma_BdSetBufAddr(bdCurPtr, addr);
+            XAxiDma_BdSetId(bdCurPtr, addr);
+            bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(rxRingPtr, bdCurPtr);
+        }
+    } else if (inst->params.rx_block_size) {
+        /* the ring and the region rarely divide, bds take the next chunk in line */
+        bdCurPtr = bdPtr;
+        for (i = 0; i < freeBdCount; i++) {
+            uint32_t addr = axisDmaCtrl_rxBlockAddr(inst, inst->rxBlkArmSeq++);
+
+            XAxiDma_BdSetBufAddr(bdCurPtr, addr);
+            XAxiDma_BdSetId(bdCurPtr, addr);
+            bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(rxRingPtr, bdCurPtr);
         }
+    }
 
-        /* get memory offset of current bd */
-        addr   = XAxiDma_BdGetBufAddr(bdCurPtr);
-        pktLen = XAxiDma_BdGetActualLength(bdCurPtr,rxRingPtr->MaxTransferLen);
+    rc = XAxiDma_BdRingToHw(rxRingPtr, freeBdCount, bdPtr);
+    if (rc != XST_SUCCESS) {
+        AXISDMA_ERROR_PRINT("XAxiDma_BdRingToHw failed %d\r\n",rc);
+    }
+    axisDmaCtrl_statsHw(&inst->stats.rx, rxRingPtr, 0);
+    AXISDMA_TRACE(inst, AXISDMA_TRACE_TOHW, AXISDMA_TRACE_RX, bdPtr, 0, freeBdCount, 0);
+    AXISDMA_LAT_END(inst, AXISDMA_LAT_RX_RECYCLE, t);
+}
+
+/* block index of addr in the tx pool, -1 when addr is not inside the pool */
+static int axisDmaCtrl_txPoolIdx(struct axisDmaCtrl *inst, uint32_t addr)
+{
+    if (inst->txPoolSize == 0 || addr < inst->params.tx_buffer_base ||
+        addr - inst->params.tx_buffer_base >= inst->txPoolSize * inst->params.tx_block_size)
+        return -1;
+    return (addr - inst->params.tx_buffer_base) / inst->params.tx_block_size;
+}
 
-        AXISDMA_DEBUG_PRINT("pkt %d, pktLen %lu\r\n",i,pktLen);
+/* position of a tx bd in the ring, the index into txCookie */
+static int axisDmaCtrl_txBdIdx(XAxiDma_BdRing * ringPtr, XAxiDma_Bd * bdPtr)
+{
+    return ((UINTPTR)bdPtr - ringPtr->FirstBdAddr) / BD_SEP(ringPtr);
+}
+
+/*
+ * An error halts the engine and FromHw holds back a packet that failed before
+ * its last bd, so a failed bd can only be the last one handed back. Returns
+ * the bds in front of the packet that failed there, the whole packet stays in
+ * the post state for axisDmaCtrl_txReclaim to account from its sof.
+ */
+static int axisDmaCtrl_txReapWhole(XAxiDma_BdRing * ringPtr, XAxiDma_Bd * bdPtr, int bdCount)
+{
+    u32 idx = (axisDmaCtrl_txBdIdx(ringPtr, bdPtr) + bdCount - 1) % TX_BDS(ringPtr);
+    XAxiDma_Bd *bdCurPtr = (XAxiDma_Bd *)(ringPtr->FirstBdAddr + idx * BD_SEP(ringPtr));
+    u32 bdSts = XAxiDma_BdGetSts(bdCurPtr);
 
-        _rx_cb(addr, pktLen);
+    if (!(bdSts & XAXIDMA_BD_STS_ALL_ERR_MASK) && (bdSts & XAXIDMA_BD_STS_COMPLETE_MASK))
+        return bdCount;
 
-        /* Find the next processed BD */
-        if (i != bdCount-1)
-            bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(rxRingPtr, bdCurPtr);
+    while (bdCount > 0) {
+        bdCount--;
+        if (XAxiDma_BdGetCtrl(bdCurPtr) & XAXIDMA_BD_CTRL_TXSOF_MASK)
+            break;
+        idx = idx ? idx - 1 : TX_BDS(ringPtr) - 1;
+        bdCurPtr = (XAxiDma_Bd *)(ringPtr->FirstBdAddr + idx * BD_SEP(ringPtr));
     }
+    return bdCount;
+}
 
+static void axisDmaCtrl_rxPoolPut(struct axisDmaCtrl *inst, uint32_t addr)
+{
+    if (inst->rxPoolCnt >= inst->rxPoolSize) {
+        AXISDMA_ERROR_PRINT("rx pool overflow at 0x%x\r\n",(unsigned int)addr);
+        return;
+    }
+    inst->rxLent[(addr - inst->params.rx_buffer_base) / BD_BUF_SIZE(inst)] = 0;
+    inst->rxPool[inst->rxPoolCnt++] = addr;
+}
 
-    rc = XAxiDma_BdRingFree(rxRingPtr, bdCount, bdPtr);
-    if (rc != XST_SUCCESS)
-        AXISDMA_ERROR_PRINT("XAxiDma_BdRingFree rc %d\r\n",rc);
+/*
+ * Adds one BD to the packet being reassembled and hands the packet to the
+ * packet callback on EOF. A SOF while a packet is open means the previous
+ * one lost its EOF (error/reset), it is dropped.
+ */
+static void axisDmaCtrl_rxPktFrag(struct axisDmaCtrl *inst, uint32_t addr, uint32_t len, u32 bdSts)
+{
+    int i;
+    AXISDMA_LAT_VAR(t);
+
+    if ((bdSts & XAXIDMA_BD_STS_RXSOF_MASK) || !inst->rxPktOpen) {
+        /* nobody will see the dropped packet, take its loans back */
+        if (inst->rxPktOpen && inst->params.rx_lend && inst->rxPktCopyBuf == NULL)
+            for (i = 0; i < inst->rxPkt.nfrags; i++)
+                axisDmaCtrl_rxPoolPut(inst, inst->rxPkt.frags[i].buf_addr);
+        inst->rxPkt.pkt_len = 0;
+        inst->rxPkt.nfrags  = 0;
+        inst->rxPkt.flags   = (bdSts & XAXIDMA_BD_STS_RXSOF_MASK) ? 0 : AXISDMA_PKT_NO_SOF;
+        inst->rxPktOpen     = 1;
+    }
 
-    /* Return processed BDs to RX channel so we are ready to receive new
-     * packets:
-     *    - Allocate all free RX BDs
-     *    - Pass the BDs to RX channel
-     */
-    freeBdCount = XAxiDma_BdRingGetFreeCnt(rxRingPtr);
-    rc = XAxiDma_BdRingAlloc(rxRingPtr, freeBdCount, &bdPtr);
-    if (rc != XST_SUCCESS) {
-        AXISDMA_ERROR_PRINT("XAxiDma_BdRingAlloc failed %d - freeBdCount %u\r\n",rc,freeBdCount);
+    if (inst->rxPktCopyBuf != NULL) {
+        uint32_t room = inst->rxPktCopyBufSize - inst->rxPkt.pkt_len;
+
+        if (len > room) {
+            len = room;
+            inst->rxPkt.flags |= AXISDMA_PKT_TRUNCATED;
+        }
+        memcpy(inst->rxPktCopyBuf + inst->rxPkt.pkt_len, (void *)(UINTPTR)addr, len);
+        inst->rxPkt.frags[0].buf_addr = (uint32_t)(UINTPTR)inst->rxPktCopyBuf;
+        inst->rxPkt.frags[0].buf_len  = inst->rxPkt.pkt_len + len;
+        inst->rxPkt.nfrags = 1;
+        inst->rxPkt.pkt_len += len;
+        /* the data lives in the copy, the ring buffer is not lent out */
+        if (inst->params.rx_lend)
+            axisDmaCtrl_rxPoolPut(inst, addr);
+    } else if (inst->rxPkt.nfrags < AXISDMA_RX_PKT_MAX_FRAGS) {
+        inst->rxPkt.frags[inst->rxPkt.nfrags].buf_addr = addr;
+        inst->rxPkt.frags[inst->rxPkt.nfrags].buf_len  = len;
+        inst->rxPkt.nfrags++;
+        inst->rxPkt.pkt_len += len;
+    } else {
+        inst->rxPkt.flags |= AXISDMA_PKT_TRUNCATED;
+        if (inst->params.rx_lend)
+            axisDmaCtrl_rxPoolPut(inst, addr);
     }
 
-    rc = XAxiDma_BdRingToHw(rxRingPtr, freeBdCount, bdPtr);
-    if (rc != XST_SUCCESS) {
-        AXISDMA_ERROR_PRINT("XAxiDma_BdRingToHw failed %d\r\n",rc);
+    if (bdSts & XAXIDMA_BD_STS_RXEOF_MASK) {
+        inst->rxPktOpen = 0;
+        AXISDMA_TRACE(inst, AXISDMA_TRACE_CALLBACK, AXISDMA_TRACE_RX, 0,
+            inst->rxPkt.frags[0].buf_addr, inst->rxPkt.pkt_len, inst->rxPkt.flags);
+        AXISDMA_LAT_START(t);
+        inst->rxPktCb(inst->cbCtx, &inst->rxPkt);
+        AXISDMA_LAT_END(inst, AXISDMA_LAT_RX_CB, t);
     }
 }
 
 static void axisDmaCtrl_rxIntrHandler(void *callback)
 {
-    XAxiDma_BdRing *rxRingPtr = (XAxiDma_BdRing *) callback;
+    struct axisDmaCtrl *inst = (struct axisDmaCtrl *) callback;
+    XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&inst->axiDma);
     u32 irqStatus;
-    int timeOut;
 
     /* Read pending interrupts */
     irqStatus = XAxiDma_BdRingGetIrq(rxRingPtr);
@@ -539,30 +2407,17 @@ static void axisDmaCtrl_rxIntrHandler(void *callback)
     }
 
     /*
-     * If error interrupt is asserted, raise error flag, reset the
-     * hardware to recover from the error, and return with no further
-     * processing.
+     * If error interrupt is asserted, raise the error flag and return with
+     * no further processing. The channel is halted, axisDmaCtrl_recover
+     * resets the hardware and rebuilds the rings from thread context.
      */
     if ((irqStatus & XAXIDMA_IRQ_ERROR_MASK)) {
 
         XAxiDma_BdRingDumpRegs(rxRingPtr);
         AXISDMA_ERROR_PRINT("\r\n");
-
-        /* Reset could fail and hang
-         * NEED a way to handle this or do not call it??
-         */
-        XAxiDma_Reset(&axiDma);
-
-        timeOut = RESET_TIMEOUT_COUNTER;
-
-        while (timeOut) {
-            if (XAxiDma_ResetIsDone(&axiDma)) {
-                break;
-            }
-
-            timeOut -= 1;
-        }
-
+        inst->stats.rx.err_irqs++;
+        inst->errPending |= AXISDMA_ERR_RX;
+        AXISDMA_TRACE(inst, AXISDMA_TRACE_ERROR, AXISDMA_TRACE_RX, 0, 0, 0, irqStatus);
         return;
     }
 
@@ -570,13 +2425,32 @@ static void axisDmaCtrl_rxIntrHandler(void *callback)
      * If completion interrupt is asserted, call RX call back function
      * to handle the processed BDs and then raise the according flag.
      */
+    /* napi mode hands the ring over to axisDmaCtrl_rxPoll until it runs dry */
+    if (inst->params.rx_mode != AXISDMA_RX_MODE_IRQ) {
+        if (irqStatus & (XAXIDMA_IRQ_DELAY_MASK | XAXIDMA_IRQ_IOC_MASK)) {
+            inst->stats.rx.irqs++;
+            XAxiDma_BdRingIntDisable(rxRingPtr, XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
+            inst->rxPolling = 1;
+        }
+        return;
+    }
+
     if ((irqStatus & (XAXIDMA_IRQ_DELAY_MASK | XAXIDMA_IRQ_IOC_MASK))) {
-        axisDmaCtrl_rxIrqBdHandler(rxRingPtr);
+        int bdCount = axisDmaCtrl_rxIrqBdHandler(inst);
+
+        inst->stats.rx.irqs++;
+        if ((u32)bdCount > inst->stats.rx.irq_bds_max)
+            inst->stats.rx.irq_bds_max = bdCount;
+
+        if (inst->params.rx_coalesce.adaptive)
+            axisDmaCtrl_coalesceAdapt(rxRingPtr, &inst->rxCoal,
+                &inst->params.rx_coalesce, irqStatus, bdCount);
     }
 }
 
-static int axisDmaCtrl_setupIntrSystem(XScuGic * intcInstancePtr)
+static int axisDmaCtrl_setupIntrSystem(struct axisDmaCtrl *inst)
 {
+    XScuGic *intcInstancePtr = inst->intc;
     int rc;
 
 #if 0
@@ -586,7 +2460,7 @@ static int axisDmaCtrl_setupIntrSystem(XScuGic * intcInstancePtr)
      * Initialize the interrupt controller driver so that it is ready to
      * use.
      */
-    intcConfig = XScuGic_LookupConfig(params.dmaDevId);
+    intcConfig = XScuGic_LookupConfig(inst->params.dmaDevId);
     if (NULL == intcConfig) {
         return XST_FAILURE;
     }
@@ -598,28 +2472,26 @@ static int axisDmaCtrl_setupIntrSystem(XScuGic * intcInstancePtr)
     }
 #endif
 
-    if (params.txEn) {
-        XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&axiDma);
-        XScuGic_SetPriorityTriggerType(intcInstancePtr, params.txIrqId, params.txIrqPriority, 0x3);
-        rc = XScuGic_Connect(intcInstancePtr, params.txIrqId,
-                    (Xil_InterruptHandler)axisDmaCtrl_txIntrHandler,
-                    txRingPtr);
+    if (TX_EN(inst)) {
+        XScuGic_SetPriorityTriggerType(intcInstancePtr, inst->params.txIrqId, inst->params.txIrqPriority, 0x3);
+        rc = XScuGic_Connect(intcInstancePtr, inst->params.txIrqId,
+                    (Xil_InterruptHandler)AXISDMA_TX_ISR,
+                    inst);
         if (rc != XST_SUCCESS) {
             return rc;
         }
-        XScuGic_Enable(intcInstancePtr, params.txIrqId);
+        XScuGic_Enable(intcInstancePtr, inst->params.txIrqId);
     }
 
-    if (params.rxEn) {
-        XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&axiDma);
-        XScuGic_SetPriorityTriggerType(intcInstancePtr, params.rxIrqId, params.rxIrqPriority, 0x3);
-        rc = XScuGic_Connect(intcInstancePtr, params.rxIrqId,
-                    (Xil_InterruptHandler)axisDmaCtrl_rxIntrHandler,
-                    rxRingPtr);
+    if (RX_EN(inst)) {
+        XScuGic_SetPriorityTriggerType(intcInstancePtr, inst->params.rxIrqId, inst->params.rxIrqPriority, 0x3);
+        rc = XScuGic_Connect(intcInstancePtr, inst->params.rxIrqId,
+                    (Xil_InterruptHandler)AXISDMA_RX_ISR,
+                    inst);
         if (rc != XST_SUCCESS) {
             return rc;
         }
-        XScuGic_Enable(intcInstancePtr, params.rxIrqId);
+        XScuGic_Enable(intcInstancePtr, inst->params.rxIrqId);
     }
 
 
@@ -635,17 +2507,20 @@ static int axisDmaCtrl_setupIntrSystem(XScuGic * intcInstancePtr)
     return XST_SUCCESS;
 }
 
-static void axisDmaCtrl_disableIntrSystem(XScuGic * intcInstancePtr)
+static void axisDmaCtrl_disableIntrSystem(struct axisDmaCtrl *inst)
 {
-    if (params.txEn)
-        XScuGic_Disconnect(intcInstancePtr, params.txIrqId);
+    XScuGic *intcInstancePtr = inst->intc;
 
-    if (params.rxEn)
-        XScuGic_Disconnect(intcInstancePtr, params.rxIrqId);
+    if (TX_EN(inst))
+        XScuGic_Disconnect(intcInstancePtr, inst->params.txIrqId);
+
+    if (RX_EN(inst))
+        XScuGic_Disconnect(intcInstancePtr, inst->params.rxIrqId);
 }
 
-static int axisDmaCtrl_rxSetup(XAxiDma * axiDmaInstPtr)
+static int axisDmaCtrl_rxSetup(struct axisDmaCtrl *inst)
 {
+    XAxiDma *axiDmaInstPtr = &inst->axiDma;
     XAxiDma_BdRing *rxRingPtr;
     int rc;
     XAxiDma_Bd bdTemplate;
@@ -663,15 +2538,27 @@ static int axisDmaCtrl_rxSetup(XAxiDma * axiDmaInstPtr)
 
     /* Setup Rx BD space */
     bdCount = XAxiDma_BdRingCntCalc(XAXIDMA_BD_MINIMUM_ALIGNMENT,
-                params.rx_bd_space_high - params.rx_bd_space_base + 1);
+                inst->params.rx_bd_space_high - inst->params.rx_bd_space_base + 1);
+
+    /* every bd can sit in the deferred queue at once */
+    if (inst->params.rx_deferred && bdCount > AXISDMA_RXQ_DEPTH) {
+        AXISDMA_ERROR_PRINT("%d rx bds exceed AXISDMA_RXQ_DEPTH\r\n", bdCount);
+        return XST_FAILURE;
+    }
 
-    rc = XAxiDma_BdRingCreate(rxRingPtr, params.rx_bd_space_base,
-                    params.rx_bd_space_base,
+    rc = XAxiDma_BdRingCreate(rxRingPtr, inst->params.rx_bd_space_base,
+                    inst->params.rx_bd_space_base,
                     XAXIDMA_BD_MINIMUM_ALIGNMENT, bdCount);
     if (rc != XST_SUCCESS) {
         AXISDMA_ERROR_PRINT("Rx bd create failed with %d\r\n", rc);
         return XST_FAILURE;
     }
+#ifdef AXISDMA_STATIC_RX_BDS
+    if (rxRingPtr->AllCnt != AXISDMA_STATIC_RX_BDS || rxRingPtr->Separation != BD_SEP(rxRingPtr)) {
+        AXISDMA_ERROR_PRINT("%d rx bds, built for %d\r\n", bdCount, AXISDMA_STATIC_RX_BDS);
+        return XST_FAILURE;
+    }
+#endif
     AXISDMA_DEBUG_PRINT("%d rx bds created\r\n",bdCount);
 
     /*
@@ -687,6 +2574,41 @@ static int axisDmaCtrl_rxSetup(XAxiDma * axiDmaInstPtr)
     /* Attach buffers to RxBD ring so we are ready to receive packets */
     freeBdCount = XAxiDma_BdRingGetFreeCnt(rxRingPtr);
 
+    /*
+     * When lending every buffer of the region goes into the pool and the
+     * ring takes what it needs from there. The stack is filled top down so
+     * the first bds still get the buffers in address order. A recovery
+     * keeps the pool, buffers may still be lent out.
+     */
+    if (inst->params.rx_lend && inst->rxPoolSize == 0) {
+        inst->rxPoolSize = (inst->params.rx_buffer_high - inst->params.rx_buffer_base + 1) / inst->params.bd_buf_size;
+        if (inst->rxPoolSize > AXISDMA_RX_POOL_MAX)
+            inst->rxPoolSize = AXISDMA_RX_POOL_MAX;
+        if (inst->rxPoolSize == 0) {
+            AXISDMA_ERROR_PRINT("Rx buffer region holds no buffer\r\n");
+            return XST_FAILURE;
+        }
+        for (inst->rxPoolCnt = 0; inst->rxPoolCnt < inst->rxPoolSize; inst->rxPoolCnt++)
+            inst->rxPool[inst->rxPoolCnt] = inst->params.rx_buffer_base +
+                (inst->rxPoolSize - 1 - inst->rxPoolCnt) * inst->params.bd_buf_size;
+    }
+    if (inst->params.rx_lend && freeBdCount > inst->rxPoolCnt)
+        freeBdCount = inst->rxPoolCnt;
+
+    /* block mode arms the region in address order, ring bds beyond it wait */
+    if (inst->params.rx_block_size) {
+        inst->rxBlkChunks = (inst->params.rx_buffer_high - inst->params.rx_buffer_base + 1) /
+            inst->params.rx_block_size * (inst->params.rx_block_size / inst->params.bd_buf_size);
+        if ((u32)freeBdCount > inst->rxBlkChunks)
+            freeBdCount = inst->rxBlkChunks;
+        inst->rxBlkArmSeq = freeBdCount;
+        inst->rxBlkDoneSeq = 0;
+        inst->rxBlkStartSeq = 0;
+        inst->rxBlkBytes = 0;
+        inst->rxBlkFlags = 0;
+        inst->rxBlkShort = 0;
+    }
+
     rc = XAxiDma_BdRingAlloc(rxRingPtr, freeBdCount, &bdPtr);
     if (rc != XST_SUCCESS) {
         AXISDMA_ERROR_PRINT("Rx bd alloc failed with %d\r\n", rc);
@@ -694,24 +2616,30 @@ static int axisDmaCtrl_rxSetup(XAxiDma * axiDmaInstPtr)
     }
 
     bdCurPtr = bdPtr;
-    rxBufferPtr = params.rx_buffer_base;
+    rxBufferPtr = inst->params.rx_buffer_base;
 
     for (i = 0; i < freeBdCount; i++) {
+        if (inst->params.rx_lend)
+            rxBufferPtr = inst->rxPool[--inst->rxPoolCnt];
+
+        /* no dirty lines may be evicted on top of received data later on */
+        if (inst->params.cacheable_bufs)
+            Xil_DCacheInvalidateRange((INTPTR)rxBufferPtr, BD_BUF_SIZE(inst));
 
         rc = XAxiDma_BdSetBufAddr(bdCurPtr, rxBufferPtr);
         if (rc != XST_SUCCESS) {
             AXISDMA_ERROR_PRINT("Rx set buffer addr %x on BD %x failed %d\r\n",
             (unsigned int)rxBufferPtr,
-            (UINTPTR)bdCurPtr, rc);
+            (unsigned int)(UINTPTR)bdCurPtr, rc);
 
             return XST_FAILURE;
         }
 
-        rc = XAxiDma_BdSetLength(bdCurPtr, params.bd_buf_size,
+        rc = XAxiDma_BdSetLength(bdCurPtr, BD_BUF_SIZE(inst),
                     rxRingPtr->MaxTransferLen);
         if (rc != XST_SUCCESS) {
             AXISDMA_ERROR_PRINT("Rx set length %d on BD %x failed %d\r\n",
-                params.bd_buf_size, (UINTPTR)bdCurPtr, rc);
+                (int)BD_BUF_SIZE(inst), (unsigned int)(UINTPTR)bdCurPtr, rc);
 
             return XST_FAILURE;
         }
@@ -723,22 +2651,31 @@ static int axisDmaCtrl_rxSetup(XAxiDma * axiDmaInstPtr)
 
         XAxiDma_BdSetId(bdCurPtr, rxBufferPtr);
 
-        rxBufferPtr += params.bd_buf_size;
+        rxBufferPtr += BD_BUF_SIZE(inst);
         bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(rxRingPtr, bdCurPtr);
     }
 
-    rc = XAxiDma_BdRingSetCoalesce(rxRingPtr, params.coalesce_count,
-            DELAY_TIMER_COUNT);
+    rc = axisDmaCtrl_coalesceSetup(rxRingPtr, &inst->rxCoal,
+            &inst->params.rx_coalesce, inst->params.coalesce_count);
     if (rc != XST_SUCCESS) {
         AXISDMA_ERROR_PRINT("Rx set coalesce failed with %d\r\n", rc);
         return XST_FAILURE;
     }
 
+    /* the tail pointer written by ToHw/Start must be the cyclic one */
+    if (inst->params.rx_cyclic) {
+        XAxiDma_BdRingEnableCyclicDMA(rxRingPtr);
+        inst->rxCycBd = bdPtr;
+        inst->rxCycProd = 0;
+    }
+
     rc = XAxiDma_BdRingToHw(rxRingPtr, freeBdCount, bdPtr);
     if (rc != XST_SUCCESS) {
         AXISDMA_ERROR_PRINT("Rx ToHw failed with %d\r\n", rc);
         return XST_FAILURE;
     }
+    axisDmaCtrl_statsHw(&inst->stats.rx, rxRingPtr, 0);
+    AXISDMA_TRACE(inst, AXISDMA_TRACE_TOHW, AXISDMA_TRACE_RX, bdPtr, 0, freeBdCount, 0);
 
     rc = XAxiDma_BdRingCheck(rxRingPtr);
     if (rc != XST_SUCCESS) {
@@ -747,11 +2684,17 @@ static int axisDmaCtrl_rxSetup(XAxiDma * axiDmaInstPtr)
     }
 
     /* Enable all RX interrupts */
-    XAxiDma_BdRingIntEnable(rxRingPtr, XAXIDMA_IRQ_ALL_MASK);
+    /* busy polling only wants to hear about errors */
+    if (inst->params.rx_mode == AXISDMA_RX_MODE_BUSYPOLL) {
+        XAxiDma_BdRingIntEnable(rxRingPtr, XAXIDMA_IRQ_ERROR_MASK);
+        inst->rxPolling = 1;
+    } else {
+        XAxiDma_BdRingIntEnable(rxRingPtr, XAXIDMA_IRQ_ALL_MASK);
+    }
 
-    /* Enable Cyclic DMA mode */
-//     XAxiDma_BdRingEnableCyclicDMA(rxRingPtr);
-//     XAxiDma_SelectCyclicMode(axiDmaInstPtr, XAXIDMA_DEVICE_TO_DMA, 1);
+    /* Enable Cyclic DMA mode, has to be set before the channel runs */
+    if (inst->params.rx_cyclic)
+        XAxiDma_SelectCyclicMode(axiDmaInstPtr, XAXIDMA_DEVICE_TO_DMA, 1);
 
     /* Start RX DMA channel */
     rc = XAxiDma_BdRingStart(rxRingPtr);
@@ -763,8 +2706,9 @@ static int axisDmaCtrl_rxSetup(XAxiDma * axiDmaInstPtr)
     return XST_SUCCESS;
 }
 
-static int axisDmaCtrl_txSetup(XAxiDma * axiDmaInstPtr)
+static int axisDmaCtrl_txSetup(struct axisDmaCtrl *inst)
 {
+    XAxiDma *axiDmaInstPtr = &inst->axiDma;
     XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(axiDmaInstPtr);
     XAxiDma_Bd bdTemplate;
     int rc;
@@ -775,17 +2719,40 @@ static int axisDmaCtrl_txSetup(XAxiDma * axiDmaInstPtr)
 
     /* Setup TxBD space  */
     bdCount = XAxiDma_BdRingCntCalc(XAXIDMA_BD_MINIMUM_ALIGNMENT,
-            (u32)params.tx_bd_space_high - (u32)params.tx_bd_space_base + 1);
+            (u32)inst->params.tx_bd_space_high - (u32)inst->params.tx_bd_space_base + 1);
     AXISDMA_DEBUG_PRINT("%d tx bds created\r\n",(int)bdCount);
-
-    rc = XAxiDma_BdRingCreate(txRingPtr, params.tx_bd_space_base,
-                     params.tx_bd_space_base,
+    if (bdCount > AXISDMA_TX_BD_MAX) {
+        AXISDMA_ERROR_PRINT("%d tx bds, at most %d\r\n",(int)bdCount,AXISDMA_TX_BD_MAX);
+        return XST_FAILURE;
+    }
+    if (inst->params.tx_queue_depth > AXISDMA_TXQ_MAX || inst->params.tx_sched > AXISDMA_TX_SCHED_WEIGHTED ||
+        inst->params.tx_queue_high > inst->params.tx_queue_depth ||
+        (inst->params.tx_queue_depth && inst->params.tx_queue_low >=
+            (inst->params.tx_queue_high ? inst->params.tx_queue_high : inst->params.tx_queue_depth))) {
+        AXISDMA_ERROR_PRINT("bad tx queue depth %u, high %u, low %u, sched %u\r\n",inst->params.tx_queue_depth,
+            inst->params.tx_queue_high,inst->params.tx_queue_low,inst->params.tx_sched);
+        return XST_FAILURE;
+    }
+    /* the ring starts out empty, nothing counts against the bulk cap */
+    inst->txBulkBds = 0;
+    /* priority 1 has the first weighted turn, with its full credit */
+    inst->txqCur = 1;
+    inst->txqCredit = inst->params.tx_weight[1] ? inst->params.tx_weight[1] : 1;
+
+    rc = XAxiDma_BdRingCreate(txRingPtr, inst->params.tx_bd_space_base,
+                     inst->params.tx_bd_space_base,
                      XAXIDMA_BD_MINIMUM_ALIGNMENT, bdCount);
     if (rc != XST_SUCCESS) {
 
         AXISDMA_ERROR_PRINT("Failed create BD ring\r\n");
         return XST_FAILURE;
     }
+#ifdef AXISDMA_STATIC_TX_BDS
+    if (txRingPtr->AllCnt != AXISDMA_STATIC_TX_BDS || txRingPtr->Separation != BD_SEP(txRingPtr)) {
+        AXISDMA_ERROR_PRINT("%d tx bds, built for %d\r\n", (int)bdCount, AXISDMA_STATIC_TX_BDS);
+        return XST_FAILURE;
+    }
+#endif
 
     /*
      * Like the RxBD space, we create a template and set all BDs to be the
@@ -805,11 +2772,11 @@ static int axisDmaCtrl_txSetup(XAxiDma * axiDmaInstPtr)
      * If you would like to have multiple interrupts to happen, change
      * the params.coalesce_count to be a smaller value
      */
-    rc = XAxiDma_BdRingSetCoalesce(txRingPtr, params.coalesce_count,
-            DELAY_TIMER_COUNT);
+    rc = axisDmaCtrl_coalesceSetup(txRingPtr, &inst->txCoal,
+            &inst->params.tx_coalesce, inst->params.coalesce_count);
     if (rc != XST_SUCCESS) {
         AXISDMA_ERROR_PRINT("Failed set coalescing"
-        " %d/%d\r\n",params.coalesce_count, DELAY_TIMER_COUNT);
+        " %d/%d\r\n",inst->params.coalesce_count, DELAY_TIMER_COUNT);
         return XST_FAILURE;
     }
 
@@ -819,6 +2786,17 @@ static int axisDmaCtrl_txSetup(XAxiDma * axiDmaInstPtr)
         return XST_FAILURE;
     }
 
+    /* Carve the tx data buffer into pool blocks, a recovery keeps the pool
+     * as blocks may be out with the application */
+    if (inst->params.tx_block_size && inst->txPoolSize == 0) {
+        inst->txPoolSize = (inst->params.tx_buffer_high - inst->params.tx_buffer_base + 1) / inst->params.tx_block_size;
+        if (inst->txPoolSize > AXISDMA_TX_POOL_MAX)
+            inst->txPoolSize = AXISDMA_TX_POOL_MAX;
+        for (inst->txPoolCnt = 0; inst->txPoolCnt < inst->txPoolSize; inst->txPoolCnt++)
+            inst->txPool[inst->txPoolCnt] = inst->params.tx_buffer_base +
+                (inst->txPoolSize - 1 - inst->txPoolCnt) * inst->params.tx_block_size;
+    }
+
     /* Enable all TX interrupts */
     XAxiDma_BdRingIntEnable(txRingPtr, XAXIDMA_IRQ_ALL_MASK);
 
@@ -832,3 +2810,418 @@ static int axisDmaCtrl_txSetup(XAxiDma * axiDmaInstPtr)
 
     return XST_SUCCESS;
 }
+
+/*
+ * Programs the initial threshold and delay timer of a ring. A static
+ * policy uses staticCount, an adaptive one starts at its min_count.
+ */
+static int axisDmaCtrl_coalesceSetup(XAxiDma_BdRing * ringPtr, struct coalesceState *st,
+    const struct axisDmaCtrl_coalesce *pol, u32 staticCount)
+{
+    u32 delay = pol->delay ? pol->delay : DELAY_TIMER_COUNT;
+    int rc;
+
+    st->count = pol->adaptive ? pol->min_count : staticCount;
+    XTime_GetTime(&st->lastIrq);
+
+    rc = XAxiDma_BdRingSetCoalesce(ringPtr, st->count, delay);
+    if (rc != XST_SUCCESS)
+        AXISDMA_ERROR_PRINT("set coalesce %u/%u failed\r\n",
+            (unsigned int)st->count, (unsigned int)delay);
+    return rc;
+}
+
+/*
+ * Retunes the threshold of a ring after a completion irq. An irq raised by
+ * the delay timer alone means the batch did not fill up in time, the
+ * threshold halves to bring latency down. A full batch arriving within
+ * irq_interval_us of the previous irq means a burst, the threshold doubles
+ * to cut the irq rate. Runs in the ring's isr, the only writer of st.
+ */
+static void axisDmaCtrl_coalesceAdapt(XAxiDma_BdRing * ringPtr, struct coalesceState *st,
+    const struct axisDmaCtrl_coalesce *pol, u32 irqStatus, int bdCount)
+{
+    u32 intervalUs = pol->irq_interval_us ? pol->irq_interval_us : AXISDMA_COALESCE_IRQ_US;
+    u32 count = st->count;
+    XTime now;
+
+    XTime_GetTime(&now);
+    if (!(irqStatus & XAXIDMA_IRQ_IOC_MASK)) {
+        count >>= 1;
+        if (count < pol->min_count)
+            count = pol->min_count;
+    } else if (bdCount >= (int)count &&
+            now - st->lastIrq < (XTime)intervalUs * COUNTS_PER_SECOND / 1000000) {
+        count <<= 1;
+        if (count > pol->max_count)
+            count = pol->max_count;
+    }
+    st->lastIrq = now;
+
+    if (count != st->count &&
+            XAxiDma_BdRingSetCoalesce(ringPtr, count, XAXIDMA_NO_CHANGE) == XST_SUCCESS)
+        st->count = count;
+}
+
+/* address of a chunk, the sequence wraps over the whole blocks of the region */
+static uint32_t axisDmaCtrl_rxBlockAddr(struct axisDmaCtrl *inst, uint32_t seq)
+{
+    return inst->params.rx_buffer_base + (seq % inst->rxBlkChunks) * BD_BUF_SIZE(inst);
+}
+
+/*
+ * Block rx mode, accounts the next chunk to the open block and hands the
+ * block over when the chunk was its last. A short chunk (EOF) followed by
+ * more data leaves a hole in the block, as does a failed one.
+ */
+static void axisDmaCtrl_rxBlockFrag(struct axisDmaCtrl *inst, uint32_t len, int err)
+{
+    uint32_t perBlk = inst->params.rx_block_size / BD_BUF_SIZE(inst);
+
+    if (err || inst->rxBlkShort)
+        inst->rxBlkFlags |= AXISDMA_BLK_GAP;
+    inst->rxBlkShort = len < BD_BUF_SIZE(inst);
+    inst->rxBlkBytes += len;
+    inst->rxBlkDoneSeq++;
+    if (inst->params.rx_block_timeout_us)
+        XTime_GetTime(&inst->rxBlkLast);
+
+    if (inst->rxBlkDoneSeq % perBlk == 0)
+        axisDmaCtrl_rxBlockFlush(inst, 0);
+}
+
+/*
+ * Hands the completed chunks of the open block to the block callback. The
+ * chunks become free for the next lap, the caller hands them to hardware.
+ */
+static void axisDmaCtrl_rxBlockFlush(struct axisDmaCtrl *inst, uint16_t flags)
+{
+    uint32_t addr = axisDmaCtrl_rxBlockAddr(inst, inst->rxBlkStartSeq);
+    uint32_t len = inst->rxBlkBytes;
+    AXISDMA_LAT_VAR(t);
+
+    flags |= inst->rxBlkFlags;
+    inst->rxBlkStartSeq = inst->rxBlkDoneSeq;
+    inst->rxBlkBytes = 0;
+    inst->rxBlkFlags = 0;
+    inst->rxBlkShort = 0;
+
+    if (inst->rxBlkCb != NULL) {
+        AXISDMA_TRACE(inst, AXISDMA_TRACE_CALLBACK, AXISDMA_TRACE_RX, 0, addr, len, flags);
+        AXISDMA_LAT_START(t);
+        inst->rxBlkCb(inst->cbCtx, addr, len, flags);
+        AXISDMA_LAT_END(inst, AXISDMA_LAT_RX_CB, t);
+    }
+}
+
+/*
+ * Hands over a partly filled block once no chunk completed for
+ * rx_block_timeout_us. The rest of the block keeps filling and follows as
+ * its own hand over. Runs with the rx irq masked.
+ */
+static void axisDmaCtrl_rxBlockTimeout(struct axisDmaCtrl *inst)
+{
+    XTime now;
+
+    if (inst->rxBlkDoneSeq == inst->rxBlkStartSeq)
+        return;
+    XTime_GetTime(&now);
+    if (now - inst->rxBlkLast < (XTime)inst->params.rx_block_timeout_us * COUNTS_PER_SECOND / 1000000)
+        return;
+
+    axisDmaCtrl_rxBlockFlush(inst, AXISDMA_BLK_PARTIAL);
+    axisDmaCtrl_rxRecycle(inst, 0, NULL);
+}
+
+/*
+ * One pass over the rx ring the way the configured mode processes it,
+ * used by axisDmaCtrl_recover while the ring drains. Returns the bds taken.
+ */
+static int axisDmaCtrl_rxDrain(struct axisDmaCtrl *inst)
+{
+    int bdCount;
+
+    XScuGic_Disable(inst->intc, inst->params.rxIrqId);
+    if (inst->params.rx_mode == AXISDMA_RX_MODE_IRQ) {
+        bdCount = axisDmaCtrl_rxIrqBdHandler(inst);
+    } else {
+        inst->rxPolling = 1;
+        bdCount = axisDmaCtrl_rxPollRing(inst, 0);
+    }
+    XScuGic_Enable(inst->intc, inst->params.rxIrqId);
+
+    if (inst->params.rx_deferred)
+        axisDmaCtrl_rxPollQueue(inst, 0);
+
+    return bdCount;
+}
+
+/*
+ * Goes through the tx bds hardware still held when the engine was reset.
+ * Completed bds are accounted like the isr does, a packet with any bd left
+ * undone is lost and goes to the tx lost callback. Pool blocks come back
+ * either way. Packets are never split over a reap so the walk starts on a
+ * SOF bd.
+ */
+static void axisDmaCtrl_txReclaim(struct axisDmaCtrl *inst, struct axisDmaCtrl_recovery *info)
+{
+    XAxiDma_BdRing *txRingPtr = XAxiDma_GetTxRing(&inst->axiDma);
+    XAxiDma_Bd *bdCurPtr = txRingPtr->PostHead;
+    int bdCount = txRingPtr->PostCnt + txRingPtr->HwCnt;
+    uint32_t pktAddr = 0;
+    uint32_t pktLen = 0;
+    uint32_t pktBds = 0;
+    u32 pktSts = 0;
+    int pktLost = 0;
+    int i;
+
+    for (i = 0; i < bdCount; i++) {
+        u32 bdSts = XAxiDma_BdGetSts(bdCurPtr);
+        u32 bdCtrl = XAxiDma_BdGetCtrl(bdCurPtr);
+        u32 len = XAxiDma_BdGetLength(bdCurPtr, txRingPtr->MaxTransferLen);
+
+        if (bdCtrl & XAXIDMA_BD_CTRL_TXSOF_MASK) {
+            pktAddr = XAxiDma_BdGetBufAddr(bdCurPtr);
+            pktLen = 0;
+            pktBds = 0;
+            pktSts = 0;
+            pktLost = 0;
+        }
+        pktLen += len;
+        pktBds++;
+
+        if ((bdSts & XAXIDMA_BD_STS_COMPLETE_MASK) && !(bdSts & XAXIDMA_BD_STS_ALL_ERR_MASK)) {
+            inst->stats.tx.bds++;
+            inst->stats.tx.bytes += len;
+            if (bdCtrl & XAXIDMA_BD_CTRL_TXEOF_MASK)
+                inst->stats.tx.pkts++;
+            AXISDMA_TRACE(inst, AXISDMA_TRACE_COMPLETE, AXISDMA_TRACE_TX, bdCurPtr,
+                XAxiDma_BdGetBufAddr(bdCurPtr), len, bdSts);
+            inst->txPktBytes += len;
+            if (inst->txPktCb == NULL)
+                inst->txCb(inst->cbCtx);
+        } else {
+            if (bdSts & XAXIDMA_BD_STS_ALL_ERR_MASK) {
+                axisDmaCtrl_statsBdErr(&inst->stats.tx, bdSts);
+                AXISDMA_TRACE(inst, AXISDMA_TRACE_ERROR, AXISDMA_TRACE_TX, bdCurPtr,
+                    XAxiDma_BdGetBufAddr(bdCurPtr), 0, bdSts);
+            }
+            if (!pktLost)
+                pktSts = bdSts;
+            pktLost = 1;
+        }
+
+        if (bdCtrl & XAXIDMA_BD_CTRL_TXEOF_MASK) {
+            int eofIdx = axisDmaCtrl_txBdIdx(txRingPtr, bdCurPtr);
+
+            inst->txBulkBds -= inst->txBulk[eofIdx];
+            if (pktLost) {
+                info->tx_lost_pkts++;
+                info->tx_lost_bds += pktBds;
+                if (inst->txLostCb != NULL)
+                    inst->txLostCb(inst->cbCtx, pktAddr, pktLen);
+            }
+            if (inst->txPoolSize) {
+                int idx = axisDmaCtrl_txPoolIdx(inst, XAxiDma_BdGetId(bdCurPtr));
+
+                if (idx >= 0)
+                    inst->txPool[inst->txPoolCnt++] = inst->params.tx_buffer_base + idx * inst->params.tx_block_size;
+            }
+            if (inst->txPktCb != NULL)
+                inst->txPktCb(inst->cbCtx, inst->txCookie[eofIdx],
+                    inst->txPktBytes, pktLost ? pktSts : bdSts);
+            inst->txPktBytes = 0;
+        }
+
+        bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(txRingPtr, bdCurPtr);
+    }
+}
+
+/*
+ * Counterpart of axisDmaCtrl_txReclaim for the rx ring. What the drain did
+ * not deliver is dropped, lent buffers attached to the bds go back to the
+ * pool and the reassembly state starts over.
+ */
+static void axisDmaCtrl_rxReclaim(struct axisDmaCtrl *inst, struct axisDmaCtrl_recovery *info)
+{
+    XAxiDma_BdRing *rxRingPtr = XAxiDma_GetRxRing(&inst->axiDma);
+    XAxiDma_Bd *bdCurPtr = rxRingPtr->PostHead;
+    int bdCount = rxRingPtr->PostCnt + rxRingPtr->HwCnt;
+    int i;
+
+    /* cyclic bds are never taken back, their complete bits mean nothing */
+    if (inst->params.rx_cyclic)
+        bdCount = 0;
+
+    for (i = 0; i < bdCount; i++) {
+        if (XAxiDma_BdGetSts(bdCurPtr) & XAXIDMA_BD_STS_COMPLETE_MASK)
+            info->rx_dropped_bds++;
+        if (inst->params.rx_lend)
+            axisDmaCtrl_rxPoolPut(inst, XAxiDma_BdGetBufAddr(bdCurPtr));
+        bdCurPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(rxRingPtr, bdCurPtr);
+    }
+
+    /* queued entries belong to the post state bds counted above */
+    inst->rxqHead = inst->rxqTail;
+    inst->rxqHeld = 0;
+    inst->rxPolling = 0;
+
+    if (inst->rxPktOpen && inst->params.rx_lend && inst->rxPktCopyBuf == NULL)
+        for (i = 0; i < inst->rxPkt.nfrags; i++)
+            axisDmaCtrl_rxPoolPut(inst, inst->rxPkt.frags[i].buf_addr);
+    inst->rxPktOpen = 0;
+
+    /* the stream restarts at the first chunk of the region */
+    if (inst->params.rx_block_size && inst->rxBlkDoneSeq != inst->rxBlkStartSeq)
+        axisDmaCtrl_rxBlockFlush(inst, AXISDMA_BLK_PARTIAL);
+}
+
+/*
+ * Watchdog check of one ring, runs with its irq masked. The ring waits on
+ * hardware while tx bds are out, while the oldest rx bd sits completed or
+ * while the channel is halted. Any move of the hw head is progress.
+ */
+static int axisDmaCtrl_stallCheck(struct axisDmaCtrl *inst, XAxiDma_BdRing * ringPtr,
+    struct stallState *st, XTime now, int rx)
+{
+    struct axisDmaCtrl_ringStats *stats = rx ? &inst->stats.rx : &inst->stats.tx;
+    u32 sr = XAxiDma_BdRingGetSr(ringPtr);
+    int waiting;
+
+    if (sr & XAXIDMA_HALTED_MASK)
+        waiting = 1;
+    else if (ringPtr->HwCnt == 0)
+        waiting = 0;
+    else if (rx)
+        waiting = (XAxiDma_BdGetSts(ringPtr->HwHead) & XAXIDMA_BD_STS_COMPLETE_MASK) ? 1 : 0;
+    else
+        waiting = 1;
+
+    if (!waiting || ringPtr->HwHead != st->head) {
+        st->head = ringPtr->HwHead;
+        st->since = now;
+        return 0;
+    }
+    if (now - st->since < (XTime)inst->params.stall_timeout_us * COUNTS_PER_SECOND / 1000000)
+        return 0;
+
+    /* report again one timeout later if nothing changes */
+    st->since = now;
+    stats->stalls++;
+    AXISDMA_ERROR_PRINT("%s stalled, %d bds out, sr 0x%x\r\n", rx ? "rx" : "tx",
+        ringPtr->HwCnt, (unsigned int)sr);
+    AXISDMA_TRACE(inst, AXISDMA_TRACE_STALL, rx ? AXISDMA_TRACE_RX : AXISDMA_TRACE_TX,
+        ringPtr->HwHead, 0, ringPtr->HwCnt, sr);
+    return 1;
+}
+
+static void axisDmaCtrl_statsReset(struct axisDmaCtrl *inst)
+{
+    memset(&inst->stats, 0, sizeof(inst->stats));
+    inst->stats.tx.hw_low = 0xFFFFFFFF;
+    inst->stats.rx.hw_low = 0xFFFFFFFF;
+}
+
+/*
+ * Samples the bds the hardware holds, right after a hand over for the high
+ * watermark and right after a reap for the low one.
+ */
+static void axisDmaCtrl_statsHw(struct axisDmaCtrl_ringStats *st, XAxiDma_BdRing * ringPtr, int reaped)
+{
+    u32 hwCnt = ringPtr->HwCnt;
+
+    if (reaped) {
+        if (hwCnt < st->hw_low)
+            st->hw_low = hwCnt;
+    } else if (hwCnt > st->hw_high) {
+        st->hw_high = hwCnt;
+    }
+}
+
+static void axisDmaCtrl_statsBdErr(struct axisDmaCtrl_ringStats *st, u32 bdSts)
+{
+    if (bdSts & XAXIDMA_BD_STS_INT_ERR_MASK)
+        st->err_internal++;
+    if (bdSts & XAXIDMA_BD_STS_SLV_ERR_MASK)
+        st->err_slave++;
+    if (bdSts & XAXIDMA_BD_STS_DEC_ERR_MASK)
+        st->err_decode++;
+}
+
+/*
+ * Records one trace event. The slot is claimed with an atomic add so isrs
+ * nesting over thread context can not collide. seq is cleared while the
+ * slot is filled and written last, a dump taken meanwhile shows it out of
+ * sequence instead of as a plausible looking event.
+ */
+static void axisDmaCtrl_traceRec(struct axisDmaCtrl *inst, u8 type, u8 chan,
+    u32 bd, u32 buf, u32 len, u32 sts)
+{
+    uint32_t idx = __sync_fetch_and_add(&inst->traceHead, 1);
+    struct axisDmaCtrl_traceEvt *e = &inst->trace[idx & TRACE_MASK];
+    XTime now;
+
+    e->seq = 0;
+    AXISDMA_DMB();
+    XTime_GetTime(&now);
+    e->ts   = now;
+    e->bd   = bd;
+    e->buf  = buf;
+    e->len  = len;
+    e->sts  = sts;
+    e->type = type;
+    e->chan = chan;
+    e->rsvd = 0;
+    AXISDMA_DMB();
+    e->seq  = idx + 1;
+}
+
+#ifdef AXISDMA_ENABLE_LATENCY
+/* isr entry points registered with AXISDMA_ENABLE_LATENCY, time the whole handler */
+static void axisDmaCtrl_txIntrTimed(void *callback)
+{
+    struct axisDmaCtrl *inst = (struct axisDmaCtrl *) callback;
+    XTime t;
+
+    XTime_GetTime(&t);
+    axisDmaCtrl_txIntrHandler(callback);
+    axisDmaCtrl_latRecord(&inst->lat.stage[AXISDMA_LAT_TX_ISR], t);
+}
+
+static void axisDmaCtrl_rxIntrTimed(void *callback)
+{
+    struct axisDmaCtrl *inst = (struct axisDmaCtrl *) callback;
+    XTime t;
+
+    XTime_GetTime(&t);
+    axisDmaCtrl_rxIntrHandler(callback);
+    axisDmaCtrl_latRecord(&inst->lat.stage[AXISDMA_LAT_RX_ISR], t);
+}
+
+static void axisDmaCtrl_latReset(struct axisDmaCtrl *inst)
+{
+    int i;
+
+    memset(&inst->lat, 0, sizeof(inst->lat));
+    for (i = 0; i < AXISDMA_LAT_STAGES; i++)
+        inst->lat.stage[i].min = 0xFFFFFFFF;
+}
+
+/* adds the time since start to a stage, the histogram bin is floor(log2) */
+static void axisDmaCtrl_latRecord(struct axisDmaCtrl_latStage *st, XTime start)
+{
+    XTime now;
+    u32 d;
+
+    XTime_GetTime(&now);
+    d = (now - start > 0xFFFFFFFF) ? 0xFFFFFFFF : (u32)(now - start);
+
+    st->count++;
+    st->total += d;
+    if (d < st->min)
+        st->min = d;
+    if (d > st->max)
+        st->max = d;
+    st->hist[d ? 31 - __builtin_clz(d) : 0]++;
+}
+#endif
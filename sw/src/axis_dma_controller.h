@@ -11,23 +11,310 @@
 
 #include "xaxidma.h"
 #include "xscugic.h"
+#include "axis_dma_trace.h"
 
 //#define AXISDMA_ENABLE_DEBUG_PRINTS /**< Define to enable debug (and error) printing in API */
 //#define AXISDMA_ENABLE_ERROR_PRINTS /**< Define to enable error printing ONLY in API */
+//#define AXISDMA_ENABLE_LATENCY /**< Define to timestamp the isrs, callbacks and rx recycling, see axisDmaCtrl_getLatency */
 
+/*
+ * Optional compile time geometry, e.g. -DAXISDMA_STATIC_BD_BUF_SIZE=2048.
+ * Each one replaces the matching runtime value in the hot paths, so power
+ * of 2 sizes turn divisions into shifts and masks and a disabled channel
+ * drops out. axisDmaCtrl_init rejects params that disagree with them.
+ */
+//#define AXISDMA_STATIC_BD_BUF_SIZE 2048 /**< Define to fix params->bd_buf_size */
+//#define AXISDMA_STATIC_TX_BDS 64 /**< Define to fix the number of bds in the tx bd space */
+//#define AXISDMA_STATIC_RX_BDS 64 /**< Define to fix the number of bds in the rx bd space */
+//#define AXISDMA_STATIC_TXEN 1 /**< Define to fix params->txEn, 0 drops the tx setup and isr */
+//#define AXISDMA_STATIC_RXEN 1 /**< Define to fix params->rxEn, 0 drops the rx setup and isr */
+
+#define E_AXISDMA_FAILED -1 /**< returned by axisDmaCtrl_sendPacketBatch for bad arguments or a rejected bd, nothing was queued */
 #define E_AXISDMA_NOBDS -2 /**< returned when not enough bds can be allocated from axisDmaCtrl_sendPackets */
+#define E_AXISDMA_OVERRUN -3 /**< returned by axisDmaCtrl_rxCyclicGet when the hardware already refilled the slot */
+
+#ifndef AXISDMA_MAX_INSTANCES
+#define AXISDMA_MAX_INSTANCES XPAR_XAXIDMA_NUM_INSTANCES /**< number of dma cores the api can drive at once */
+#endif
+
+#ifndef AXISDMA_RX_PKT_MAX_FRAGS
+#define AXISDMA_RX_PKT_MAX_FRAGS 64 /**< max number of bds a packet handed to the packet rx callback can span */
+#endif
+
+#ifndef AXISDMA_CACHE_LINE_SIZE
+#define AXISDMA_CACHE_LINE_SIZE 32 /**< L1/L2 line size, rx buffers must be aligned to it when cacheable_bufs is set */
+#endif
+
+#ifndef AXISDMA_RXQ_DEPTH
+#define AXISDMA_RXQ_DEPTH 1024 /**< entries in the deferred rx completion queue, power of 2 and at least the number of rx bds */
+#endif
+
+#ifndef AXISDMA_RX_POOL_MAX
+#define AXISDMA_RX_POOL_MAX 4096 /**< max number of rx buffers tracked by the lending pool */
+#endif
+
+#ifndef AXISDMA_TX_POOL_MAX
+#define AXISDMA_TX_POOL_MAX 1024 /**< max number of blocks in the tx buffer pool */
+#endif
+
+#ifndef AXISDMA_TX_BD_MAX
+#define AXISDMA_TX_BD_MAX 1024 /**< max number of tx bds, size of the per bd table holding the packet cookies */
+#endif
+
+#ifndef AXISDMA_TXQ_MAX
+#define AXISDMA_TXQ_MAX 256 /**< max depth of the tx software queue (params->tx_queue_depth), power of 2 */
+#endif
+
+#ifndef AXISDMA_TXQ_PRIOS
+#define AXISDMA_TXQ_PRIOS 4 /**< priority levels of the tx queue, 0 is the highest and 1 and up carry bulk data */
+#endif
+
+#ifndef AXISDMA_TRACE_DEPTH
+#define AXISDMA_TRACE_DEPTH 1024 /**< events kept by the trace ring of an instance, power of 2 */
+#endif
+
+#ifndef AXISDMA_RECOVER_DRAIN_US
+#define AXISDMA_RECOVER_DRAIN_US 100 /**< rx idle time after which axisDmaCtrl_recover considers the rx ring drained */
+#endif
+
+#ifndef AXISDMA_RECOVER_TIMEOUT_US
+#define AXISDMA_RECOVER_TIMEOUT_US 10000 /**< longest axisDmaCtrl_recover keeps draining the rx ring before the reset */
+#endif
+
+#ifndef AXISDMA_COALESCE_IRQ_US
+#define AXISDMA_COALESCE_IRQ_US 50 /**< default irq_interval_us of an adaptive coalescing policy */
+#endif
+
+#define AXISDMA_RX_MODE_IRQ      0 /**< rx bds are processed in the rx isr (or queued for axisDmaCtrl_rxPoll with rx_deferred) */
+#define AXISDMA_RX_MODE_NAPI     1 /**< the first rx irq masks the channel irq, axisDmaCtrl_rxPoll drains the ring and unmasks it once dry */
+#define AXISDMA_RX_MODE_BUSYPOLL 2 /**< no rx completion irqs, axisDmaCtrl_rxPoll is called continuously from a dedicated core */
+
+#define AXISDMA_PKT_TRUNCATED 0x1 /**< packet did not fit in the fragment list or copy buffer, data is incomplete */
+#define AXISDMA_PKT_NO_SOF    0x2 /**< first fragment was not marked start of frame by the hardware */
+
+#define AXISDMA_BLK_PARTIAL 0x1 /**< block handed over by rx_block_timeout_us before it filled up */
+#define AXISDMA_BLK_GAP     0x2 /**< a bd inside the block ended short (EOF) or failed, the data is not contiguous */
+
+#define AXISDMA_TX_SCHED_STRICT   0 /**< a queued packet goes out only once every higher priority queue is empty */
+#define AXISDMA_TX_SCHED_WEIGHTED 1 /**< priority 0 stays strict, the bulk priorities take turns of tx_weight[] packets */
+
+#define AXISDMA_ERR_TX 0x1 /**< mm2s channel in the masks of axisDmaCtrl_errorPending and axisDmaCtrl_watchdog */
+#define AXISDMA_ERR_RX 0x2 /**< s2mm channel in the masks of axisDmaCtrl_errorPending and axisDmaCtrl_watchdog */
+
+/**
+ * Controller instance, one per dma core. Returned by axisDmaCtrl_init and
+ * passed to every other call.
+ */
+struct axisDmaCtrl;
 
 /**
  * RX Callback Type
+ * @param ctx      user context given to axisDmaCtrl_init
  * @param buf_addr provides memory offset of returned buffer
  * @param buf_len  provides length of returned buffer in bytes
  */
-typedef void (*dma_rx_cb_t)(uint32_t buf_addr, uint32_t ggkbuf_len);
+typedef void (*dma_rx_cb_t)(void *ctx, uint32_t buf_addr, uint32_t buf_len);
 
 /**
  * TX Callback Type
+ * @param ctx      user context given to axisDmaCtrl_init
+ */
+typedef void (*dma_tx_cb_t)(void *ctx);
+
+/**
+ * Packet TX Callback Type, runs once per packet when its EOF bd is taken
+ * back from hardware
+ * @param ctx    user context given to axisDmaCtrl_init
+ * @param cookie cookie the packet was submitted with
+ * @param bytes  number of bytes the hardware transferred
+ * @param sts    bd status word of the EOF bd, or of the first bd that
+ *               failed. the packet went out when XAXIDMA_BD_STS_COMPLETE_MASK
+ *               is set and none of XAXIDMA_BD_STS_ALL_ERR_MASK. 0 for a
+ *               packet dropped from the tx queue because its bds were
+ *               rejected
+ */
+typedef void (*dma_tx_pkt_cb_t)(void *ctx, void *cookie, uint32_t bytes, uint32_t sts);
+
+/**
+ * One BD worth of a received packet
+ */
+struct axisDmaCtrl_frag {
+	uint32_t buf_addr; /**< memory offset of the fragment */
+	uint32_t buf_len;  /**< length of the fragment in bytes */
+};
+
+/**
+ * Packet handed to the packet RX callback. Fragments are in stream order,
+ * in copy mode there is a single fragment pointing at the copy buffer.
+ */
+struct axisDmaCtrl_pkt {
+	uint32_t pkt_len; /**< total packet length in bytes */
+	uint16_t nfrags;  /**< number of valid entries in frags */
+	uint16_t flags;   /**< AXISDMA_PKT_* flags */
+	struct axisDmaCtrl_frag frags[AXISDMA_RX_PKT_MAX_FRAGS];
+};
+
+/**
+ * Packet RX Callback Type
+ * @param ctx user context given to axisDmaCtrl_init
+ * @param pkt packet reassembled from the SOF/EOF status of its BDs, only
+ *            valid for the duration of the callback
+ */
+typedef void (*dma_rx_pkt_cb_t)(void *ctx, const struct axisDmaCtrl_pkt *pkt);
+
+/**
+ * Block RX Callback Type
+ * @param ctx      user context given to axisDmaCtrl_init
+ * @param buf_addr start of the block (or of the rest of a block after a
+ *                 partial hand over), the data is contiguous from here
+ * @param buf_len  number of bytes received into the block
+ * @param flags    AXISDMA_BLK_* flags
+ */
+typedef void (*dma_rx_block_cb_t)(void *ctx, uint32_t buf_addr, uint32_t buf_len, uint16_t flags);
+
+/**
+ * TX Lost Callback Type, runs from axisDmaCtrl_recover once per packet that
+ * did not make it out before the engine was reset
+ * @param ctx      user context given to axisDmaCtrl_init
+ * @param buf_addr address of the first bd of the packet
+ * @param buf_len  packet length in bytes
  */
-typedef void (*dma_tx_cb_t)(void);
+typedef void (*dma_tx_lost_cb_t)(void *ctx, uint32_t buf_addr, uint32_t buf_len);
+
+/**
+ * TX Flow Callback Type, backpressure of the tx software queue. Runs with
+ * the tx irq masked, from the submit call that fills the queue up to
+ * tx_queue_high and from the tx isr once it drained to tx_queue_low.
+ * @param ctx   user context given to axisDmaCtrl_init
+ * @param stop  1 when the producer should hold off, 0 when it may resume
+ */
+typedef void (*dma_tx_flow_cb_t)(void *ctx, int stop);
+
+/**
+ * Stall Callback Type, runs from axisDmaCtrl_watchdog once per stalled
+ * channel, before any recovery
+ * @param ctx   user context given to axisDmaCtrl_init
+ * @param chan  AXISDMA_ERR_TX or AXISDMA_ERR_RX
+ * @param sr    channel status register when the stall was detected
+ */
+typedef void (*dma_stall_cb_t)(void *ctx, int chan, uint32_t sr);
+
+/**
+ * One packet of a batch handed to axisDmaCtrl_sendPacketBatch
+ */
+struct axisDmaCtrl_txPkt {
+	uint8_t *buf;   /**< packet data */
+	size_t len;     /**< packet length in bytes */
+	void *cookie;   /**< handed to the packet tx callback, NULL passes buf */
+};
+
+/**
+ * One segment of a packet handed to axisDmaCtrl_sendPacketIov
+ */
+struct axisDmaCtrl_iovec {
+	uint8_t *buf; /**< segment data */
+	size_t len;   /**< segment length in bytes */
+};
+
+/**
+ * Bd layout of a fixed size tx packet, worked out once by
+ * axisDmaCtrl_txPrepare and reused by every axisDmaCtrl_sendPrepared call.
+ * Only valid for the instance it was prepared on, the fields are read only.
+ */
+struct axisDmaCtrl_txPrep {
+	uint32_t len;        /**< packet length in bytes */
+	uint32_t nbds;       /**< bds per packet */
+	uint32_t bd_len;     /**< bytes of every bd but the last, the buffer address step */
+	uint32_t align;      /**< buffer address bits that have to be clear, 0 with DRE */
+	uint32_t ctrl_first; /**< control/length word of the first of several bds */
+	uint32_t ctrl_mid;   /**< control/length word of the bds in between */
+	uint32_t ctrl_last;  /**< control/length word of the last (or only) bd */
+};
+
+/**
+ * Interrupt coalescing policy of one ring. In adaptive mode the threshold
+ * starts at min_count, halves when an irq was raised by the delay timer
+ * alone (light load) and doubles when a full batch completes less than
+ * irq_interval_us after the previous irq (burst).
+ */
+struct axisDmaCtrl_coalesce {
+	uint8_t adaptive;  /**< 1 to retune the threshold at runtime, 0 keeps coalesce_count */
+	uint8_t min_count; /**< lowest threshold, used at light load */
+	uint8_t max_count; /**< highest threshold, used under bursts */
+	uint8_t delay;     /**< delay timer flushing a partial batch, 0 uses the default */
+	uint32_t irq_interval_us; /**< irqs closer together than this raise the threshold, 0 uses AXISDMA_COALESCE_IRQ_US */
+};
+
+/**
+ * Runtime counters of one channel, always on. Average bds per irq is
+ * bds / irqs, a low hw_low on rx means the ring ran close to empty.
+ */
+struct axisDmaCtrl_ringStats {
+	uint64_t bytes;        /**< bytes moved by completed bds */
+	uint32_t pkts;         /**< completed packets (EOF bds) */
+	uint32_t bds;          /**< completed bds */
+	uint32_t irqs;         /**< completion irqs (ioc or delay timer) */
+	uint32_t irq_bds_max;  /**< most bds handled by a single irq */
+	uint32_t nobds;        /**< tx submissions turned away for lack of free bds */
+	uint32_t dropped;      /**< queued tx packets dropped because their bds were rejected */
+	uint32_t err_internal; /**< bds completed with a dma internal error */
+	uint32_t err_slave;    /**< bds completed with a slave error */
+	uint32_t err_decode;   /**< bds completed with a decode error */
+	uint32_t err_irqs;     /**< error irqs */
+	uint32_t resets;       /**< engine resets */
+	uint32_t stalls;       /**< stalls detected by axisDmaCtrl_watchdog */
+	uint32_t hw_high;      /**< most bds owned by the hardware after a hand over */
+	uint32_t hw_low;       /**< fewest bds owned by the hardware after a reap, 0xFFFFFFFF until sampled */
+};
+
+/**
+ * Counters of both channels as returned by axisDmaCtrl_getStats
+ */
+struct axisDmaCtrl_stats {
+	struct axisDmaCtrl_ringStats tx; /**< mm2s channel */
+	struct axisDmaCtrl_ringStats rx; /**< s2mm channel */
+};
+
+/**
+ * Outcome of an axisDmaCtrl_recover call
+ */
+struct axisDmaCtrl_recovery {
+	uint32_t tx_lost_pkts;   /**< tx packets with a bd left undone, each one went to the tx lost callback */
+	uint32_t tx_lost_bds;    /**< bds of those packets */
+	uint32_t rx_drained_bds; /**< rx bds delivered while the rx ring drained ahead of the reset */
+	uint32_t rx_dropped_bds; /**< rx bds that completed but were not delivered when the engine was reset */
+	uint32_t time_us;        /**< time from the call until both channels were running again */
+};
+
+#ifdef AXISDMA_ENABLE_LATENCY
+#define AXISDMA_LAT_TX_ISR     0 /**< whole tx isr */
+#define AXISDMA_LAT_RX_ISR     1 /**< whole rx isr */
+#define AXISDMA_LAT_TX_CB      2 /**< tx callback */
+#define AXISDMA_LAT_RX_CB      3 /**< rx callback (bd, packet or block) */
+#define AXISDMA_LAT_RX_RECYCLE 4 /**< handing consumed rx bds back to hardware */
+#define AXISDMA_LAT_STAGES     5
+
+#define AXISDMA_LAT_HIST_BINS 32 /**< log2 histogram bins, enough for any 32 bit duration */
+
+/**
+ * Durations of one instrumented stage in XTime counts (COUNTS_PER_SECOND),
+ * average is total / count.
+ */
+struct axisDmaCtrl_latStage {
+	uint32_t count; /**< samples taken */
+	uint64_t total; /**< sum of all samples */
+	uint32_t min;   /**< shortest sample, 0xFFFFFFFF until sampled */
+	uint32_t max;   /**< longest sample */
+	uint32_t hist[AXISDMA_LAT_HIST_BINS]; /**< hist[i] counts samples in [2^i, 2^(i+1)), hist[0] includes 0 */
+};
+
+/**
+ * Every stage as returned by axisDmaCtrl_getLatency, indexed by AXISDMA_LAT_*
+ */
+struct axisDmaCtrl_latency {
+	struct axisDmaCtrl_latStage stage[AXISDMA_LAT_STAGES];
+};
+#endif
 
 /**
  * @brief      Structure used to pass all configuration parameters 
@@ -44,6 +331,12 @@ struct axisDmaCtrl_params{
 	size_t rx_buffer_base;   /**< base address for rx data buffer */
 	size_t rx_buffer_high;   /**< high address for rx data buffer */
 	size_t bd_buf_size;      /**< number of bytes in a bd buffer */
+	size_t tx_block_size;    /**< size of the blocks axisDmaCtrl_txBufGet hands out of the tx data buffer,
+	                              0 leaves the region to the application. when set the region stays
+	                              noncacheable even with cacheable_bufs */
+	size_t rx_block_size;    /**< size of the blocks the rx data buffer is cut into for the block rx callback,
+	                              a multiple of bd_buf_size and the region must hold at least two of them.
+	                              s2mm fills the blocks back to back, 0 delivers per bd or packet */
 	uint8_t dmaDevId; /**< ID for the dma Device from xparameters */
 	/* xscugic parameters */
 	uint8_t txEn; /**< 1 to enable DMA TX */
@@ -53,61 +346,398 @@ struct axisDmaCtrl_params{
 	uint8_t coalesce_count;	 /**< number of bds that must be ready for an irq to fire */
 	uint8_t rxIrqPriority; /**< priority level for the rx dma irq */
 	uint8_t rxIrqId; /**< Interrupt ID for the rx dma from xparameters */
+	/* cache parameters */
+	uint8_t cacheable_bufs; /**< 1 to keep the data buffers cacheable, only the bd rings are marked noncacheable.
+	                             rx buffers are invalidated per bd on completion and must be treated as read only,
+	                             rx_buffer_base and bd_buf_size must be multiples of AXISDMA_CACHE_LINE_SIZE.
+	                             the tlb works on 1MB sections, buffers sharing one with the bds stay noncacheable */
+	/* rx processing parameters */
+	uint8_t rx_deferred; /**< 1 to only queue completed rx bds in the isr, callbacks run and bds return to
+	                          hardware from axisDmaCtrl_rxPoll */
+	uint8_t rx_mode; /**< AXISDMA_RX_MODE_*, the polling modes can not be combined with rx_deferred */
+	uint8_t rx_cyclic; /**< 1 to loop s2mm over the rx bd ring without ever handing bds back, the rx callbacks
+	                        are not used and the data is read through axisDmaCtrl_rxCyclicProducer/rxCyclicGet.
+	                        can not be combined with rx_deferred, rx_lend or the polling rx modes */
+	uint16_t rx_refill_watermark; /**< consumed rx bds that are handed back to hardware at once while a batch of
+	                                   completions is still being delivered, 0 hands the whole batch back after
+	                                   its last callback. zero copy packets hold their bds until the EOF fragment */
+	uint8_t rx_lend; /**< 1 to lend rx buffers to the callback, they only go back to the pool through
+	                      axisDmaCtrl_rxRelease. bds are refilled from the pool so the rx buffer region
+	                      should hold more bd_buf_size buffers than there are rx bds */
+	uint32_t rx_block_timeout_us; /**< idle time after which a partly filled block is handed over, checked by
+	                                   axisDmaCtrl_rxPoll. 0 only hands over full blocks */
+	/* stall watchdog parameters */
+	uint32_t stall_timeout_us; /**< time a channel may hold outstanding work without progress before
+	                                axisDmaCtrl_watchdog reports it stalled, 0 disables the watchdog */
+	uint8_t stall_recover; /**< 1 to have axisDmaCtrl_watchdog run axisDmaCtrl_recover on a stall */
+	/* tx software queue parameters */
+	uint16_t tx_queue_depth; /**< packets axisDmaCtrl_sendPackets, sendPacketCookie and txBufSubmit queue while
+	                              the tx bd ring is full, the tx isr pushes them to hardware as bds free up.
+	                              every priority gets a queue this deep. 0 turns a full ring away with
+	                              E_AXISDMA_NOBDS, at most AXISDMA_TXQ_MAX */
+	uint16_t tx_queue_high; /**< queued packets (all priorities) at which the tx flow callback is told to stop,
+	                             0 uses tx_queue_depth */
+	uint16_t tx_queue_low;  /**< queued packets at which a stopped producer is told to resume, below tx_queue_high */
+	uint8_t tx_sched; /**< AXISDMA_TX_SCHED_*, how the tx isr picks the next queued packet between priorities */
+	uint8_t tx_weight[AXISDMA_TXQ_PRIOS]; /**< packets a bulk priority sends per turn with AXISDMA_TX_SCHED_WEIGHTED,
+	                                           0 counts as 1. entry 0 is not used */
+	uint16_t tx_bulk_max_bds; /**< most bds of bulk priorities the hardware owns at once, bounds the wait of a
+	                               priority 0 packet behind bulk data. a bigger packet still goes out on its
+	                               own, 0 does not cap */
+	/* interrupt coalescing parameters */
+	struct axisDmaCtrl_coalesce tx_coalesce; /**< tx ring policy, coalesce_count applies when not adaptive */
+	struct axisDmaCtrl_coalesce rx_coalesce; /**< rx ring policy, coalesce_count applies when not adaptive */
 };
 
 /**
  * @brief      Changes the TX Callback on the fly
  *
+ * @param      inst  controller instance
  * @param[in]  cb    function for tx callback
  *
  * @return     success on valid memory address (not null)
  */
-int axisDmaCtrl_register_tx_cb(dma_tx_cb_t cb);
+int axisDmaCtrl_register_tx_cb(struct axisDmaCtrl *inst, dma_tx_cb_t cb);
 
 /**
  * @brief      Changes the RX Callback on the fly
  *
+ * @param      inst  controller instance
  * @param[in]  cb    function for rx callback
  *
  * @return     success on valid memory address (not null)
  */
-int axisDmaCtrl_register_rx_cb(dma_rx_cb_t cb);
+int axisDmaCtrl_register_rx_cb(struct axisDmaCtrl *inst, dma_rx_cb_t cb);
+
+/**
+ * @brief      Switches RX delivery to one callback per packet instead of one
+ *             per BD. BDs are collected from SOF to EOF and handed over as a
+ *             fragment list, or copied into copyBuf when it is provided.
+ *
+ * @param      inst         controller instance
+ * @param[in]  cb           function for packet rx callback, NULL returns to
+ *                          the per BD rx callback
+ * @param      copyBuf      optional buffer packets are copied into, NULL to
+ *                          receive the fragment list
+ * @param[in]  copyBufSize  size of copyBuf in bytes
+ *
+ * @return     success
+ */
+int axisDmaCtrl_register_rx_pkt_cb(struct axisDmaCtrl *inst, dma_rx_pkt_cb_t cb,
+	uint8_t *copyBuf, size_t copyBufSize);
+
+/**
+ * @brief      Sets the callback of the block rx mode (params->rx_block_size).
+ *             It runs once per full block, or with AXISDMA_BLK_PARTIAL once
+ *             the stream stayed idle for rx_block_timeout_us. A block is
+ *             refilled as soon as its callback returns. Blocks completing
+ *             before a callback is set are dropped.
+ *
+ * @param      inst  controller instance
+ * @param[in]  cb    function for block rx callback
+ *
+ * @return     success, failure when rx_block_size is not set
+ */
+int axisDmaCtrl_register_rx_block_cb(struct axisDmaCtrl *inst, dma_rx_block_cb_t cb);
+
+/**
+ * @brief      Switches TX completion to one callback per packet instead of
+ *             one per BD. It runs at the EOF bd with the cookie the packet
+ *             was submitted with (axisDmaCtrl_sendPacketCookie, the buffer
+ *             of the first bd for every other submit call), so buffers can
+ *             be recycled as soon as their packet is out. Packets lost in
+ *             a recovery get it too, after the tx lost callback.
+ *
+ * @param      inst  controller instance
+ * @param[in]  cb    function for packet tx callback, NULL returns to the
+ *                   per BD tx callback
+ *
+ * @return     success
+ */
+int axisDmaCtrl_register_tx_pkt_cb(struct axisDmaCtrl *inst, dma_tx_pkt_cb_t cb);
+
+/**
+ * @brief      Sets the callback axisDmaCtrl_recover reports lost tx packets
+ *             to. Without one lost packets are only counted.
+ *
+ * @param      inst  controller instance
+ * @param[in]  cb    function for the tx lost callback, NULL to remove it
+ *
+ * @return     success
+ */
+int axisDmaCtrl_register_tx_lost_cb(struct axisDmaCtrl *inst, dma_tx_lost_cb_t cb);
+
+/**
+ * @brief      Sets the backpressure callback of the tx software queue
+ *             (params->tx_queue_depth)
+ *
+ * @param      inst  controller instance
+ * @param[in]  cb    function for the tx flow callback, NULL to remove it
+ *
+ * @return     success
+ */
+int axisDmaCtrl_register_tx_flow_cb(struct axisDmaCtrl *inst, dma_tx_flow_cb_t cb);
+
+/**
+ * @brief      Sets the callback axisDmaCtrl_watchdog reports stalls to
+ *
+ * @param      inst  controller instance
+ * @param[in]  cb    function for the stall callback, NULL to remove it
+ *
+ * @return     success
+ */
+int axisDmaCtrl_register_stall_cb(struct axisDmaCtrl *inst, dma_stall_cb_t cb);
 
 /**
  * @brief      Initializes DMA system. Registers TX and RX callback functions.
- *             Sets up memory area to be registered as noncacheable by the tlb. 
+ *             Sets up memory area to be registered as noncacheable by the tlb,
+ *             only the bd space when params->cacheable_bufs is set.
  *
  * @param      params           Initialized axisDmaCtrl_params struct
  * @param      IntcInstancePtr  Pointer to the XscuGic instance
  * @param[in]  rxCb             The receive callback function
  * @param[in]  txCb             The transmit callback function
+ * @param      cbCtx            User context passed to every callback
  *
- * @return     { description_of_the_return_value }
+ * @return     controller instance, NULL on failure or when the dma core is
+ *             already driven by another instance
  */
-int axisDmaCtrl_init(struct axisDmaCtrl_params *params, 
+struct axisDmaCtrl *axisDmaCtrl_init(struct axisDmaCtrl_params *params, 
 	XScuGic * IntcInstancePtr,
 	dma_rx_cb_t rxCb,
-	dma_tx_cb_t txCb);
+	dma_tx_cb_t txCb,
+	void *cbCtx);
 
 /**
  * @brief      Removes DMA interrupts from the GIC. Clears specified memory
  *             provided in the init. Unregisters callback functions.	 
  *
- * @param      IntcInstancePtr  Pointer to the XscuGic instance
+ * @param      inst  controller instance, free for reuse afterwards
  */
-void axisDmaCtrl_disable(XScuGic * IntcInstancePtr);
+void axisDmaCtrl_disable(struct axisDmaCtrl *inst);
 
 /**
  * @brief      Handles sending a memory region as a single packet. Must be
  *             cognisant of how the AXI4-Stream system in the FPGA works.
  *             End of memory region will assert a TLAST flag.
  *
+ * @param      inst        controller instance
  * @param      packetBuf   The packet buffer
  * @param[in]  packetSize  The packet size
  *
- * @return     { description_of_the_return_value }
+ * @return     success, E_AXISDMA_NOBDS if the ring is full. with
+ *             params->tx_queue_depth the packet is queued instead and only
+ *             turned away once the queue is full as well, the buffer has
+ *             to stay untouched until the packet is out
  */
-int axisDmaCtrl_sendPackets(uint8_t * packetBuf, size_t packetSize);
+int axisDmaCtrl_sendPackets(struct axisDmaCtrl *inst, uint8_t * packetBuf, size_t packetSize);
+
+/**
+ * @brief      Same as axisDmaCtrl_sendPackets, the packet tx callback gets
+ *             cookie instead of packetBuf once the packet is out
+ *
+ * @param      inst        controller instance
+ * @param      packetBuf   The packet buffer
+ * @param[in]  packetSize  The packet size
+ * @param      cookie      handed to the packet tx callback
+ *
+ * @return     success, E_AXISDMA_NOBDS if the ring (and the tx queue) is full
+ */
+int axisDmaCtrl_sendPacketCookie(struct axisDmaCtrl *inst, uint8_t * packetBuf, size_t packetSize,
+	void *cookie);
+
+/**
+ * @brief      Same as axisDmaCtrl_sendPacketCookie at a given priority of the
+ *             tx queue. A packet only goes straight to hardware when
+ *             nothing is queued, bulk priorities also only within
+ *             params->tx_bulk_max_bds, and is queued otherwise. The tx isr
+ *             then picks between priorities as set by params->tx_sched.
+ *
+ * @param      inst        controller instance
+ * @param      packetBuf   The packet buffer
+ * @param[in]  packetSize  The packet size
+ * @param      cookie      handed to the packet tx callback
+ * @param[in]  prio        0 (what every other submit call uses) up to
+ *                         AXISDMA_TXQ_PRIOS - 1, bulk priorities need
+ *                         params->tx_queue_depth
+ *
+ * @return     success, E_AXISDMA_NOBDS if the queue of prio is full,
+ *             XST_INVALID_PARAM for a bad prio or a packet bigger than the
+ *             ring
+ */
+int axisDmaCtrl_sendPacketPrio(struct axisDmaCtrl *inst, uint8_t * packetBuf, size_t packetSize,
+	void *cookie, int prio);
+
+/**
+ * @brief      Runs the rx callbacks for bds queued by the isr when
+ *             params->rx_deferred is set and returns the bds to hardware.
+ *             In the polling rx modes it takes completed bds straight from
+ *             the ring instead, in AXISDMA_RX_MODE_NAPI only after an rx irq
+ *             switched the ring over to polling.
+ *             In block rx mode it also hands over a partly filled block
+ *             once rx_block_timeout_us passed, call it periodically when
+ *             the stream can stop.
+ *             Call from thread context (main loop), never from an isr.
+ *
+ * @param      inst    controller instance
+ * @param[in]  budget  max number of bds to process, <= 0 for all queued.
+ *                     a packet spanning more bds than the budget is still
+ *                     taken whole, from the ring in the polling modes and
+ *                     from the queue with rx_deferred
+ *
+ * @return     number of bds processed
+ */
+int axisDmaCtrl_rxPoll(struct axisDmaCtrl *inst, int budget);
+
+/**
+ * @brief      Gives a buffer lent to the rx callback back to the pool when
+ *             params->rx_lend is set. Bds left empty because the pool ran
+ *             dry are refilled right away. Safe from the rx callback.
+ *
+ * @param      inst      controller instance
+ * @param[in]  buf_addr  buffer address as handed to the callback, for the
+ *                       packet callback every fragment is released on its own
+ *
+ * @return     success, XST_INVALID_PARAM if buf_addr is not a pool buffer
+ *             the user holds, a second release of a buffer included
+ */
+int axisDmaCtrl_rxRelease(struct axisDmaCtrl *inst, uint32_t buf_addr);
+
+/**
+ * @brief      Cyclic rx mode: catches up with the hardware and returns the
+ *             producer index, the free running count of bds the s2mm engine
+ *             has filled. The rx isr does the same on every completion irq,
+ *             one of the two has to run at least once per lap of the ring.
+ *
+ * @param      inst  controller instance
+ *
+ * @return     producer index
+ */
+uint32_t axisDmaCtrl_rxCyclicProducer(struct axisDmaCtrl *inst);
+
+/**
+ * @brief      Cyclic rx mode: looks up the buffer filled for producer index
+ *             idx, as of the last producer update. The hardware refills the
+ *             slot one lap later, check again once the data has been
+ *             consumed to be sure it was not overwritten meanwhile.
+ *
+ * @param      inst  controller instance
+ * @param[in]  idx   producer index
+ * @param[out] frag  buffer address and length of the bd
+ *
+ * @return     XST_SUCCESS, XST_FAILURE when idx was not produced yet and
+ *             E_AXISDMA_OVERRUN when the data of idx is lost
+ */
+int axisDmaCtrl_rxCyclicGet(struct axisDmaCtrl *inst, uint32_t idx, struct axisDmaCtrl_frag *frag);
+
+/**
+ * @brief      Cyclic rx mode: oldest producer index whose data is still
+ *             intact, where a consumer resumes after an overrun
+ *
+ * @param      inst  controller instance
+ */
+uint32_t axisDmaCtrl_rxCyclicOldest(struct axisDmaCtrl *inst);
+
+/**
+ * @brief      Takes a block out of the tx buffer pool (params->tx_block_size).
+ *             The block is DMA ready memory, the packet is built in place
+ *             and handed over with axisDmaCtrl_txBufSubmit.
+ *
+ * @param      inst  controller instance
+ * @return     the block, NULL if the pool is empty or disabled
+ */
+uint8_t *axisDmaCtrl_txBufGet(struct axisDmaCtrl *inst);
+
+/**
+ * @brief      Sends a pool block as a single packet without any cache
+ *             maintenance. The block returns to the pool by itself once the
+ *             last bd of the packet completed.
+ *
+ * @param      inst        controller instance
+ * @param      buf         block from axisDmaCtrl_txBufGet
+ * @param[in]  packetSize  number of bytes to send, at most tx_block_size
+ *
+ * @return     success, E_AXISDMA_NOBDS if the ring is full (the caller keeps
+ *             the block), XST_INVALID_PARAM for a foreign buffer or size
+ */
+int axisDmaCtrl_txBufSubmit(struct axisDmaCtrl *inst, uint8_t * buf, size_t packetSize);
+
+/**
+ * @brief      Returns a pool block that will not be submitted
+ *
+ * @param      inst  controller instance
+ * @param      buf   block from axisDmaCtrl_txBufGet
+ */
+void axisDmaCtrl_txBufPut(struct axisDmaCtrl *inst, uint8_t * buf);
+
+/**
+ * @brief      Sends several packets with a single bd allocation and a single
+ *             tail pointer update. Packets are taken in order for as long as
+ *             the ring has room for all of their bds.
+ *
+ * @param      inst     controller instance
+ * @param      pkts     array of packets, pool blocks are not flushed
+ * @param[in]  numPkts  number of entries in pkts
+ *
+ * @return     number of packets accepted, 0 when the ring has no room for the
+ *             first one or packets wait in the tx queue, E_AXISDMA_FAILED on
+ *             failure
+ */
+int axisDmaCtrl_sendPacketBatch(struct axisDmaCtrl *inst,
+	const struct axisDmaCtrl_txPkt *pkts, int numPkts);
+
+/**
+ * @brief      Sends a packet gathered from several segments, e.g. a header
+ *             and a payload living elsewhere, without assembling it first.
+ *             Every segment is cut into bd_buf_size bds, SOF goes on the
+ *             first bd of the packet and EOF on the last.
+ *
+ * @param      inst    controller instance
+ * @param      iov     segments in stream order, empty ones are skipped. a tx
+ *                     pool block only goes back to the pool by itself when
+ *                     it holds the last segment
+ * @param[in]  iovcnt  number of entries in iov
+ *
+ * @return     success, E_AXISDMA_NOBDS if the ring has no room for the whole
+ *             packet or packets wait in the tx queue, XST_FAILURE otherwise
+ */
+int axisDmaCtrl_sendPacketIov(struct axisDmaCtrl *inst,
+	const struct axisDmaCtrl_iovec *iov, int iovcnt);
+
+/**
+ * @brief      Works out the bd layout of packets of packetSize bytes once, so
+ *             that axisDmaCtrl_sendPrepared only has to patch in the buffer
+ *             address. Lengths, SOF/EOF and the bd count never change
+ *             between packets of the same size.
+ *
+ * @param      inst        controller instance
+ * @param      prep        filled on success
+ * @param[in]  packetSize  packet size, at most the whole tx ring
+ *
+ * @return     success, XST_INVALID_PARAM if tx is disabled or the packet
+ *             does not fit the ring
+ */
+int axisDmaCtrl_txPrepare(struct axisDmaCtrl *inst, struct axisDmaCtrl_txPrep *prep,
+	size_t packetSize);
+
+/**
+ * @brief      Sends prep->len bytes of packetBuf with the layout of
+ *             axisDmaCtrl_txPrepare, two stores per bd. No cache
+ *             maintenance, flush packetBuf unless it is noncacheable. A tx
+ *             pool block goes back to the pool by itself.
+ *
+ * @param      inst       controller instance
+ * @param      prep       layout from axisDmaCtrl_txPrepare on inst
+ * @param      packetBuf  The packet buffer
+ * @param      cookie     handed to the packet tx callback
+ *
+ * @return     success, E_AXISDMA_NOBDS if the ring is full. with
+ *             params->tx_queue_depth the packet is queued like
+ *             axisDmaCtrl_sendPacketCookie does instead, XST_INVALID_PARAM
+ *             for a misaligned packetBuf
+ */
+int axisDmaCtrl_sendPrepared(struct axisDmaCtrl *inst, const struct axisDmaCtrl_txPrep *prep,
+	uint8_t * packetBuf, void *cookie);
 
 /**
  * @brief      Debug function to print the elements of the axisDmaCtrl_params struct
@@ -118,12 +748,162 @@ void axisDmaCtrl_printParams(struct axisDmaCtrl_params *in);
 
 /**
  * @brief      Debug function to return the number of available BDs for transmit
+ *
+ * @param      inst  controller instance
  */
-int axisDmaCtrl_getAvailTxBds(void);
+int axisDmaCtrl_getAvailTxBds(struct axisDmaCtrl *inst);
 
 /**
  * @brief      Debug function to return the number of available BDs for receive
+ *
+ * @param      inst  controller instance
+ */
+int axisDmaCtrl_getAvailRxBds(struct axisDmaCtrl *inst);
+
+/**
+ * @brief      Debug function to return the number of rx buffers in the lending pool
+ *
+ * @param      inst  controller instance
+ */
+int axisDmaCtrl_getAvailRxBufs(struct axisDmaCtrl *inst);
+
+/**
+ * @brief      Debug function to return the number of blocks in the tx buffer pool
+ *
+ * @param      inst  controller instance
+ */
+int axisDmaCtrl_getAvailTxBufs(struct axisDmaCtrl *inst);
+
+/**
+ * @brief      Debug function to return the number of packets in the tx software queue
+ *
+ * @param      inst  controller instance
+ */
+int axisDmaCtrl_getTxQueued(struct axisDmaCtrl *inst);
+
+/**
+ * @brief      Debug function to return the current tx coalesce threshold
+ *
+ * @param      inst  controller instance
+ */
+int axisDmaCtrl_getTxCoalesce(struct axisDmaCtrl *inst);
+
+/**
+ * @brief      Debug function to return the current rx coalesce threshold
+ *
+ * @param      inst  controller instance
+ */
+int axisDmaCtrl_getRxCoalesce(struct axisDmaCtrl *inst);
+
+/**
+ * @brief      Copies the runtime counters of both channels, with the dma
+ *             irqs masked so the snapshot is consistent. Optionally clears
+ *             them in the same step so nothing is lost between the two.
+ *             Call from thread context.
+ *
+ * @param      inst   controller instance
+ * @param      stats  filled with the counters, NULL to only reset
+ * @param[in]  reset  1 to clear the counters after the copy
+ *
+ * @return     success
+ */
+int axisDmaCtrl_getStats(struct axisDmaCtrl *inst, struct axisDmaCtrl_stats *stats, int reset);
+
+/**
+ * @brief      Starts or stops recording dma events (submit, to hardware,
+ *             completion, callback, free, error, reset) into the trace
+ *             ring. The ring keeps the last AXISDMA_TRACE_DEPTH events and
+ *             survives a stop so it can be dumped afterwards.
+ *
+ * @param      inst    controller instance
+ * @param[in]  enable  1 to record, 0 to stop
+ */
+void axisDmaCtrl_traceEnable(struct axisDmaCtrl *inst, int enable);
+
+/**
+ * @brief      Writes the trace as a struct axisDmaCtrl_traceHdr followed by
+ *             the recorded events oldest first, ready to be saved and fed
+ *             to the host side decoder. When buf is too small the newest
+ *             events are kept. Recording may go on meanwhile, slots
+ *             overwritten during the copy show up out of sequence.
+ *
+ * @param      inst  controller instance
+ * @param      buf   destination
+ * @param[in]  size  size of buf in bytes
+ *
+ * @return     number of bytes written, 0 when buf can not hold the header
+ */
+uint32_t axisDmaCtrl_traceDump(struct axisDmaCtrl *inst, void *buf, uint32_t size);
+
+/**
+ * @brief      Tells whether a channel halted on an error. The error irq only
+ *             records the error, the channel stays halted until
+ *             axisDmaCtrl_recover runs.
+ *
+ * @param      inst  controller instance
+ *
+ * @return     AXISDMA_ERR_* mask of the halted channels, 0 when both run
+ */
+int axisDmaCtrl_errorPending(struct axisDmaCtrl *inst);
+
+/**
+ * @brief      Brings the engine back after an error (or a stall) without
+ *             tearing the instance down:
+ *             - lets the rx ring drain until it stays idle for
+ *               AXISDMA_RECOVER_DRAIN_US, at most AXISDMA_RECOVER_TIMEOUT_US
+ *             - resets the engine with both dma irqs masked
+ *             - accounts the tx bds that completed, hands every packet with
+ *               a bd left undone to the tx lost callback and returns pool
+ *               blocks and lent rx buffers held by the rings
+ *             - rebuilds and restarts both rings as axisDmaCtrl_init did.
+ *               Pools, the tx queue, callbacks and counters are kept, a
+ *               packet or block open in the rx reassembly is dropped or
+ *               handed over partial and the cyclic producer index starts
+ *               over at 0
+ *             Call from thread context, never from a callback or an isr.
+ *
+ * @param      inst  controller instance
+ * @param[out] info  filled with what was lost and how long it took, may be NULL
+ *
+ * @return     success, XST_FAILURE when the reset did not complete (the
+ *             channels stay halted, the call can be repeated) or a ring
+ *             could not be rebuilt
+ */
+int axisDmaCtrl_recover(struct axisDmaCtrl *inst, struct axisDmaCtrl_recovery *info);
+
+/**
+ * @brief      Checks both rings for progress, call it periodically from
+ *             thread context (e.g. the main loop) when
+ *             params->stall_timeout_us is set. A channel is stalled when
+ *             for stall_timeout_us
+ *             - tx: bds were handed to hardware and none came back
+ *             - rx: the oldest armed bd completed and nobody took it (lost
+ *               irq, napi ring not polled)
+ *             - either: the status register shows it halted
+ *             The stall callback runs per stalled channel, then the engine
+ *             is recovered when params->stall_recover is set. A stall that
+ *             persists is reported again every stall_timeout_us. Cyclic rx
+ *             rings are not watched.
+ *
+ * @param      inst  controller instance
+ *
+ * @return     AXISDMA_ERR_* mask of the channels found stalled
+ */
+int axisDmaCtrl_watchdog(struct axisDmaCtrl *inst);
+
+#ifdef AXISDMA_ENABLE_LATENCY
+/**
+ * @brief      Copies the latency samples of every stage with the dma irqs
+ *             masked, optionally clearing them in the same step. Only built
+ *             with AXISDMA_ENABLE_LATENCY. Call from thread context.
+ *
+ * @param      inst   controller instance
+ * @param      lat    filled with the samples, NULL to only reset
+ * @param[in]  reset  1 to clear the samples after the copy
+ *
+ * @return     success
  */
-int axisDmaCtrl_getAvailRxBds(void);
+int axisDmaCtrl_getLatency(struct axisDmaCtrl *inst, struct axisDmaCtrl_latency *lat, int reset);
+#endif
 
 #endif // AXIS_DMA_CONTROLLER_H
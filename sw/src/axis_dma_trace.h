@@ -0,0 +1,56 @@
+/**
+ * @brief  Binary layout of the event trace kept by the axis_dma_controller
+ *         api (axisDmaCtrl_traceEnable/axisDmaCtrl_traceDump). Kept free of
+ *         BSP headers so host side tools can decode a dump with it.
+ *
+ * @author gutelfuldead@github.com
+ */
+
+#ifndef AXIS_DMA_TRACE_H
+#define AXIS_DMA_TRACE_H
+
+#include <stdint.h>
+
+#define AXISDMA_TRACE_MAGIC   0x52544441 /**< "ADTR" little endian, first word of a dump */
+#define AXISDMA_TRACE_VERSION 1          /**< bumped whenever the layout below changes */
+
+#define AXISDMA_TRACE_TX 0 /**< event on the mm2s channel */
+#define AXISDMA_TRACE_RX 1 /**< event on the s2mm channel */
+
+#define AXISDMA_TRACE_SUBMIT   1 /**< tx segment queued, buf/len of the segment, bd is its first bd */
+#define AXISDMA_TRACE_TOHW     2 /**< bds handed to hardware, bd is the first, len the number of bds */
+#define AXISDMA_TRACE_COMPLETE 3 /**< bd taken back from hardware, len is the transferred length, sts the status word */
+#define AXISDMA_TRACE_CALLBACK 4 /**< user callback about to run, buf/len as handed over (cookie/bytes and the status for the packet tx callback) */
+#define AXISDMA_TRACE_FREE     5 /**< bds returned to the free list, bd is the first, len the number of bds */
+#define AXISDMA_TRACE_ERROR    6 /**< bd completed with an error (sts is the bd status) or error irq (bd and buf 0, sts is the irq status) */
+#define AXISDMA_TRACE_RESET    7 /**< engine reset by axisDmaCtrl_recover, sts holds the AXISDMA_ERR_* bits pending */
+#define AXISDMA_TRACE_STALL    8 /**< channel stalled, bd is the oldest one hardware holds, len the bds it holds, sts the status register */
+
+/**
+ * Header at the start of a dump, followed by count events oldest first
+ */
+struct axisDmaCtrl_traceHdr {
+	uint32_t magic;             /**< AXISDMA_TRACE_MAGIC */
+	uint16_t version;           /**< AXISDMA_TRACE_VERSION */
+	uint16_t evt_size;          /**< sizeof(struct axisDmaCtrl_traceEvt) */
+	uint32_t count;             /**< events in the dump */
+	uint32_t head;              /**< events recorded since init, count < head means older ones were overwritten */
+	uint64_t counts_per_second; /**< timestamp rate */
+};
+
+/**
+ * One recorded event
+ */
+struct axisDmaCtrl_traceEvt {
+	uint64_t ts;   /**< XTime when the event was recorded */
+	uint32_t seq;  /**< 1 + position in the trace, 0 or out of sequence when the slot was being written */
+	uint32_t bd;   /**< bd address, 0 when the event is not about a single bd */
+	uint32_t buf;  /**< buffer address */
+	uint32_t len;  /**< bytes or bd count, see the event type */
+	uint32_t sts;  /**< bd status word or irq status */
+	uint8_t type;  /**< AXISDMA_TRACE_SUBMIT.. */
+	uint8_t chan;  /**< AXISDMA_TRACE_TX or AXISDMA_TRACE_RX */
+	uint16_t rsvd;
+};
+
+#endif // AXIS_DMA_TRACE_H
@@ -0,0 +1,366 @@
+/**
+ * @brief throughput/latency benchmark for the axis_dma_controller api
+ *
+ * Sweeps bd_buf_size, packet size, coalesce_count, ring depth and tx batch
+ * size over the loopback design and prints one CSV row per configuration:
+ *
+ *   coalesce      coalesce_count of both rings, 0 runs the adaptive policy
+ *                 between 1 and BENCH_ADAPT_MAX
+ *   tx_batch      packets per submission, 1 uses axisDmaCtrl_sendPackets,
+ *                 more use axisDmaCtrl_sendPacketBatch, 0 sends single
+ *                 packets through one axisDmaCtrl_txPrepare layout *
+ *   mbps/pps      rx payload rate over the whole run
+ *   isr_us/pct    time spent inside the dma interrupt handlers, measured by
+ *                 wrapping the handlers the api connected to the GIC
+ *   lat_*_us      tx-to-rx latency percentiles, from the sendPackets call
+ *                 to the rx callback of the first fragment of that packet
+ *
+ * Every packet carries its sequence number in the first 4 bytes, which is
+ * also used to detect lost or reordered packets.
+ */
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "xtime_l.h"
+#include "axis_dma_controller.h"
+
+#define MEM_BASE_ADDR          (XPAR_PS7_DDR_0_S_AXI_BASEADDR + 0x1000000)
+#define BD_SIZE                XAXIDMA_BD_MINIMUM_ALIGNMENT
+
+#define DMA_DEV_ID	           XPAR_AXIDMA_0_DEVICE_ID
+#define RX_INTR_ID	           XPAR_FABRIC_AXI_DMA_0_S2MM_INTROUT_INTR
+#define TX_INTR_ID   	       XPAR_FABRIC_AXI_DMA_0_MM2S_INTROUT_INTR
+
+#define BENCH_NUM_PKTS         2000   /* packets per configuration */
+#define BENCH_TX_SLOTS         512    /* must exceed the largest ring depth */
+#define BENCH_TIMEOUT_SEC      2      /* abort a configuration w/o progress */
+#define BENCH_MAX_BATCH        16
+#define BENCH_ADAPT_MAX        32
+
+#define ARRAY_LEN(a) (sizeof(a) / sizeof((a)[0]))
+
+static const int benchBufSizes[]  = { 64, 512, 2048, 8192 };
+static const int benchPktSizes[]  = { 64, 512, 1500, 8192 };
+static const int benchCoalesce[]  = { 1, 8, 32, 0 };
+static const int benchRingBds[]   = { 16, 64, 256 };
+static const int benchTxBatch[]   = { 0, 1, 16 };
+
+struct bench_irq_wrap {
+	Xil_InterruptHandler handler;
+	void *ref;
+	u64 count;
+	XTime busy;
+};
+
+static XScuGic intc;
+static struct axisDmaCtrl *dma;
+static struct bench_irq_wrap txIrq;
+static struct bench_irq_wrap rxIrq;
+
+static uint8_t *txSlots;
+static int pktSize;
+static XTime txTime[BENCH_TX_SLOTS];
+static XTime latency[BENCH_NUM_PKTS];
+
+static volatile int rxPkts;
+static volatile int txBds;
+static int rxBytesInPkt;
+static uint32_t rxExpectSeq;
+static int errors;
+
+static int gic_init(void);
+static void gic_enable(void);
+static void tx_callback(void *ctx);
+static void rx_callback(void *ctx, uint32_t buf_addr, uint32_t buf_len);
+static void irq_wrap(void *ref);
+static void irq_hook(struct bench_irq_wrap *w, u32 irqId);
+static int cmp_xtime(const void *a, const void *b);
+static int bench_run(int bufSize, int pkt, int coalesce, int ringBds, int txBatch);
+
+int axis_dma_controller_bench(void)
+{
+	int rc = XST_SUCCESS;
+	unsigned int b, p, c, r, t;
+
+	if (gic_init())
+		return XST_FAILURE;
+	gic_enable();
+
+	printf("bd_buf_size,pkt_size,coalesce,ring_bds,tx_batch,packets,bytes,elapsed_us,"
+		"mbps,pps,tx_irqs,rx_irqs,isr_us,isr_pct,"
+		"lat_p50_us,lat_p90_us,lat_p99_us,lat_max_us,errors\r\n");
+
+	for (b = 0; b < ARRAY_LEN(benchBufSizes); b++)
+		for (p = 0; p < ARRAY_LEN(benchPktSizes); p++)
+			for (c = 0; c < ARRAY_LEN(benchCoalesce); c++)
+				for (r = 0; r < ARRAY_LEN(benchRingBds); r++)
+					for (t = 0; t < ARRAY_LEN(benchTxBatch); t++) {
+						int bdsPerPkt = (benchPktSizes[p] + benchBufSizes[b] - 1) /
+							benchBufSizes[b];
+						/* a packet must fit in both rings at once */
+						if (bdsPerPkt > benchRingBds[r])
+							continue;
+#ifdef AXISDMA_STATIC_BD_BUF_SIZE
+						if (benchBufSizes[b] != AXISDMA_STATIC_BD_BUF_SIZE)
+							continue;
+#endif
+#ifdef AXISDMA_STATIC_TX_BDS
+						if (benchRingBds[r] != AXISDMA_STATIC_TX_BDS)
+							continue;
+#endif
+#ifdef AXISDMA_STATIC_RX_BDS
+						if (benchRingBds[r] != AXISDMA_STATIC_RX_BDS)
+							continue;
+#endif
+						if (bench_run(benchBufSizes[b], benchPktSizes[p],
+								benchCoalesce[c], benchRingBds[r], benchTxBatch[t]))
+							rc = XST_FAILURE;
+					}
+
+	return rc;
+}
+
+static int bench_run(int bufSize, int pkt, int coalesce, int ringBds, int txBatch)
+{
+	struct axisDmaCtrl_txPkt batch[BENCH_MAX_BATCH];
+	struct axisDmaCtrl_txPrep txPrep;
+	struct axisDmaCtrl_params params;
+	int bdsPerPkt = (pkt + bufSize - 1) / bufSize;
+	int txPkts = 0;
+	int lastRx = 0;
+	XTime start, end, now, lastProgress;
+	u64 elapsedNs, isrNs, bytes;
+	int rc;
+	int i;
+
+	params.rx_bd_space_base = MEM_BASE_ADDR;
+	params.rx_bd_space_high = params.rx_bd_space_base + ringBds * BD_SIZE - 1;
+	params.tx_bd_space_base = params.rx_bd_space_high + 1;
+	params.tx_bd_space_high = params.tx_bd_space_base + ringBds * BD_SIZE - 1;
+	params.tx_buffer_base   = params.tx_bd_space_high + 1;
+	params.tx_buffer_high   = params.tx_buffer_base + BENCH_TX_SLOTS * pkt - 1;
+	params.rx_buffer_base   = (params.tx_buffer_high + BD_SIZE) & ~(BD_SIZE - 1);
+	params.rx_buffer_high   = params.rx_buffer_base + ringBds * bufSize - 1;
+	params.bd_buf_size      = bufSize;
+	params.tx_block_size    = 0;
+	params.rx_block_size    = 0;
+	params.coalesce_count   = coalesce;
+	params.txIrqPriority    = 0xA0;
+	params.rxIrqPriority    = 0xA0;
+	params.txIrqId          = TX_INTR_ID;
+	params.rxIrqId          = RX_INTR_ID;
+	params.dmaDevId         = DMA_DEV_ID;
+	params.txEn             = 1;
+	params.rxEn             = 1;
+	params.cacheable_bufs   = 0;
+	params.rx_deferred      = 0;
+	params.rx_lend          = 0;
+	params.rx_mode          = AXISDMA_RX_MODE_IRQ;
+	params.rx_refill_watermark = 0;
+	params.rx_cyclic        = 0;
+	params.rx_block_timeout_us = 0;
+	params.stall_timeout_us = 0;
+	params.stall_recover    = 0;
+	params.tx_queue_depth   = 0;
+	params.tx_queue_high    = 0;
+	params.tx_queue_low     = 0;
+	params.tx_sched         = AXISDMA_TX_SCHED_STRICT;
+	memset(params.tx_weight, 0, sizeof(params.tx_weight));
+	params.tx_bulk_max_bds  = 0;
+	memset(&params.tx_coalesce, 0, sizeof(params.tx_coalesce));
+	if (coalesce == 0) {
+		params.tx_coalesce.adaptive  = 1;
+		params.tx_coalesce.min_count = 1;
+		params.tx_coalesce.max_count = BENCH_ADAPT_MAX;
+	}
+	params.rx_coalesce      = params.tx_coalesce;
+
+	txSlots      = (uint8_t *)params.tx_buffer_base;
+	pktSize      = pkt;
+	rxPkts       = 0;
+	txBds        = 0;
+	rxBytesInPkt = 0;
+	rxExpectSeq  = 0;
+	errors       = 0;
+	memset(&txIrq, 0, sizeof(txIrq));
+	memset(&rxIrq, 0, sizeof(rxIrq));
+
+	for (i = 0; i < BENCH_TX_SLOTS * pkt; i++)
+		txSlots[i] = i % 255;
+
+	dma = axisDmaCtrl_init(&params, &intc, rx_callback, tx_callback, NULL);
+	if (dma == NULL) {
+		printf("axisDmaCtrl_init failed!\r\n");
+		return XST_FAILURE;
+	}
+	if (txBatch == 0 && axisDmaCtrl_txPrepare(dma, &txPrep, pkt) != XST_SUCCESS) {
+		printf("axisDmaCtrl_txPrepare failed!\r\n");
+		axisDmaCtrl_disable(dma);
+		return XST_FAILURE;
+	}
+	irq_hook(&txIrq, TX_INTR_ID);
+	irq_hook(&rxIrq, RX_INTR_ID);
+
+	XTime_GetTime(&start);
+	lastProgress = start;
+	while (rxPkts < BENCH_NUM_PKTS) {
+		XTime_GetTime(&now);
+		if (txPkts < BENCH_NUM_PKTS &&
+				txPkts - rxPkts < BENCH_TX_SLOTS &&
+				axisDmaCtrl_getAvailTxBds(dma) >= bdsPerPkt) {
+			int n = txBatch ? txBatch : 1;
+			int k;
+
+			if (n > BENCH_NUM_PKTS - txPkts)
+				n = BENCH_NUM_PKTS - txPkts;
+			if (n > BENCH_TX_SLOTS - (txPkts - rxPkts))
+				n = BENCH_TX_SLOTS - (txPkts - rxPkts);
+			for (k = 0; k < n; k++) {
+				uint32_t seq = txPkts + k;
+				int slot = seq % BENCH_TX_SLOTS;
+
+				batch[k].buf = txSlots + slot * pkt;
+				batch[k].len = pkt;
+				batch[k].cookie = NULL;
+				memcpy(batch[k].buf, &seq, sizeof(uint32_t));
+				txTime[slot] = now;
+			}
+			if (txBatch == 0) {
+				/* flushed like sendPackets does, the layout is reused */
+				Xil_DCacheFlushRange((UINTPTR)batch[0].buf, pkt);
+				if (axisDmaCtrl_sendPrepared(dma, &txPrep, batch[0].buf, NULL) == XST_SUCCESS)
+					txPkts++;
+			} else if (txBatch == 1) {
+				if (axisDmaCtrl_sendPackets(dma, batch[0].buf, pkt) == XST_SUCCESS)
+					txPkts++;
+			} else {
+				rc = axisDmaCtrl_sendPacketBatch(dma, batch, n);
+				if (rc > 0)
+					txPkts += rc;
+			}
+		}
+		if (rxPkts != lastRx) {
+			lastRx = rxPkts;
+			lastProgress = now;
+		} else if (now - lastProgress > BENCH_TIMEOUT_SEC * COUNTS_PER_SECOND) {
+			errors++;
+			break;
+		}
+	}
+	XTime_GetTime(&end);
+
+	axisDmaCtrl_disable(dma);
+
+	elapsedNs = (end - start) * 1000000000ULL / COUNTS_PER_SECOND;
+	isrNs = (txIrq.busy + rxIrq.busy) * 1000000000ULL / COUNTS_PER_SECOND;
+	bytes = (u64)rxPkts * pkt;
+	if (elapsedNs == 0)
+		elapsedNs = 1;
+
+	qsort(latency, rxPkts, sizeof(latency[0]), cmp_xtime);
+#define LAT_US(q) (rxPkts ? (double)latency[(rxPkts - 1) * (q) / 100] * \
+		1000000.0 / COUNTS_PER_SECOND : 0.0)
+
+	printf("%d,%d,%d,%d,%d,%d,%llu,%llu,%.2f,%.0f,%llu,%llu,%llu,%.1f,"
+		"%.1f,%.1f,%.1f,%.1f,%d\r\n",
+		bufSize, pkt, coalesce, ringBds, txBatch, rxPkts,
+		(unsigned long long)bytes,
+		(unsigned long long)(elapsedNs / 1000),
+		(double)bytes * 1000.0 / elapsedNs,
+		(double)rxPkts * 1000000000.0 / elapsedNs,
+		(unsigned long long)txIrq.count,
+		(unsigned long long)rxIrq.count,
+		(unsigned long long)(isrNs / 1000),
+		(double)isrNs * 100.0 / elapsedNs,
+		LAT_US(50), LAT_US(90), LAT_US(99), LAT_US(100),
+		errors);
+#undef LAT_US
+
+	return errors ? XST_FAILURE : XST_SUCCESS;
+}
+
+/* Interposes between the GIC and the handler the api connected */
+static void irq_hook(struct bench_irq_wrap *w, u32 irqId)
+{
+	XScuGic_VectorTableEntry *entry = &intc.Config->HandlerTable[irqId];
+
+	w->handler = entry->Handler;
+	w->ref = entry->CallBackRef;
+	XScuGic_Connect(&intc, irqId, irq_wrap, w);
+}
+
+static void irq_wrap(void *ref)
+{
+	struct bench_irq_wrap *w = ref;
+	XTime t0, t1;
+
+	XTime_GetTime(&t0);
+	w->handler(w->ref);
+	XTime_GetTime(&t1);
+	w->busy += t1 - t0;
+	w->count++;
+}
+
+static int cmp_xtime(const void *a, const void *b)
+{
+	XTime x = *(const XTime *)a;
+	XTime y = *(const XTime *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int gic_init(void)
+{
+	int rc;
+	XScuGic_Config *intcConfig;
+
+	intcConfig = XScuGic_LookupConfig(XPAR_SCUGIC_SINGLE_DEVICE_ID);
+	if (NULL == intcConfig) {
+		return XST_FAILURE;
+	}
+
+	rc = XScuGic_CfgInitialize(&intc, intcConfig,
+					intcConfig->CpuBaseAddress);
+	if (rc != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	return 0;
+}
+
+static void gic_enable(void)
+{
+	Xil_ExceptionInit();
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+			(Xil_ExceptionHandler)XScuGic_InterruptHandler,
+			(void *)&intc);
+	Xil_ExceptionEnable();
+}
+
+static void tx_callback(void *ctx)
+{
+	txBds++;
+}
+
+static void rx_callback(void *ctx, uint32_t buf_addr, uint32_t buf_len)
+{
+	uint8_t *rxPacket = (u8 *)(UINTPTR)buf_addr;
+
+	if (rxBytesInPkt == 0) {
+		uint32_t seq;
+		XTime now;
+
+		XTime_GetTime(&now);
+		memcpy(&seq, rxPacket, sizeof(seq));
+		if (seq != rxExpectSeq)
+			errors++;
+		rxExpectSeq = seq + 1;
+		if (rxPkts < BENCH_NUM_PKTS)
+			latency[rxPkts] = now - txTime[seq % BENCH_TX_SLOTS];
+	}
+
+	rxBytesInPkt += buf_len;
+	if (rxBytesInPkt >= pktSize) {
+		rxBytesInPkt = 0;
+		rxPkts++;
+	}
+}
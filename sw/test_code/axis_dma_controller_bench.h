@@ -0,0 +1,6 @@
+#ifndef AXIS_DMA_CONTROLLER_BENCH_H
+#define AXIS_DMA_CONTROLLER_BENCH_H
+
+int axis_dma_controller_bench(void);
+
+#endif // AXIS_DMA_CONTROLLER_BENCH_H
@@ -3,7 +3,15 @@
  */
 #include "stdio.h"
 #include "stdlib.h"
+#include "string.h"
 #include "axis_dma_controller.h"
+#include "axis_dma_controller_sample_exec.h"
+#ifdef AXISDMA_ENABLE_LATENCY
+#include "xtime_l.h"
+#endif
+#ifdef SAMPLE_SIM
+#include "sim_axidma.h"
+#endif
 
 #define MEM_BASE_ADDR   		(XPAR_PS7_DDR_0_S_AXI_BASEADDR + 0x1000000) /* 0x00100000 - 0x001fffff */
 #define MEM_REGION_BD_SIZE      (0x0000FFF)
@@ -16,33 +24,152 @@ int MAX_PKT_SIZE;
 #define RX_INTR_ID	       XPAR_FABRIC_AXI_DMA_0_S2MM_INTROUT_INTR
 #define TX_INTR_ID   	   XPAR_FABRIC_AXI_DMA_0_MM2S_INTROUT_INTR
 
+/* bds per axisDmaCtrl_rxPoll call in the polling rx modes */
+#define RX_POLL_BUDGET 16
+/* deferred queue budget of SAMPLE_RX_BUDGET, packets span more bds */
+#define RX_DEFERRED_BUDGET 4
+/* consumed rx bds handed back at once with SAMPLE_RX_REFILL */
+#define RX_REFILL_WATERMARK 8
+
+/* packets in flight in cyclic mode, well inside one lap of the rx ring */
+#define CYCLIC_MAX_INFLIGHT 4
+
+/* blocks the rx region is cut into with SAMPLE_RX_BLOCK and the idle time
+ * after which a partly filled one is handed over */
+#define RX_BLOCKS 3
+#define RX_BLOCK_TIMEOUT_US 200
+
+/* a channel holding work this long without progress fails the run */
+#define STALL_TIMEOUT_US 100000
+
+/* tx software queue of SAMPLE_TX_QUEUE and its watermarks */
+#define TX_QUEUE_DEPTH 32
+#define TX_QUEUE_HIGH  24
+#define TX_QUEUE_LOW   8
+
+/* bulk bds in flight with SAMPLE_TX_PRIO, every 8th packet is control traffic */
+#define TX_BULK_MAX_BDS 16
+#define TX_CTRL_EVERY   8
+
+/* packet tx callback cookie, the priority and the sequence number within it */
+#define TX_COOKIE(prio, seq) ((void *)(UINTPTR)(((prio) << 24) | (seq)))
+
 static int tx_bd_count;
 static int rx_bd_count;
 static int rx_pkt_count;
 static int error;
-static int pkt_complete = 1;
-static int pkt_bytes_rx = 0;
+
+/* rx buffers lent by the controller, released from the main loop */
+#define LENT_MAX 1024
+static volatile uint32_t lentBufs[LENT_MAX];
+static volatile int lentHead;
+static volatile int lentTail;
+static int lend;
+
+/* cyclic rx read position and the packet being rebuilt from it */
+static uint32_t cycIdx;
+static struct axisDmaCtrl_pkt cycPkt;
+
+/* trace dump of a SAMPLE_TRACE run */
+static uint8_t traceDump[sizeof(struct axisDmaCtrl_traceHdr) +
+	AXISDMA_TRACE_DEPTH * sizeof(struct axisDmaCtrl_traceEvt)];
+
+/* bytes received through the block callback and partly filled blocks seen */
+static uint32_t blkBytes;
+static int blkPartial;
+
+/* packets axisDmaCtrl_recover reported lost and where they have to start,
+ * 0 when the packets are not sent straight from txPkt */
+static int txLost;
+static uint32_t txLostAddr;
+
+/* packets through the packet tx callback and how many of them failed,
+ * sent and completed per priority */
+static int txPktDone;
+static int txPktFailed;
+static int txPrioSent[AXISDMA_TXQ_PRIOS];
+static int txPrioDone[AXISDMA_TXQ_PRIOS];
+
+/* priority of the first bulk packet done after the lost ones of a recovery,
+ * -1 while waiting for it. The weighted scheduler starts over with priority 1 */
+static int txRecBulk;
+
+/* tx queue backpressure as signalled by the flow callback */
+static volatile int txFlowStopped;
+static int txFlowStops;
 
 static XScuGic intc;
+static struct axisDmaCtrl *dma;
 static uint8_t txPkt[1024*1024];
 
+/* gather mode keeps the first bytes of the packet in their own buffer */
+#define HDR_SIZE 14
+static uint8_t txHdr[HDR_SIZE];
+
 static int gic_init(void);
 static void gic_enable(void);
-static void tx_callback(void);
-static void rx_callback(uint32_t buf_addr, uint32_t buf_len);
+static void tx_callback(void *ctx);
+static void tx_pkt_callback(void *ctx, void *cookie, uint32_t bytes, uint32_t sts);
+static void rx_callback(void *ctx, uint32_t buf_addr, uint32_t buf_len);
+static void rx_pkt_callback(void *ctx, const struct axisDmaCtrl_pkt *pkt);
+static void rx_block_callback(void *ctx, uint32_t buf_addr, uint32_t buf_len, uint16_t flags);
+static void tx_lost_callback(void *ctx, uint32_t buf_addr, uint32_t buf_len);
+static void tx_flow_callback(void *ctx, int stop);
+static void stall_callback(void *ctx, int chan, uint32_t sr);
+static void cyclic_consume(void);
+static void print_ring_stats(const char *name, const struct axisDmaCtrl_ringStats *st);
+static int check_trace(void);
+#ifdef AXISDMA_ENABLE_LATENCY
+static void print_latency(void);
+#endif
 
-int axis_dma_controller_sample_exec(int numTestPkts, int pktSize, int bufSize)
+int axis_dma_controller_sample_exec(int numTestPkts, int pktSize, int bufSize, int flags)
 {
 	int rc;
 	struct axisDmaCtrl_params params;
+	struct axisDmaCtrl_stats stats;
+	struct axisDmaCtrl_txPrep txPrep;
     int old_tx_bd_count;
+	int txPkts = 0;
+	int bdsPerPkt;
+	int injected = 0;
+	int recoverNow = 0;
+	int recoveries = 0;
+	int expectErrs = 0;
+	int expectStalls = 0;
 	int i;
 
-	printf("%s : Starting w/ %d packets of %d bytes using buffers of %d bytes\r\n",
-		__func__,numTestPkts, pktSize, bufSize);
+	printf("%s : Starting w/ %d packets of %d bytes using buffers of %d bytes%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s\r\n",
+		__func__,numTestPkts, pktSize, bufSize,
+		(flags & SAMPLE_RX_DEFERRED) ? " (deferred rx)" : "",
+		(flags & SAMPLE_RX_LEND) ? " (lent rx buffers)" : "",
+		(flags & SAMPLE_TX_POOL) ? " (tx pool)" : "",
+		(flags & SAMPLE_TX_IOV) ? " (tx gather)" : "",
+		(flags & SAMPLE_COALESCE_ADAPT) ? " (adaptive coalescing)" : "",
+		(flags & SAMPLE_RX_NAPI) ? " (napi rx)" : "",
+		(flags & SAMPLE_RX_BUSYPOLL) ? " (busy poll rx)" : "",
+		(flags & SAMPLE_RX_REFILL) ? " (incremental rx refill)" : "",
+		(flags & SAMPLE_RX_CYCLIC) ? " (cyclic rx)" : "",
+		(flags & SAMPLE_RX_BLOCK) ? " (block rx)" : "",
+		(flags & SAMPLE_TRACE) ? " (event trace)" : "",
+		(flags & SAMPLE_RECOVER) ? " (error recovery)" : "",
+		(flags & SAMPLE_STALL) ? " (stall watchdog)" : "",
+		(flags & SAMPLE_TX_PKT_CB) ? " (packet tx callback)" : "",
+		(flags & SAMPLE_TX_QUEUE) ? " (tx queue)" : "",
+		(flags & SAMPLE_TX_PRIO) ? ((flags & SAMPLE_TX_WEIGHTED) ?
+			" (weighted tx priorities)" : " (strict tx priorities)") : "",
+		(flags & SAMPLE_TX_PREPARED) ? " (prepared tx)" : "",
+		(flags & SAMPLE_RX_BUDGET) ? " (budgeted rx poll)" : "",
+		(flags & SAMPLE_RECOVER_EOF) ? " (failed eof bd)" : "");
+	if (flags & SAMPLE_TX_PRIO)
+		flags |= SAMPLE_TX_PKT_CB;
 
 	BD_BUF_SIZE  = bufSize;
 	MAX_PKT_SIZE = pktSize;
+	bdsPerPkt    = (pktSize + bufSize - 1) / bufSize;
+	if (flags & SAMPLE_TX_IOV)
+		bdsPerPkt = (HDR_SIZE + bufSize - 1) / bufSize +
+			(pktSize - HDR_SIZE + bufSize - 1) / bufSize;
 
 	params.rx_bd_space_base = MEM_BASE_ADDR;
 	params.rx_bd_space_high = params.rx_bd_space_base + MEM_REGION_BD_SIZE;
@@ -53,6 +180,7 @@ int axis_dma_controller_sample_exec(int numTestPkts, int pktSize, int bufSize)
 	params.rx_buffer_base   = params.tx_buffer_high + 1;
 	params.rx_buffer_high   = params.rx_buffer_base + MEM_REGION_BUF_SIZE;
 	params.bd_buf_size      = BD_BUF_SIZE;
+	params.tx_block_size    = (flags & SAMPLE_TX_POOL) ? MAX_PKT_SIZE : 0;
 	params.coalesce_count   = 1;
 	params.txIrqPriority    = 0xA0;
 	params.rxIrqPriority    = 0xA0;
@@ -61,6 +189,33 @@ int axis_dma_controller_sample_exec(int numTestPkts, int pktSize, int bufSize)
 	params.dmaDevId         = DMA_DEV_ID;
 	params.txEn             = 1;
 	params.rxEn             = 1;
+	params.cacheable_bufs   = 0;
+	params.rx_deferred      = (flags & SAMPLE_RX_DEFERRED) ? 1 : 0;
+	params.rx_lend          = (flags & SAMPLE_RX_LEND) ? 1 : 0;
+	params.rx_mode          = (flags & SAMPLE_RX_NAPI) ? AXISDMA_RX_MODE_NAPI :
+		(flags & SAMPLE_RX_BUSYPOLL) ? AXISDMA_RX_MODE_BUSYPOLL : AXISDMA_RX_MODE_IRQ;
+	params.rx_refill_watermark = (flags & SAMPLE_RX_REFILL) ? RX_REFILL_WATERMARK : 0;
+	params.rx_cyclic        = (flags & SAMPLE_RX_CYCLIC) ? 1 : 0;
+	params.rx_block_size    = (flags & SAMPLE_RX_BLOCK) ?
+		(MEM_REGION_BUF_SIZE + 1) / RX_BLOCKS / BD_BUF_SIZE * BD_BUF_SIZE : 0;
+	params.rx_block_timeout_us = (flags & SAMPLE_RX_BLOCK) ? RX_BLOCK_TIMEOUT_US : 0;
+	params.stall_timeout_us = STALL_TIMEOUT_US;
+	params.stall_recover    = (flags & SAMPLE_STALL) ? 1 : 0;
+	params.tx_queue_depth   = (flags & (SAMPLE_TX_QUEUE | SAMPLE_TX_PRIO)) ? TX_QUEUE_DEPTH : 0;
+	params.tx_queue_high    = (flags & (SAMPLE_TX_QUEUE | SAMPLE_TX_PRIO)) ? TX_QUEUE_HIGH : 0;
+	params.tx_queue_low     = (flags & (SAMPLE_TX_QUEUE | SAMPLE_TX_PRIO)) ? TX_QUEUE_LOW : 0;
+	params.tx_sched         = (flags & SAMPLE_TX_WEIGHTED) ? AXISDMA_TX_SCHED_WEIGHTED : AXISDMA_TX_SCHED_STRICT;
+	/* lower bulk priorities get fewer turns */
+	for(i = 0; i < AXISDMA_TXQ_PRIOS; i++)
+		params.tx_weight[i] = i ? 1 << (AXISDMA_TXQ_PRIOS - 1 - i) : 0;
+	params.tx_bulk_max_bds  = (flags & SAMPLE_TX_PRIO) ? TX_BULK_MAX_BDS : 0;
+	memset(&params.tx_coalesce, 0, sizeof(params.tx_coalesce));
+	if (flags & SAMPLE_COALESCE_ADAPT) {
+		params.tx_coalesce.adaptive  = 1;
+		params.tx_coalesce.min_count = 1;
+		params.tx_coalesce.max_count = 64;
+	}
+	params.rx_coalesce      = params.tx_coalesce;
 
 	axisDmaCtrl_printParams(&params);
 
@@ -69,52 +224,237 @@ int axis_dma_controller_sample_exec(int numTestPkts, int pktSize, int bufSize)
 	rx_bd_count     = 0;
 	rx_pkt_count    = 0;
 	error           = 0;
-	pkt_complete    = 1;
-	pkt_bytes_rx    = 0;
+	lentHead        = 0;
+	lentTail        = 0;
+	lend            = params.rx_lend;
+	cycIdx          = 0;
+	memset(&cycPkt, 0, sizeof(cycPkt));
+	blkBytes        = 0;
+	blkPartial      = 0;
+	txLost          = 0;
+	txLostAddr      = (flags & (SAMPLE_TX_POOL | SAMPLE_TX_IOV)) ? 0 : (uint32_t)(UINTPTR)txPkt;
+	txPktDone       = 0;
+	txPktFailed     = 0;
+	txRecBulk       = 0;
+	memset(txPrioSent, 0, sizeof(txPrioSent));
+	memset(txPrioDone, 0, sizeof(txPrioDone));
+	txFlowStopped   = 0;
+	txFlowStops     = 0;
 
 	for(i=0; i<MAX_PKT_SIZE; i++)
 		txPkt[i] = i % 255;
+	memcpy(txHdr, txPkt, HDR_SIZE);
 
 	rc = gic_init();
 	if (rc)
 		return -1;
 
 	/* DMA Setup */
-	rc = axisDmaCtrl_init(&params, &intc, rx_callback, tx_callback);
-	if(rc){
+	dma = axisDmaCtrl_init(&params, &intc, rx_callback, tx_callback, NULL);
+	if(dma == NULL){
 		printf("axisDmaCtrl_init failed!\r\n");
 		return XST_FAILURE;
 	}
+	if (flags & SAMPLE_RX_BLOCK)
+		axisDmaCtrl_register_rx_block_cb(dma, rx_block_callback);
+	else
+		axisDmaCtrl_register_rx_pkt_cb(dma, rx_pkt_callback, NULL, 0);
+
+	if (flags & SAMPLE_TRACE)
+		axisDmaCtrl_traceEnable(dma, 1);
+	axisDmaCtrl_register_tx_lost_cb(dma, tx_lost_callback);
+	if (flags & SAMPLE_TX_PKT_CB)
+		axisDmaCtrl_register_tx_pkt_cb(dma, tx_pkt_callback);
+	axisDmaCtrl_register_tx_flow_cb(dma, tx_flow_callback);
+	axisDmaCtrl_register_stall_cb(dma, stall_callback);
+	/* the packet never changes, one layout and one flush cover every send */
+	if (flags & SAMPLE_TX_PREPARED) {
+		if (axisDmaCtrl_txPrepare(dma, &txPrep, MAX_PKT_SIZE) != XST_SUCCESS) {
+			printf("axisDmaCtrl_txPrepare failed!\r\n");
+			return XST_FAILURE;
+		}
+		Xil_DCacheFlushRange((UINTPTR)txPkt, MAX_PKT_SIZE);
+	}
 
 	gic_enable();
 
     int printCount = 0;
 	while(rx_pkt_count < numTestPkts){ 
-        if(axisDmaCtrl_getAvailTxBds() > 5) {
-            rc = axisDmaCtrl_sendPackets(&txPkt, MAX_PKT_SIZE);
+        if(flags & SAMPLE_RX_DEFERRED)
+            axisDmaCtrl_rxPoll(dma, (flags & SAMPLE_RX_BUDGET) ? RX_DEFERRED_BUDGET : 0);
+        else if(flags & (SAMPLE_RX_NAPI | SAMPLE_RX_BUSYPOLL))
+            axisDmaCtrl_rxPoll(dma, RX_POLL_BUDGET);
+        else if(flags & SAMPLE_RX_CYCLIC)
+            cyclic_consume();
+        else if(flags & SAMPLE_RX_BLOCK)
+            axisDmaCtrl_rxPoll(dma, 0);
+        while(lentHead != lentTail){
+            uint32_t addr = lentBufs[lentHead % LENT_MAX];
+            memset((void *)(UINTPTR)addr, 0, BD_BUF_SIZE);
+            if(axisDmaCtrl_rxRelease(dma, addr))
+                error = 1;
+            /* the first buffer back is released once more, which has to fail */
+            if(lentHead == 0 && axisDmaCtrl_rxRelease(dma, addr) != XST_INVALID_PARAM)
+                error = 1;
+            lentHead++;
+        }
+        if((flags & (SAMPLE_RECOVER | SAMPLE_STALL)) && !injected && txPkts == numTestPkts / 2){
+            injected = 1;
+            if(flags & SAMPLE_STALL){
+#ifdef SAMPLE_SIM
+                /* tx completions go unnoticed from here, more irqs than the ring holds bds */
+                simAxiDma_dropIrqs(DMA_DEV_ID, XAXIDMA_DMA_TO_DEVICE, numTestPkts);
+                expectStalls = 1;
+#endif
+            } else {
+#ifdef SAMPLE_SIM
+                if(flags & SAMPLE_RECOVER_EOF)
+                    simAxiDma_injectTxEofError(DMA_DEV_ID, XAXIDMA_BD_STS_SLV_ERR_MASK);
+                else
+                    simAxiDma_injectBdError(DMA_DEV_ID, XAXIDMA_DMA_TO_DEVICE, XAXIDMA_BD_STS_SLV_ERR_MASK);
+                expectErrs = 1;
+#else
+                /* nothing provokes an error on hardware, recover with traffic in flight */
+                recoverNow = 1;
+#endif
+            }
+        }
+        /* the watchdog recovers by itself with SAMPLE_STALL, any other stall is fatal */
+        if(axisDmaCtrl_watchdog(dma) && !(flags & SAMPLE_STALL)){
+            error = 1;
+            break;
+        }
+        /* the weighted run lets the bulk queues back up behind the halted
+         * engine first, the scheduler then picks among all of them */
+        if((axisDmaCtrl_errorPending(dma) &&
+            (!(flags & SAMPLE_TX_WEIGHTED) || txFlowStopped || txPkts == numTestPkts)) || recoverNow){
+            struct axisDmaCtrl_recovery rec;
+
+            recoverNow = 0;
+            if(axisDmaCtrl_recover(dma, &rec)){
+                printf("ERROR : recovery failed\r\n");
+                error = 1;
+                break;
+            }
+            recoveries++;
+            printf("recovered in %u us : %u tx packets (%u bds) lost, %u rx bds drained, %u dropped\r\n",
+                (unsigned int)rec.time_us,(unsigned int)rec.tx_lost_pkts,(unsigned int)rec.tx_lost_bds,
+                (unsigned int)rec.rx_drained_bds,(unsigned int)rec.rx_dropped_bds);
+            if((int)rec.tx_lost_pkts != txLost || (expectErrs && txLost == 0) ||
+                rec.tx_lost_bds != rec.tx_lost_pkts * bdsPerPkt)
+                error = 1;
+        }
+        /* with the tx queue the ring is never polled, the flow callback throttles */
+        if(((flags & (SAMPLE_TX_QUEUE | SAMPLE_TX_PRIO)) ? !txFlowStopped : axisDmaCtrl_getAvailTxBds(dma) >= bdsPerPkt) &&
+            (!(flags & SAMPLE_RX_CYCLIC) || txPkts - rx_pkt_count < CYCLIC_MAX_INFLIGHT)) {
+            if(flags & SAMPLE_TX_POOL) {
+                uint8_t *blk = axisDmaCtrl_txBufGet(dma);
+                rc = 0;
+                if(blk) {
+                    memcpy(blk, txPkt, MAX_PKT_SIZE);
+                    rc = axisDmaCtrl_txBufSubmit(dma, blk, MAX_PKT_SIZE);
+                    if(rc)
+                        axisDmaCtrl_txBufPut(dma, blk);
+                }
+            } else if(flags & SAMPLE_TX_IOV) {
+                struct axisDmaCtrl_iovec iov[2] = {
+                    { txHdr, HDR_SIZE },
+                    { txPkt + HDR_SIZE, MAX_PKT_SIZE - HDR_SIZE },
+                };
+                rc = axisDmaCtrl_sendPacketIov(dma, iov, 2);
+            } else if(flags & SAMPLE_TX_PRIO) {
+                int prio = (txPkts % TX_CTRL_EVERY) ? 1 + txPkts % (AXISDMA_TXQ_PRIOS - 1) : 0;
+
+                rc = axisDmaCtrl_sendPacketPrio(dma, txPkt, MAX_PKT_SIZE,
+                    TX_COOKIE(prio, txPrioSent[prio] + 1), prio);
+                if(!rc)
+                    txPrioSent[prio]++;
+            } else if(flags & SAMPLE_TX_PREPARED) {
+                rc = axisDmaCtrl_sendPrepared(dma, &txPrep, txPkt, TX_COOKIE(0, txPrioSent[0] + 1));
+                if(!rc)
+                    txPrioSent[0]++;
+            } else if(flags & SAMPLE_TX_PKT_CB) {
+                rc = axisDmaCtrl_sendPacketCookie(dma, txPkt, MAX_PKT_SIZE, TX_COOKIE(0, txPrioSent[0] + 1));
+                if(!rc)
+                    txPrioSent[0]++;
+            } else {
+                rc = axisDmaCtrl_sendPackets(dma, txPkt, MAX_PKT_SIZE);
+            }
             if (rc)
                 printf("ERROR SENDING PACKET\n\r");
+            else
+                txPkts++;
         }
         if(tx_bd_count != old_tx_bd_count){
             old_tx_bd_count = tx_bd_count;
             if(printCount++ % 10000 == 0)
                 printf("tx : %d (avail %d) rx : %d (avail %d)\n\r",
                         tx_bd_count,
-                        axisDmaCtrl_getAvailTxBds(),
+                        axisDmaCtrl_getAvailTxBds(dma),
                         rx_bd_count,
-                        axisDmaCtrl_getAvailRxBds());
+                        axisDmaCtrl_getAvailRxBds(dma));
         }
     }
 
+	/* the last tx completions may still be on their way */
+	while((flags & SAMPLE_TX_PKT_CB) && !error && txPktDone != txPkts)
+		if(axisDmaCtrl_watchdog(dma))
+			error = 1;
+
 	printf("Done!\r\n");
 	printf("tx_bds : %d, rx_bds %d, rx_packets %d\r\n",tx_bd_count,rx_bd_count,rx_pkt_count);
+	if (flags & SAMPLE_COALESCE_ADAPT)
+		printf("coalesce : tx %d, rx %d\r\n",
+			axisDmaCtrl_getTxCoalesce(dma),axisDmaCtrl_getRxCoalesce(dma));
+	if (flags & SAMPLE_RX_BLOCK)
+		printf("blocks : %u bytes, %d partial\r\n",(unsigned int)blkBytes,blkPartial);
+	axisDmaCtrl_getStats(dma, &stats, 0);
+	print_ring_stats("tx", &stats.tx);
+	print_ring_stats("rx", &stats.rx);
+#ifdef AXISDMA_ENABLE_LATENCY
+	print_latency();
+#endif
+	if ((flags & SAMPLE_TRACE) && check_trace())
+		error = 1;
+	if (flags & SAMPLE_TX_QUEUE) {
+		printf("tx queue : stopped %d times, %d queued\r\n",txFlowStops,axisDmaCtrl_getTxQueued(dma));
+		if (txFlowStops == 0)
+			error = 1;
+	}
+	if (flags & SAMPLE_TX_PKT_CB) {
+		printf("tx packet callbacks : %d, %d failed, per priority",txPktDone,txPktFailed);
+		for (i = 0; i < AXISDMA_TXQ_PRIOS; i++)
+			printf(" %d",txPrioDone[i]);
+		printf("\r\n");
+		if (txPktDone != txPkts || txPktFailed != txLost || tx_bd_count != 0)
+			error = 1;
+		if ((flags & SAMPLE_TX_WEIGHTED) && expectErrs && txRecBulk != 1) {
+			printf("ERROR : priority %d went first after the recovery\r\n",txRecBulk);
+			error = 1;
+		}
+	}
+	if ((flags & SAMPLE_STALL) &&
+		(stats.tx.stalls != expectStalls || stats.tx.resets != expectStalls || stats.rx.stalls != 0))
+		error = 1;
+	if (flags & SAMPLE_RECOVER) {
+		/* exactly the injected error, everything else has to stay clean */
+		if (recoveries != 1 || stats.tx.resets != 1 || stats.rx.resets != 1 ||
+			stats.tx.err_irqs != expectErrs || stats.tx.err_slave != expectErrs)
+			error = 1;
+		stats.tx.err_irqs  -= expectErrs;
+		stats.tx.err_slave -= expectErrs;
+	}
+	if(stats.tx.err_irqs || stats.rx.err_irqs ||
+		stats.tx.err_internal + stats.tx.err_slave + stats.tx.err_decode ||
+		stats.rx.err_internal + stats.rx.err_slave + stats.rx.err_decode)
+		error = 1;
 	if(error){
 		printf("!! Test Failed w/ error !!\r\n");
 		return XST_FAILURE;
 	}
 	printf("Test successful\r\n\n");
 
-	axisDmaCtrl_disable(&intc);
+	axisDmaCtrl_disable(dma);
 
 	return XST_SUCCESS;
 }
@@ -150,52 +490,234 @@ static void gic_enable(void)
 	Xil_ExceptionEnable();
 }
 
-static void tx_callback(void)
+static void tx_callback(void *ctx)
 {
 	tx_bd_count++;
 }
 
-static void rx_callback(uint32_t buf_addr, uint32_t buf_len)
+/* cookies count up from 1 in submission order within their priority, lost
+ * packets are expected after a recovery only */
+static void tx_pkt_callback(void *ctx, void *cookie, uint32_t bytes, uint32_t sts)
 {
-	int j = 0;
-	uint8_t *rxPacket;
+	int ok = (sts & XAXIDMA_BD_STS_COMPLETE_MASK) && !(sts & XAXIDMA_BD_STS_ALL_ERR_MASK);
+	int prio = ((UINTPTR)cookie >> 24) % AXISDMA_TXQ_PRIOS;
 
-	// printf("pkt_complete : %s, pkt_bytes_rx : %d, buf_len : %d\r\n",pkt_complete?"T":"F", (int)pkt_bytes_rx, (int)buf_len);
+	if (cookie != TX_COOKIE(prio, txPrioDone[prio] + 1) || (ok && bytes != MAX_PKT_SIZE)) {
+		printf("%s ERROR : cookie 0x%x, expected %d in priority %d, %u bytes, sts 0x%x\r\n",__func__,
+			(unsigned int)(UINTPTR)cookie,txPrioDone[prio] + 1,prio,(unsigned int)bytes,(unsigned int)sts);
+		error = 1;
+	}
+	txPrioDone[prio]++;
+	if (ok && prio && txRecBulk < 0)
+		txRecBulk = prio;
+	if (!ok)
+		txPktFailed++;
+	txPktDone++;
+}
 
-	rxPacket = (u8 *)buf_addr;
+/* reads the bds the cyclic ring filled since the last call, packets are
+ * rebuilt from the bd lengths as every test packet has the same size */
+static void cyclic_consume(void)
+{
+	uint32_t prod = axisDmaCtrl_rxCyclicProducer(dma);
+	struct axisDmaCtrl_frag frag;
 
-	if (pkt_complete){
-		/* check data */
-		for(j = 0; j < buf_len; j++){
-			if(*(rxPacket+j) != txPkt[j]){
-				printf("%s ERROR : pkt %d : tx[%04d]=%03d, rx[%04d]=%03d @ 0x%x\r\n",
-					__func__,rx_bd_count,j,txPkt[j],j,*(rxPacket+j),(unsigned int)(rxPacket+j));
-				error = 1;
-				break;
-			}
+	while(cycIdx != prod){
+		if(axisDmaCtrl_rxCyclicGet(dma, cycIdx, &frag) != XST_SUCCESS){
+			printf("%s ERROR : overrun @ %u\r\n",__func__,(unsigned int)cycIdx);
+			error = 1;
+			cycIdx = axisDmaCtrl_rxCyclicOldest(dma);
+			memset(&cycPkt, 0, sizeof(cycPkt));
+			return;
+		}
+		if(cycPkt.nfrags < AXISDMA_RX_PKT_MAX_FRAGS)
+			cycPkt.frags[cycPkt.nfrags++] = frag;
+		cycPkt.pkt_len += frag.buf_len;
+		cycIdx++;
+		if(cycPkt.pkt_len >= MAX_PKT_SIZE){
+			rx_pkt_callback(NULL, &cycPkt);
+			memset(&cycPkt, 0, sizeof(cycPkt));
 		}
-	} else {
-		int txOffset = pkt_bytes_rx;
+	}
+}
+
+static void rx_callback(void *ctx, uint32_t buf_addr, uint32_t buf_len)
+{
+	/* packet mode is registered right after init, nothing should land here */
+	printf("%s ERROR : unexpected bd @ 0x%x\r\n",__func__,(unsigned int)buf_addr);
+	error = 1;
+}
+
+static void rx_pkt_callback(void *ctx, const struct axisDmaCtrl_pkt *pkt)
+{
+	int i, j;
+	int txOffset = 0;
+	uint8_t *rxPacket;
+
+	if (pkt->flags || pkt->pkt_len != MAX_PKT_SIZE) {
+		printf("%s ERROR : pkt %d : len %d flags 0x%x\r\n",
+			__func__,rx_pkt_count,(int)pkt->pkt_len,pkt->flags);
+		error = 1;
+	}
+
+	for(i = 0; i < pkt->nfrags && !error; i++){
+		rxPacket = (u8 *)(UINTPTR)pkt->frags[i].buf_addr;
 		/* check data */
-		for(j = 0; j < buf_len; j++){
+		for(j = 0; j < pkt->frags[i].buf_len; j++){
 			if(*(rxPacket+j) != txPkt[j+txOffset]){
-				 printf("%s ERROR : pkt %d : tx[%04d]=%03d, rx[%04d]=%03d @ 0x%x\r\n",
-					 __func__,rx_bd_count,j+txOffset,txPkt[j+txOffset],j,*(rxPacket+j),(unsigned int)(rxPacket+j));
+				printf("%s ERROR : pkt %d : tx[%04d]=%03d, rx[%04d]=%03d @ 0x%x\r\n",
+					__func__,rx_pkt_count,j+txOffset,txPkt[j+txOffset],j,*(rxPacket+j),(unsigned int)(UINTPTR)(rxPacket+j));
 				error = 1;
 				break;
 			}
 		}
+		txOffset += pkt->frags[i].buf_len;
+		if(!lend)
+			memset(rxPacket, 0, pkt->frags[i].buf_len);
+	}
+
+	/* keep the buffers until the main loop gets around to them */
+	for(i = 0; lend && i < pkt->nfrags; i++)
+		lentBufs[lentTail++ % LENT_MAX] = pkt->frags[i].buf_addr;
+
+	rx_bd_count += pkt->nfrags;
+	rx_pkt_count++;
+}
+
+/* blocks carry the packets back to back and rarely end on a packet
+ * boundary, the data is checked against the running stream offset */
+static void rx_block_callback(void *ctx, uint32_t buf_addr, uint32_t buf_len, uint16_t flags)
+{
+	uint8_t *rxData = (uint8_t *)(UINTPTR)buf_addr;
+	uint32_t j;
+
+	if (flags & AXISDMA_BLK_GAP) {
+		printf("%s ERROR : gap in block @ 0x%x\r\n",__func__,(unsigned int)buf_addr);
+		error = 1;
+	}
+	if (flags & AXISDMA_BLK_PARTIAL)
+		blkPartial++;
+
+	for(j = 0; j < buf_len && !error; j++){
+		uint32_t txOffset = (blkBytes + j) % MAX_PKT_SIZE;
+
+		if(rxData[j] != txPkt[txOffset]){
+			printf("%s ERROR : byte %u : tx[%04u]=%03d, rx=%03d @ 0x%x\r\n",
+				__func__,(unsigned int)(blkBytes + j),(unsigned int)txOffset,
+				txPkt[txOffset],rxData[j],(unsigned int)(UINTPTR)(rxData+j));
+			error = 1;
+		}
+	}
+	memset(rxData, 0, buf_len);
+
+	blkBytes += buf_len;
+	rx_bd_count += (buf_len + BD_BUF_SIZE - 1) / BD_BUF_SIZE;
+	rx_pkt_count = blkBytes / MAX_PKT_SIZE;
+}
+
+static void tx_lost_callback(void *ctx, uint32_t buf_addr, uint32_t buf_len)
+{
+	if (buf_len != MAX_PKT_SIZE || (txLostAddr && buf_addr != txLostAddr)) {
+		printf("%s ERROR : lost %u bytes @ 0x%x\r\n",__func__,(unsigned int)buf_len,(unsigned int)buf_addr);
+		error = 1;
+	}
+	txLost++;
+	txRecBulk = -1;
+}
+
+static void tx_flow_callback(void *ctx, int stop)
+{
+	if (stop == txFlowStopped) {
+		printf("%s ERROR : %s twice\r\n",__func__,stop ? "stop" : "resume");
+		error = 1;
+	}
+	txFlowStopped = stop;
+	txFlowStops += stop;
+}
+
+static void stall_callback(void *ctx, int chan, uint32_t sr)
+{
+	printf("%s : %s stalled, sr 0x%x\r\n",__func__,
+		chan == AXISDMA_ERR_TX ? "tx" : "rx",(unsigned int)sr);
+}
+
+static void print_ring_stats(const char *name, const struct axisDmaCtrl_ringStats *st)
+{
+	printf("%s stats : %llu bytes, %u pkts, %u bds, %u irqs (%u bds/irq, max %u), "
+		"%u nobds, errs %u/%u/%u, %u err irqs, %u resets, %u stalls, hw bds %u..%u\r\n",
+		name,(unsigned long long)st->bytes,(unsigned int)st->pkts,(unsigned int)st->bds,
+		(unsigned int)st->irqs,st->irqs ? (unsigned int)(st->bds / st->irqs) : 0,
+		(unsigned int)st->irq_bds_max,(unsigned int)st->nobds,
+		(unsigned int)st->err_internal,(unsigned int)st->err_slave,(unsigned int)st->err_decode,
+		(unsigned int)st->err_irqs,(unsigned int)st->resets,(unsigned int)st->stalls,
+		(unsigned int)st->hw_low,(unsigned int)st->hw_high);
+}
+
+#ifdef AXISDMA_ENABLE_LATENCY
+/* per stage min/avg/max in ns and the occupied log2 histogram bins */
+static void print_latency(void)
+{
+	static const char *names[AXISDMA_LAT_STAGES] = { "tx isr", "rx isr", "tx cb", "rx cb", "rx recycle" };
+	struct axisDmaCtrl_latency lat;
+	int i, b;
+
+	axisDmaCtrl_getLatency(dma, &lat, 1);
+	for(i = 0; i < AXISDMA_LAT_STAGES; i++){
+		const struct axisDmaCtrl_latStage *st = &lat.stage[i];
+
+		if(st->count == 0)
+			continue;
+		printf("%-10s : %u samples, min %llu avg %llu max %llu ns, log2 hist",
+			names[i],(unsigned int)st->count,
+			(unsigned long long)st->min * 1000000000ULL / COUNTS_PER_SECOND,
+			(unsigned long long)(st->total / st->count) * 1000000000ULL / COUNTS_PER_SECOND,
+			(unsigned long long)st->max * 1000000000ULL / COUNTS_PER_SECOND);
+		for(b = 0; b < AXISDMA_LAT_HIST_BINS; b++)
+			if(st->hist[b])
+				printf(" [%d]=%u",b,(unsigned int)st->hist[b]);
+		printf("\r\n");
 	}
+}
+#endif
+
+/* dumps the trace, checks it is in sequence and saw both channels complete,
+ * then saves it for the host decoder when built with SAMPLE_TRACE_FILE */
+static int check_trace(void)
+{
+	const struct axisDmaCtrl_traceHdr *hdr = (const struct axisDmaCtrl_traceHdr *)traceDump;
+	const struct axisDmaCtrl_traceEvt *evt = (const struct axisDmaCtrl_traceEvt *)(hdr + 1);
+	uint32_t size;
+	int done[2] = { 0, 0 };
+	uint32_t i;
 
-	pkt_bytes_rx += buf_len;
-	if(error || pkt_bytes_rx >= MAX_PKT_SIZE){
-		pkt_complete = 1;
-		pkt_bytes_rx = 0;
-		rx_pkt_count++;
-	} else {
-		pkt_complete = 0;
+	axisDmaCtrl_traceEnable(dma, 0);
+	size = axisDmaCtrl_traceDump(dma, traceDump, sizeof(traceDump));
+	if (size == 0 || hdr->magic != AXISDMA_TRACE_MAGIC || hdr->count == 0) {
+		printf("%s ERROR : empty trace\r\n",__func__);
+		return -1;
+	}
+	for (i = 0; i < hdr->count; i++) {
+		if (evt[i].seq != hdr->head - hdr->count + i + 1) {
+			printf("%s ERROR : event %u out of sequence\r\n",__func__,(unsigned int)i);
+			return -1;
+		}
+		if (evt[i].type == AXISDMA_TRACE_COMPLETE)
+			done[evt[i].chan]++;
 	}
+	printf("trace : %u events of %u, %d tx / %d rx completions\r\n",
+		(unsigned int)hdr->count,(unsigned int)hdr->head,done[0],done[1]);
+	if (!done[0] || !done[1])
+		return -1;
+
+#ifdef SAMPLE_TRACE_FILE
+	{
+		FILE *f = fopen(SAMPLE_TRACE_FILE, "wb");
 
-	memset((void *)buf_addr, 0, buf_len);
-	rx_bd_count++;
+		if (f != NULL) {
+			fwrite(traceDump, 1, size, f);
+			fclose(f);
+		}
+	}
+#endif
+	return 0;
 }
@@ -1,6 +1,27 @@
 #ifndef AXIS_DMA_CONTROLLER_SAMPLE_EXEC_H
 #define AXIS_DMA_CONTROLLER_SAMPLE_EXEC_H
 
-int axis_dma_controller_sample_exec(int numTestPkts, int pktSize, int bufSize);
+#define SAMPLE_RX_DEFERRED 0x1 /**< process rx from the main loop through axisDmaCtrl_rxPoll */
+#define SAMPLE_RX_LEND     0x2 /**< hold rx buffers past the callback, the main loop releases them */
+#define SAMPLE_TX_POOL     0x4 /**< build tx packets in blocks of the controller tx buffer pool */
+#define SAMPLE_TX_IOV      0x8 /**< send a separate header and the payload as one gathered packet */
+#define SAMPLE_COALESCE_ADAPT 0x10 /**< let both rings retune their coalesce threshold at runtime */
+#define SAMPLE_RX_NAPI     0x20 /**< rx irq switches the ring to polling from the main loop until it runs dry */
+#define SAMPLE_RX_BUSYPOLL 0x40 /**< rx completions are only ever polled from the main loop */
+#define SAMPLE_RX_REFILL   0x80 /**< hand consumed rx bds back to hardware in small batches */
+#define SAMPLE_RX_CYCLIC   0x100 /**< rx ring runs cyclic, the main loop reads it behind the producer index */
+#define SAMPLE_RX_BLOCK    0x200 /**< rx lands back to back in large blocks, one callback per block */
+#define SAMPLE_TRACE       0x400 /**< record the dma event trace and check the dump */
+#define SAMPLE_RECOVER     0x800 /**< fail a tx bd half way (host sim) and bring the engine back with axisDmaCtrl_recover */
+#define SAMPLE_STALL       0x1000 /**< lose the tx irqs half way (host sim), the watchdog has to notice and recover */
+#define SAMPLE_TX_PKT_CB   0x2000 /**< one tx callback per packet, packets carry their sequence number as cookie */
+#define SAMPLE_TX_QUEUE    0x4000 /**< submit into the tx software queue until the flow callback says stop */
+#define SAMPLE_TX_PRIO     0x8000 /**< mix control (priority 0) and bulk packets over the tx queues, implies the packet tx callback */
+#define SAMPLE_TX_WEIGHTED 0x10000 /**< with SAMPLE_TX_PRIO, bulk priorities take weighted turns instead of strict order */
+#define SAMPLE_TX_PREPARED 0x20000 /**< send every packet through one axisDmaCtrl_txPrepare layout */
+#define SAMPLE_RX_BUDGET   0x40000 /**< with SAMPLE_RX_DEFERRED, poll the queue with a budget of fewer bds than a packet */
+#define SAMPLE_RECOVER_EOF 0x80000 /**< with SAMPLE_RECOVER, the failed tx bd is the last one of a multi bd packet */
+
+int axis_dma_controller_sample_exec(int numTestPkts, int pktSize, int bufSize, int flags);
 
 #endif // AXIS_DMA_CONTROLLER_SAMPLE_EXEC_H
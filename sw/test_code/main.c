@@ -2,17 +2,72 @@
 #include "platform.h"
 #include "xil_printf.h"
 #include "axis_dma_controller_sample_exec.h"
+#include "axis_dma_controller_bench.h"
+
+//#define AXISDMA_RUN_BENCH /**< Define to run the benchmark sweep instead of the sample exec */
 
 int main()
 {
+    int rc = 0;
+
     init_platform();
 
     xil_printf("\n\n\rStarting DMA Testing...\n\r");
 
-    axis_dma_controller_sample_exec(1000, 20, 20);
-    axis_dma_controller_sample_exec(1020, 99, 24);
-    axis_dma_controller_sample_exec(1200, 2080, 38);
+#ifdef AXISDMA_RUN_BENCH
+    rc |= axis_dma_controller_bench();
+#elif defined(AXISDMA_STATIC_BD_BUF_SIZE)
+    /* a static geometry build only takes the bd_buf_size it was compiled for */
+    rc |= axis_dma_controller_sample_exec(1000, 20, AXISDMA_STATIC_BD_BUF_SIZE, 0);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, AXISDMA_STATIC_BD_BUF_SIZE, 0);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, AXISDMA_STATIC_BD_BUF_SIZE, SAMPLE_RX_DEFERRED | SAMPLE_RX_LEND);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, AXISDMA_STATIC_BD_BUF_SIZE, SAMPLE_TX_IOV);
+    rc |= axis_dma_controller_sample_exec(1000, 20, AXISDMA_STATIC_BD_BUF_SIZE, SAMPLE_RX_CYCLIC);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, AXISDMA_STATIC_BD_BUF_SIZE, SAMPLE_TX_PRIO | SAMPLE_RECOVER);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, AXISDMA_STATIC_BD_BUF_SIZE, SAMPLE_TX_PREPARED | SAMPLE_TX_PKT_CB);
+#else
+    rc |= axis_dma_controller_sample_exec(1000, 20, 20, 0);
+    rc |= axis_dma_controller_sample_exec(1020, 99, 24, 0);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, 0);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_RX_DEFERRED);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_RX_LEND);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_RX_DEFERRED | SAMPLE_RX_LEND);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_RX_DEFERRED | SAMPLE_RX_BUDGET);
+    rc |= axis_dma_controller_sample_exec(1020, 99, 24, SAMPLE_TX_POOL);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_TX_POOL | SAMPLE_RX_LEND);
+    rc |= axis_dma_controller_sample_exec(1000, 20, 20, SAMPLE_TX_IOV);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_TX_IOV);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_COALESCE_ADAPT);
+    rc |= axis_dma_controller_sample_exec(1000, 20, 20, SAMPLE_RX_NAPI);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_RX_NAPI | SAMPLE_RX_LEND);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_RX_BUSYPOLL);
+    rc |= axis_dma_controller_sample_exec(1020, 99, 24, SAMPLE_RX_REFILL);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_RX_REFILL);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_RX_REFILL | SAMPLE_RX_DEFERRED | SAMPLE_RX_LEND);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_RX_REFILL | SAMPLE_RX_DEFERRED | SAMPLE_RX_BUDGET);
+    rc |= axis_dma_controller_sample_exec(1000, 20, 20, SAMPLE_RX_CYCLIC);
+    rc |= axis_dma_controller_sample_exec(1020, 99, 24, SAMPLE_RX_CYCLIC);
+    rc |= axis_dma_controller_sample_exec(1000, 20, 20, SAMPLE_RX_BLOCK);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 40, SAMPLE_RX_BLOCK | SAMPLE_RX_DEFERRED);
+    rc |= axis_dma_controller_sample_exec(1000, 1000, 20, SAMPLE_RX_BLOCK | SAMPLE_RX_NAPI);
+    rc |= axis_dma_controller_sample_exec(200, 2080, 38, SAMPLE_TRACE | SAMPLE_RX_DEFERRED);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_RECOVER | SAMPLE_TX_POOL);
+    rc |= axis_dma_controller_sample_exec(1000, 20, 20, SAMPLE_RECOVER | SAMPLE_RX_DEFERRED | SAMPLE_RX_LEND);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_RECOVER | SAMPLE_RECOVER_EOF);
+    rc |= axis_dma_controller_sample_exec(1000, 20, 20, SAMPLE_STALL);
+    rc |= axis_dma_controller_sample_exec(1020, 99, 24, SAMPLE_TX_PKT_CB);
+    rc |= axis_dma_controller_sample_exec(1000, 20, 20, SAMPLE_TX_PKT_CB | SAMPLE_RECOVER);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_TX_QUEUE);
+    rc |= axis_dma_controller_sample_exec(1000, 20, 20, SAMPLE_TX_QUEUE | SAMPLE_TX_PKT_CB);
+    rc |= axis_dma_controller_sample_exec(1020, 99, 24, SAMPLE_TX_QUEUE | SAMPLE_RX_DEFERRED);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_TX_PRIO);
+    rc |= axis_dma_controller_sample_exec(1000, 20, 20, SAMPLE_TX_PRIO | SAMPLE_TX_WEIGHTED);
+    rc |= axis_dma_controller_sample_exec(1020, 99, 24, SAMPLE_TX_PRIO | SAMPLE_TX_WEIGHTED | SAMPLE_RECOVER);
+    rc |= axis_dma_controller_sample_exec(1200, 2080, 38, SAMPLE_TX_PREPARED);
+    rc |= axis_dma_controller_sample_exec(1000, 20, 20, SAMPLE_TX_PREPARED | SAMPLE_TX_PKT_CB);
+    rc |= axis_dma_controller_sample_exec(1020, 99, 24, SAMPLE_TX_PREPARED | SAMPLE_TX_QUEUE | SAMPLE_RECOVER);
+#endif
 
     cleanup_platform();
-    return 0;
+    return rc ? 1 : 0;
 }
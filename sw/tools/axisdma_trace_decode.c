@@ -0,0 +1,142 @@
+/**
+ * @brief  Host side decoder for dumps written by axisDmaCtrl_traceDump.
+ *         Prints one line per event with the time since the first event,
+ *         followed by a per channel summary.
+ *
+ *         usage: axisdma_trace_decode <dump.bin>
+ *
+ * @author gutelfuldead@github.com
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "axis_dma_trace.h"
+
+/* bd status word, see the AXI DMA product guide (PG021) */
+#define BD_STS_COMPLETE 0x80000000U
+#define BD_STS_DEC_ERR  0x40000000U
+#define BD_STS_SLV_ERR  0x20000000U
+#define BD_STS_INT_ERR  0x10000000U
+#define BD_STS_RXSOF    0x08000000U
+#define BD_STS_RXEOF    0x04000000U
+
+/* channel status register irq bits */
+#define SR_IOC_IRQ 0x00001000U
+#define SR_DLY_IRQ 0x00002000U
+#define SR_ERR_IRQ 0x00004000U
+#define SR_HALTED  0x00000001U
+#define SR_IDLE    0x00000002U
+
+#define NUM_TYPES (AXISDMA_TRACE_STALL + 1)
+
+static const char *typeNames[NUM_TYPES] = {
+    "?", "submit", "tohw", "complete", "callback", "free", "error", "reset", "stall"
+};
+
+static void print_bd_sts(uint32_t sts)
+{
+    printf(" sts=0x%08x", sts);
+    if (sts & BD_STS_COMPLETE)
+        printf(" CMPLT");
+    if (sts & BD_STS_DEC_ERR)
+        printf(" DECERR");
+    if (sts & BD_STS_SLV_ERR)
+        printf(" SLVERR");
+    if (sts & BD_STS_INT_ERR)
+        printf(" INTERR");
+    if (sts & BD_STS_RXSOF)
+        printf(" SOF");
+    if (sts & BD_STS_RXEOF)
+        printf(" EOF");
+}
+
+static void print_sr(uint32_t sts)
+{
+    printf(" sr=0x%08x", sts);
+    if (sts & SR_HALTED)
+        printf(" HALTED");
+    if (sts & SR_IDLE)
+        printf(" IDLE");
+    if (sts & SR_IOC_IRQ)
+        printf(" IOC");
+    if (sts & SR_DLY_IRQ)
+        printf(" DLY");
+    if (sts & SR_ERR_IRQ)
+        printf(" ERR");
+}
+
+int main(int argc, char *argv[])
+{
+    struct axisDmaCtrl_traceHdr hdr;
+    struct axisDmaCtrl_traceEvt evt;
+    uint32_t counts[2][NUM_TYPES];
+    uint64_t t0 = 0;
+    uint32_t torn = 0;
+    uint32_t i;
+    FILE *f;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <dump.bin>\n", argv[0]);
+        return 1;
+    }
+    f = fopen(argv[1], "rb");
+    if (f == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 || hdr.magic != AXISDMA_TRACE_MAGIC) {
+        fprintf(stderr, "%s: not an axis dma trace\n", argv[1]);
+        return 1;
+    }
+    if (hdr.version != AXISDMA_TRACE_VERSION || hdr.evt_size != sizeof(evt)) {
+        fprintf(stderr, "%s: trace version %u (event %u bytes), decoder expects %u (%u bytes)\n",
+            argv[1], hdr.version, hdr.evt_size, AXISDMA_TRACE_VERSION, (unsigned int)sizeof(evt));
+        return 1;
+    }
+    if (hdr.counts_per_second == 0)
+        hdr.counts_per_second = 1;
+
+    printf("%u events, %u recorded, %u overwritten\n",
+        hdr.count, hdr.head, hdr.head - hdr.count);
+    printf("%8s %14s %2s %-8s %10s %10s %8s\n", "seq", "time us", "ch", "event", "bd", "buf", "len");
+
+    memset(counts, 0, sizeof(counts));
+    for (i = 0; i < hdr.count; i++) {
+        uint32_t expect = hdr.head - hdr.count + i + 1;
+
+        if (fread(&evt, sizeof(evt), 1, f) != 1) {
+            fprintf(stderr, "%s: truncated after %u events\n", argv[1], i);
+            break;
+        }
+        /* overwritten or still being written when the dump was taken */
+        if (evt.seq != expect || evt.type == 0 || evt.type >= NUM_TYPES || evt.chan > 1) {
+            printf("%8u %14s    (slot out of sequence)\n", expect, "-");
+            torn++;
+            continue;
+        }
+        if (t0 == 0)
+            t0 = evt.ts;
+        counts[evt.chan][evt.type]++;
+
+        printf("%8u %14.3f %2s %-8s 0x%08x 0x%08x %8u",
+            evt.seq, (double)(evt.ts - t0) * 1e6 / (double)hdr.counts_per_second,
+            evt.chan == AXISDMA_TRACE_TX ? "tx" : "rx", typeNames[evt.type],
+            evt.bd, evt.buf, evt.len);
+        if ((evt.type == AXISDMA_TRACE_ERROR && evt.bd == 0 && evt.buf == 0) ||
+            evt.type == AXISDMA_TRACE_STALL)
+            print_sr(evt.sts);
+        else if (evt.type == AXISDMA_TRACE_COMPLETE || evt.type == AXISDMA_TRACE_ERROR)
+            print_bd_sts(evt.sts);
+        printf("\n");
+    }
+    fclose(f);
+
+    printf("\n%-8s %10s %10s\n", "event", "tx", "rx");
+    for (i = 1; i < NUM_TYPES; i++)
+        printf("%-8s %10u %10u\n", typeNames[i], counts[0][i], counts[1][i]);
+    if (torn)
+        printf("%u slots out of sequence\n", torn);
+
+    return 0;
+}